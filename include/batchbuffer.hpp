@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "params.hpp"
+#include "utils.hpp"
+
+namespace TFHEpp {
+
+// Storage for the batch entry points that take a runtime count instead of
+// an int batch template parameter.
+template <class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, 64>>;
+
+// A view of TRLWE in the layout of TRLWEn: polynomial k of lane j is
+// plane[k][j], and each plane holds consecutive lanes.
+template <class P, class Poly = Polynomial<P>>
+struct TRLWEPlanes {
+    std::array<Poly *, P::k + 1> plane{};
+
+    TRLWEPlanes() = default;
+    // Writable planes are also readable ones.
+    template <class Q, std::enable_if_t<std::is_convertible_v<Q *, Poly *>,
+                                        std::nullptr_t> = nullptr>
+    TRLWEPlanes(const TRLWEPlanes<P, Q> &other)
+    {
+        for (int k = 0; k < P::k + 1; k++) plane[k] = other.plane[k];
+    }
+
+    Poly *operator[](int k) const { return plane[k]; }
+
+    // The lanes from first on.
+    TRLWEPlanes from(size_t first) const
+    {
+        TRLWEPlanes res;
+        for (int k = 0; k < P::k + 1; k++) res.plane[k] = plane[k] + first;
+        return res;
+    }
+};
+
+template <class P>
+using ConstTRLWEPlanes = TRLWEPlanes<P, const Polynomial<P>>;
+
+template <class P, int batch>
+TRLWEPlanes<P> planes(TRLWEn<P, batch> &trlwe)
+{
+    TRLWEPlanes<P> res;
+    for (int k = 0; k < P::k + 1; k++) res.plane[k] = trlwe[k].data();
+    return res;
+}
+
+template <class P, int batch>
+ConstTRLWEPlanes<P> planes(const TRLWEn<P, batch> &trlwe)
+{
+    ConstTRLWEPlanes<P> res;
+    for (int k = 0; k < P::k + 1; k++) res.plane[k] = trlwe[k].data();
+    return res;
+}
+
+// count TRLWE stored plane by plane from data, as in TRLWEBatch.
+template <class P>
+TRLWEPlanes<P> planes(Polynomial<P> *data, size_t count)
+{
+    TRLWEPlanes<P> res;
+    for (int k = 0; k < P::k + 1; k++) res.plane[k] = data + k * count;
+    return res;
+}
+
+namespace detail {
+inline std::atomic<size_t> workspace_allocations{0};
+inline std::atomic<size_t> workspace_bytes{0};
+}  // namespace detail
+
+// Blocks allocated by all Workspaces so far, and the bytes they hold now.
+inline size_t WorkspaceAllocations()
+{
+    return detail::workspace_allocations.load(std::memory_order_relaxed);
+}
+inline size_t WorkspaceBytes()
+{
+    return detail::workspace_bytes.load(std::memory_order_relaxed);
+}
+
+// Scratch memory of the batch hot loops, one per thread. Buffers are taken
+// inside nested WorkspaceFrames and given back when the frame closes, so
+// every bootstrapping reuses the same bytes. A buffer that does not fit
+// opens another block; once the outermost frame closes the blocks are
+// merged into one of their total size. After the first call at a given
+// batch size nothing is allocated any more.
+class Workspace {
+    struct Block {
+        std::byte *data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t current = 0, top = 0, depth = 0;
+
+    static constexpr size_t alignment = 64;
+
+    void add(size_t size)
+    {
+        // aligned_alloc may return null for 0 bytes.
+        size = (std::max<size_t>(size, 1) + alignment - 1) / alignment *
+               alignment;
+        std::byte *const data =
+            static_cast<std::byte *>(std::aligned_alloc(alignment, size));
+        if (data == nullptr) throw std::bad_alloc();
+        blocks.push_back({data, size});
+        detail::workspace_allocations.fetch_add(1, std::memory_order_relaxed);
+        detail::workspace_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void clear()
+    {
+        for (const Block &b : blocks) {
+            std::free(b.data);
+            detail::workspace_bytes.fetch_sub(b.size,
+                                              std::memory_order_relaxed);
+        }
+        blocks.clear();
+    }
+
+public:
+    Workspace() = default;
+    Workspace(const Workspace &) = delete;
+    Workspace &operator=(const Workspace &) = delete;
+    ~Workspace() { clear(); }
+
+    size_t capacity() const
+    {
+        size_t res = 0;
+        for (const Block &b : blocks) res += b.size;
+        return res;
+    }
+
+    // Uninitialised room for count T, valid until the enclosing frame
+    // closes.
+    template <class T>
+    T *take(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T> &&
+                      alignof(T) <= alignment);
+        const size_t bytes =
+            (count * sizeof(T) + alignment - 1) / alignment * alignment;
+        while (current < blocks.size() && top + bytes > blocks[current].size) {
+            current++;
+            top = 0;
+        }
+        if (current == blocks.size())
+            add(std::max(bytes, blocks.empty() ? 0 : blocks.back().size));
+        T *res = reinterpret_cast<T *>(blocks[current].data + top);
+        top += bytes;
+        return res;
+    }
+
+    friend class WorkspaceFrame;
+};
+
+inline Workspace &ThreadWorkspace()
+{
+    static thread_local Workspace ws;
+    return ws;
+}
+
+// Gives back everything taken from the workspace during its lifetime.
+class WorkspaceFrame {
+    Workspace &ws;
+    size_t current, top;
+
+public:
+    explicit WorkspaceFrame(Workspace &ws = ThreadWorkspace())
+        : ws(ws), current(ws.current), top(ws.top)
+    {
+        ws.depth++;
+    }
+    WorkspaceFrame(const WorkspaceFrame &) = delete;
+    WorkspaceFrame &operator=(const WorkspaceFrame &) = delete;
+    ~WorkspaceFrame()
+    {
+        ws.current = current;
+        ws.top = top;
+        if (--ws.depth == 0 && ws.blocks.size() > 1) {
+            const size_t total = ws.capacity();
+            ws.clear();
+            ws.add(total);
+        }
+    }
+
+    template <class T>
+    T *take(size_t count)
+    {
+        return ws.take<T>(count);
+    }
+    template <class P>
+    TRLWEPlanes<P> planes(size_t count)
+    {
+        return TFHEpp::planes<P>(take<Polynomial<P>>((P::k + 1) * count),
+                                 count);
+    }
+};
+
+// Heap-backed, 64-byte aligned storage for count TRLWE in the same layout.
+// Resizing does not keep the contents and never shrinks the allocation.
+template <class P>
+class TRLWEBatch {
+    AlignedVector<Polynomial<P>> data;
+    size_t count = 0;
+
+public:
+    TRLWEBatch() = default;
+    explicit TRLWEBatch(size_t count) { resize(count); }
+
+    void resize(size_t n)
+    {
+        count = n;
+        if (data.size() < (P::k + 1) * n) data.resize((P::k + 1) * n);
+    }
+    size_t size() const { return count; }
+
+    TRLWEPlanes<P> planes() { return TFHEpp::planes<P>(data.data(), count); }
+};
+
+// One TRGSWFFT per lane. Component m of row i of lane j is at(i, m)[j], so
+// the batch external product reads each row as one stream.
+template <class P>
+class TRGSWFFTBatch {
+    AlignedVector<PolynomialInFD<P>> data;
+    size_t count = 0;
+
+public:
+    static constexpr int rows = (P::k + 1) * P::l;
+
+    TRGSWFFTBatch() = default;
+    explicit TRGSWFFTBatch(size_t count) { resize(count); }
+
+    void resize(size_t n)
+    {
+        count = n;
+        if (data.size() < rows * (P::k + 1) * n)
+            data.resize(rows * (P::k + 1) * n);
+    }
+    size_t size() const { return count; }
+
+    PolynomialInFD<P> *at(int i, int m)
+    {
+        return data.data() + (i * (P::k + 1) + m) * count;
+    }
+    const PolynomialInFD<P> *at(int i, int m) const
+    {
+        return data.data() + (i * (P::k + 1) + m) * count;
+    }
+
+    void set(size_t j, const TRGSWFFT<P> &trgswfft)
+    {
+        for (int i = 0; i < rows; i++)
+            for (int m = 0; m < P::k + 1; m++) at(i, m)[j] = trgswfft[i][m];
+    }
+};
+
+}  // namespace TFHEpp
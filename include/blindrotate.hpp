@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "cloudkey.hpp"
 #include "detwfa.hpp"
 #include "keyswitch.hpp"
@@ -11,11 +16,26 @@
 
 namespace TFHEpp {
 
+// Rotation of the accumulator for a coefficient of the TLWE.
 template <class P, uint32_t num_out = 1>
-void BlindRotate(TRLWE<typename P::targetP> &res,
-                 const TLWE<typename P::domainP> &tlwe,
-                 const BootstrappingKeyFFT<P> &bkfft,
-                 const Polynomial<typename P::targetP> &testvector)
+uint32_t BlindRotateRotation(const typename P::domainP::T a)
+{
+    constexpr uint32_t bitwidth = bits_needed<num_out - 1>();
+    constexpr typename P::domainP::T roundoffset =
+        1ULL << (std::numeric_limits<typename P::domainP::T>::digits - 2 -
+                 P::targetP::nbit + bitwidth);
+    return (a + roundoffset) >>
+               (std::numeric_limits<typename P::domainP::T>::digits - 1 -
+                P::targetP::nbit + bitwidth)
+           << bitwidth;
+}
+
+// BK is BootstrappingKeyFFT<P> or BootstrappingKeyNTT<P>. An FFT key
+// unrolled over Addends > 1 coefficients takes them Addends at a time.
+template <class P, uint32_t num_out = 1, class BK>
+void BlindRotateImpl(TRLWE<typename P::targetP> &res,
+                     const TLWE<typename P::domainP> &tlwe, const BK &bk,
+                     const Polynomial<typename P::targetP> &testvector)
 {
     //cout << "b " ;
     constexpr uint32_t bitwidth = bits_needed<num_out - 1>();
@@ -27,32 +47,66 @@ void BlindRotate(TRLWE<typename P::targetP> &res,
     res = {};
     PolynomialMulByXai<typename P::targetP>(res[P::targetP::k], testvector, bLong);
 
-    for (int i = 0; i < P::domainP::k * P::domainP::n; i++) {
-        constexpr typename P::domainP::T roundoffset =
-            1ULL << (std::numeric_limits<typename P::domainP::T>::digits - 2 -
-                     P::targetP::nbit + bitwidth);
-        const uint32_t aLong =
-            (tlwe[i] + roundoffset) >>
-            (std::numeric_limits<typename P::domainP::T>::digits - 1 -
-             P::targetP::nbit + bitwidth)
-                << bitwidth;
-        //cout << " along " << aLong << " ";
-        if (aLong == 0) continue;
-        // Do not use CMUXFFT to avoid unnecessary copy.
-        CMUXFFTwithPolynomialMulByXaiMinusOne<P>(res, bkfft[i], aLong);
+    if constexpr (P::Addends > 1) {
+        static_assert(std::is_same_v<BK, BootstrappingKeyFFT<P>>,
+                      "Only the FFT bootstrapping key is unrolled!");
+        for (int i = 0; i < P::domainP::k * P::domainP::n / P::Addends; i++) {
+            int aLong[P::Addends];
+            bool zero = true;
+            for (int r = 0; r < P::Addends; r++) {
+                aLong[r] = BlindRotateRotation<P, num_out>(
+                    tlwe[i * P::Addends + r]);
+                zero = zero && aLong[r] == 0;
+            }
+            if (zero) continue;
+            CMUXFFTwithPolynomialMulByXaiMinusOneUnrolled<P>(res, bk[i], aLong);
+        }
     }
+    else
+        for (int i = 0; i < P::domainP::k * P::domainP::n; i++) {
+            const uint32_t aLong = BlindRotateRotation<P, num_out>(tlwe[i]);
+            //cout << " along " << aLong << " ";
+            if (aLong == 0) continue;
+            // Do not use CMUXFFT to avoid unnecessary copy.
+            if constexpr (std::is_same_v<BK, BootstrappingKeyNTT<P>>)
+                CMUXNTTwithPolynomialMulByXaiMinusOne<P>(res, bk[i], aLong);
+            else
+                CMUXFFTwithPolynomialMulByXaiMinusOne<P>(res, bk[i], aLong);
+        }
 }
 
-
-template <class P, int batch, uint32_t num_out = 1>
-void BlindRotatebatch(TRLWEn<typename P::targetP, batch> &res,
-                 const TLWEn<typename P::domainP, batch> &tlwe,
+template <class P, uint32_t num_out = 1>
+void BlindRotate(TRLWE<typename P::targetP> &res,
+                 const TLWE<typename P::domainP> &tlwe,
                  const BootstrappingKeyFFT<P> &bkfft,
                  const Polynomial<typename P::targetP> &testvector)
 {
-    res = {};
+    BlindRotateImpl<P, num_out>(res, tlwe, bkfft, testvector);
+}
+
+template <class P, uint32_t num_out = 1>
+void BlindRotate(TRLWE<typename P::targetP> &res,
+                 const TLWE<typename P::domainP> &tlwe,
+                 const BootstrappingKeyNTT<P> &bkntt,
+                 const Polynomial<typename P::targetP> &testvector)
+{
+    static_assert(P::Addends == 1, "The NTT bootstrapping key is not unrolled!");
+    BlindRotateImpl<P, num_out>(res, tlwe, bkntt, testvector);
+}
+
+
+// One tile of BlindRotatebatch.
+template <class P, uint32_t num_out = 1>
+void BlindRotatetile(TRLWEPlanes<typename P::targetP> res,
+                     const TLWE<typename P::domainP> *tlwe,
+                     const BootstrappingKeyFFT<P> &bkfft,
+                     const Polynomial<typename P::targetP> &testvector,
+                     size_t batch)
+{
+    for (int k = 0; k < P::targetP::k; k++)
+        std::fill_n(res[k], batch, Polynomial<typename P::targetP>{});
     constexpr uint32_t bitwidth = bits_needed<num_out - 1>();
-    for (int j = 0; j < batch; j++) {
+    for (size_t j = 0; j < batch; j++) {
         const uint32_t bLong =
             2 * P::targetP::n -
             ((tlwe[j][P::domainP::k * P::domainP::n] >>
@@ -63,21 +117,176 @@ void BlindRotatebatch(TRLWEn<typename P::targetP, batch> &res,
         PolynomialMulByXai<typename P::targetP>(res[P::targetP::k][j], testvector,
                                                 bLong);
     }
-    for (int i = 0; i < P::domainP::k * P::domainP::n; i++) {
-        intArray<batch> aLongArray;
-        for (int j = 0; j < batch; j++) {
-            constexpr typename P::domainP::T roundoffset =
-                1ULL << (std::numeric_limits<typename P::domainP::T>::digits -
-                         2 - P::targetP::nbit + bitwidth);
-            aLongArray[j] =
-                (tlwe[j][i] + roundoffset) >>
-                (std::numeric_limits<typename P::domainP::T>::digits - 1 -
-                 P::targetP::nbit + bitwidth)
-                    << bitwidth;
-        }
+    WorkspaceFrame frame;
+    // Rotation of coefficient r of a step for lane j at r * batch + j.
+    int *const aLongArray = frame.take<int>(P::Addends * batch);
+    constexpr int steps = P::domainP::k * P::domainP::n / P::Addends;
+    for (int i = 0; i < steps; i++) {
+        for (int r = 0; r < P::Addends; r++)
+            for (size_t j = 0; j < batch; j++)
+                aLongArray[r * batch + j] = BlindRotateRotation<P, num_out>(
+                    tlwe[j][i * P::Addends + r]);
         // Do not use CMUXFFT to avoid unnecessary copy.
-        CMUXFFTwithPolynomialMulByXaiMinusOnebatch<P, batch>(res, bkfft[i], aLongArray);
+        const BootstrappingKeyElementFFT<P> *next =
+            i + 1 < steps ? &bkfft[i + 1] : nullptr;
+        if constexpr (P::Addends > 1)
+            CMUXFFTwithPolynomialMulByXaiMinusOneUnrolledbatch<P>(
+                res, bkfft[i], aLongArray, batch, next);
+        else
+            CMUXFFTwithPolynomialMulByXaiMinusOnebatch<P>(
+                res, bkfft[i], aLongArray, batch, next);
     }
 }
 
+namespace detail {
+inline std::atomic<size_t> blindrotate_tile{0};
+}  // namespace detail
+
+// Lanes per tile of BlindRotatebatch; 0, the default, picks it from the L2
+// size.
+inline void SetBlindRotateTile(size_t lanes)
+{
+    detail::blindrotate_tile.store(lanes, std::memory_order_relaxed);
+}
+
+// BlindRotatebatch runs all n CMUX steps on one tile of lanes before the
+// next tile, so the accumulators and the external product workspace of a
+// tile stay in L2 and each key element is read from memory once per tile.
+// The automatic tile is the largest that fits in half of L2, the rest
+// being left to the FFT tables and the inputs, beside two key elements,
+// the current one and the prefetched next. It is then evened out over the
+// batch. An offload FFT engine gets the whole batch instead.
+template <class P>
+size_t BlindRotateTile(size_t batch)
+{
+    using Q = typename P::targetP;
+    if (batch == 0) return 1;
+    size_t tile = detail::blindrotate_tile.load(std::memory_order_relaxed);
+    if (tile == 0 && fftbackend<Q>().offload()) tile = batch;
+    if (tile == 0) {
+        // acc, temp, digits of one component, digit spectra and the
+        // product spectra
+        constexpr size_t lane = 2 * sizeof(TRLWE<Q>) +
+                                Q::l * sizeof(Polynomial<Q>) +
+                                Q::l * sizeof(TRLWEInFD<Q>) +
+                                sizeof(TRLWEInFD<Q>);
+        constexpr size_t key = 2 * sizeof(BootstrappingKeyElementFFT<P>);
+        const size_t l2 = L2CacheSize() / 2;
+        tile = l2 > key + lane ? (l2 - key) / lane : 1;
+    }
+    tile = std::clamp<size_t>(tile, 1, batch);
+    const size_t tiles = (batch + tile - 1) / tile;
+    return (batch + tiles - 1) / tiles;
+}
+
+// The lanes of one worker, tile by tile.
+template <class P, uint32_t num_out = 1>
+void BlindRotateslice(TRLWEPlanes<typename P::targetP> res,
+                      const TLWE<typename P::domainP> *tlwe,
+                      const BootstrappingKeyFFT<P> &bkfft,
+                      const Polynomial<typename P::targetP> &testvector,
+                      size_t batch)
+{
+    const size_t tile = BlindRotateTile<P>(batch);
+    for (size_t first = 0; first < batch; first += tile)
+        BlindRotatetile<P, num_out>(res.from(first), tlwe + first, bkfft,
+                                    testvector, std::min(tile, batch - first));
+}
+
+namespace detail {
+inline std::atomic<size_t> batch_threads{0};
+}  // namespace detail
+
+// Workers of the batch bootstrapping functions; 0, the default, is the
+// OpenMP default. Without OpenMP there is always one.
+inline void SetBatchThreads(size_t threads)
+{
+    detail::batch_threads.store(threads, std::memory_order_relaxed);
+}
+
+// An offload FFT engine serialises its callers, so by default it is fed
+// from one thread.
+template <class P>
+size_t BatchThreads(size_t batch)
+{
+    size_t threads = detail::batch_threads.load(std::memory_order_relaxed);
+    if (threads == 0) {
+        if (fftbackend<typename P::targetP>().offload()) return 1;
+#ifdef _OPENMP
+        threads = omp_get_max_threads();
+#else
+        threads = 1;
+#endif
+    }
+    return std::clamp<size_t>(threads, 1, std::max<size_t>(batch, 1));
+}
+
+// Calls fn(first, count) on threads contiguous slices of the batch lanes,
+// one per OpenMP thread. Workers run on the FFT engine of the caller. Their
+// thread_local workspaces are allocated, and so first touched, by the
+// worker itself, which keeps them on its NUMA node; read-only data such as
+// the bootstrapping key is shared.
+// The batch transforms of the CPU FFT engines are OpenMP loops of their
+// own. Each worker runs them with a team of one, so that threads is the
+// number of cores used, one worker included.
+template <class Fn>
+void ParallelLanes(size_t batch, size_t threads, Fn &&fn)
+{
+    const FFTEngine *engine = &CurrentFFTEngine();
+    const auto worker = [&](size_t first, size_t count) {
+#ifdef _OPENMP
+        const int fftthreads = omp_get_max_threads();
+        omp_set_num_threads(1);
+#endif
+        const FFTEngine *caller = detail::thread_fftengine;
+        detail::thread_fftengine = engine;
+        if (count > 0) fn(first, count);
+        detail::thread_fftengine = caller;
+#ifdef _OPENMP
+        omp_set_num_threads(fftthreads);
+#endif
+    };
+    if (threads <= 1) {
+        worker(size_t{0}, batch);
+        return;
+    }
+#pragma omp parallel num_threads(threads)
+    {
+#ifdef _OPENMP
+        const size_t t = omp_get_thread_num();
+        const size_t nt = omp_get_num_threads();
+#else
+        const size_t t = 0, nt = 1;
+#endif
+        const size_t first = batch * t / nt;
+        worker(first, batch * (t + 1) / nt - first);
+    }
+}
+
+// batch TLWE at tlwe, results as planes in res.
+template <class P, uint32_t num_out = 1>
+void BlindRotatebatch(TRLWEPlanes<typename P::targetP> res,
+                      const TLWE<typename P::domainP> *tlwe,
+                      const BootstrappingKeyFFT<P> &bkfft,
+                      const Polynomial<typename P::targetP> &testvector,
+                      size_t batch)
+{
+    ParallelLanes(batch, BatchThreads<P>(batch),
+                  [&](size_t first, size_t count) {
+                      BlindRotateslice<P, num_out>(res.from(first),
+                                                   tlwe + first, bkfft,
+                                                   testvector, count);
+                  });
+}
+
+template <class P, int batch, uint32_t num_out = 1>
+void BlindRotatebatch(TRLWEn<typename P::targetP, batch> &res,
+                 const TLWEn<typename P::domainP, batch> &tlwe,
+                 const BootstrappingKeyFFT<P> &bkfft,
+                 const Polynomial<typename P::targetP> &testvector)
+{
+    BlindRotatebatch<P, num_out>(planes<typename P::targetP, batch>(res),
+                                 tlwe.data(), bkfft, testvector, batch);
+}
+
 }  // namespace TFHEpp
\ No newline at end of file
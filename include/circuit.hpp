@@ -0,0 +1,185 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "cloudkey.hpp"
+#include "gate.hpp"
+
+namespace TFHEpp {
+
+// A boolean circuit of two-input gates. Nodes are added in topological
+// order: the operands of a node are wires returned earlier.
+class Circuit {
+public:
+    using Wire = uint32_t;
+    enum class Kind : uint8_t { Input, Constant, Not, Gate };
+    struct Node {
+        Kind kind;
+        GateOp op;   // Gate
+        bool value;  // Constant
+        Wire a, b;   // Not reads a, Gate reads a and b
+    };
+
+    Wire input();
+    Wire constant(bool value);
+    Wire NOT(Wire a);
+    Wire gate(GateOp op, Wire a, Wire b);
+    void output(Wire w) { outs.push_back(w); }
+
+    const std::vector<Node> &nodes() const { return node; }
+    const std::vector<Wire> &inputs() const { return ins; }
+    const std::vector<Wire> &outputs() const { return outs; }
+    // Only Gate nodes cost a bootstrapping.
+    size_t bootstraps() const;
+
+    // Plaintext evaluation, for checking encrypted results.
+    std::vector<uint8_t> evaluate(const std::vector<uint8_t> &in) const;
+
+private:
+    std::vector<Node> node;
+    std::vector<Wire> ins, outs;
+};
+
+// Reads a combinational BLIF model (.inputs, .outputs, .names and the Yosys
+// internal cells $_NOT_, $_BUF_, $_AND_, $_NAND_, $_OR_, $_NOR_, $_XOR_,
+// $_XNOR_, $_ANDNOT_, $_ORNOT_, $_MUX_ in .subckt or .gate lines). .names
+// covers of up to two inputs are mapped to a gate, NOT, copy or constant;
+// $_MUX_ becomes three gates. Returns false and leaves res unspecified on
+// anything else, including latches and cycles.
+bool ReadBLIF(Circuit &res, std::istream &is);
+
+// Bootstrap counts before and after OptimizeCircuit, and how many gates
+// each rewrite applied to.
+struct CircuitOptimizeReport {
+    size_t before, after;
+    // Gates with a constant or repeated operand, or that reduce to a
+    // constant, a copy or a NOT of one operand.
+    size_t folded;
+    // NOT operands turned into the sign of the operand in the gate.
+    size_t absorbed;
+    // Gates computed directly from the operands of an operand gate, when
+    // the pair depends on two wires only.
+    size_t merged;
+    // Gates equal to an earlier one.
+    size_t shared;
+    // Gates no output depends on.
+    size_t removed;
+};
+
+// An equivalent circuit with the same inputs and outputs and no more
+// bootstraps. NOT is only kept in front of outputs: elsewhere it is
+// absorbed into the gates that read it, since every GateOp with a negated
+// operand is another GateOp. XOR is not linear in the gate encoding and
+// is kept as a gate.
+Circuit OptimizeCircuit(const Circuit &circuit,
+                        CircuitOptimizeReport *report = nullptr);
+
+// The levels of a circuit and the ciphertext buffer of every node. A gate
+// is on level 1 + the level of its deepest operand; inputs, constants and
+// NOT are on the level of their operand since they cost no bootstrapping.
+// All gates of a level are independent and run as one batch.
+struct CircuitSchedule {
+    // gates[l] are the gates of level l (gates[0] is empty), and free[l]
+    // the other nodes of level l, evaluated after gates[l] in this order.
+    std::vector<std::vector<Circuit::Wire>> gates, free;
+    // Buffers are reused once every reader of their node has run.
+    std::vector<uint32_t> slot;
+    size_t slots = 0;
+    size_t width = 0;  // largest level
+
+    explicit CircuitSchedule(const Circuit &circuit);
+    size_t depth() const { return gates.size() - 1; }
+};
+
+struct CircuitLevelStats {
+    size_t gates;
+    double microseconds;
+};
+
+// Evaluates circuit on in (one TLWE per circuit input) into res (one per
+// output). Each level is a single HomMixedbatch. When stats is not null it
+// receives one entry per level, level 0 included.
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void EvalCircuit(std::vector<TLWE<typename brP::targetP>> &res,
+                 const Circuit &circuit, const CircuitSchedule &schedule,
+                 const std::vector<TLWE<typename iksP::domainP>> &in,
+                 const EvalKey &ek,
+                 std::vector<CircuitLevelStats> *stats = nullptr)
+{
+    using P = typename brP::targetP;
+    static_assert(std::is_same_v<P, typename iksP::domainP>,
+                  "gate outputs feed other gates");
+    using Kind = Circuit::Kind;
+    const std::vector<Circuit::Node> &node = circuit.nodes();
+
+    thread_local std::vector<TLWE<P>> buf, ca, cb;
+    thread_local std::vector<GateOp> ops;
+    buf.resize(schedule.slots);
+    ca.resize(schedule.width);
+    cb.resize(schedule.width);
+    ops.resize(schedule.width);
+    std::vector<size_t> inputindex(node.size());
+    for (size_t i = 0; i < circuit.inputs().size(); i++)
+        inputindex[circuit.inputs()[i]] = i;
+    if (stats) stats->clear();
+
+    for (size_t l = 0; l < schedule.gates.size(); l++) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<Circuit::Wire> &gates = schedule.gates[l];
+        for (size_t j = 0; j < gates.size(); j++) {
+            const Circuit::Node &g = node[gates[j]];
+            ops[j] = g.op;
+            ca[j] = buf[schedule.slot[g.a]];
+            cb[j] = buf[schedule.slot[g.b]];
+        }
+        if (!gates.empty())
+            HomMixedbatch<iksP, brP, mu>(ca.data(), ops.data(), ca.data(),
+                                         cb.data(), gates.size(), ek);
+        for (size_t j = 0; j < gates.size(); j++)
+            buf[schedule.slot[gates[j]]] = ca[j];
+
+        for (const Circuit::Wire w : schedule.free[l]) {
+            TLWE<P> &out = buf[schedule.slot[w]];
+            switch (node[w].kind) {
+            case Kind::Input: out = in[inputindex[w]]; break;
+            case Kind::Constant:
+                if (node[w].value)
+                    HomCONSTANTONE<P>(out);
+                else
+                    HomCONSTANTZERO<P>(out);
+                break;
+            case Kind::Not:
+                HomNOT<P>(out, buf[schedule.slot[node[w].a]]);
+                break;
+            case Kind::Gate: break;
+            }
+        }
+        if (stats) {
+            const auto end = std::chrono::steady_clock::now();
+            stats->push_back(
+                {gates.size(),
+                 std::chrono::duration<double, std::micro>(end - start)
+                     .count()});
+        }
+    }
+
+    res.resize(circuit.outputs().size());
+    for (size_t i = 0; i < res.size(); i++)
+        res[i] = buf[schedule.slot[circuit.outputs()[i]]];
+}
+
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void EvalCircuit(std::vector<TLWE<typename brP::targetP>> &res,
+                 const Circuit &circuit,
+                 const std::vector<TLWE<typename iksP::domainP>> &in,
+                 const EvalKey &ek)
+{
+    EvalCircuit<iksP, brP, mu>(res, circuit, CircuitSchedule(circuit), in, ek);
+}
+
+}  // namespace TFHEpp
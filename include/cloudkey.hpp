@@ -41,12 +41,54 @@ void bkgen(BootstrappingKey<P>& bk, const SecretKey& sk)
              sk.key.get<typename P::targetP>());
 }
 
+// Element i of the key covers the Addends coefficients from i * Addends.
+// It has one TRGSW per combination of their values other than all zero,
+// encrypting whether the coefficients take that combination. Combination t
+// gives coefficient r the value key_value_min + digit r of t in base
+// key_value_diff + 1. With one addend this is one TRGSW per nonzero key
+// value.
 template <class P>
 void bkfftgen(BootstrappingKeyFFT<P>& bkfft,
               const Key<typename P::domainP>& domainkey,
               const Key<typename P::targetP>& targetkey)
 {
-    //std::cout << std::endl << "l";
+    static_assert(P::domainP::k * P::domainP::n % P::Addends == 0,
+                  "Addends must divide the domain key length!");
+    constexpr int values = P::domainP::key_value_diff + 1;
+    Polynomial<typename P::targetP> plainpoly = {};
+    for (int i = 0; i < P::domainP::k * P::domainP::n / P::Addends; i++) {
+        int count = 0;
+        for (int t = 0; count < bkelements<P>(); t++) {
+            bool zero = true, match = true;
+            for (int r = 0, rest = t; r < P::Addends; r++, rest /= values) {
+                const int value = P::domainP::key_value_min + rest % values;
+                zero = zero && value == 0;
+                match = match &&
+                        static_cast<int>(static_cast<std::make_signed_t<
+                            typename P::domainP::T>>(
+                            domainkey[i * P::Addends + r])) == value;
+            }
+            if (zero) continue;
+            plainpoly[0] = match;
+            bkfft[i][count] =
+                trgswfftSymEncrypt<typename P::targetP>(plainpoly, targetkey);
+            count++;
+        }
+    }
+}
+
+template <class P>
+void bkfftgen(BootstrappingKeyFFT<P>& bkfft, const SecretKey& sk)
+{
+    bkfftgen<P>(bkfft, sk.key.get<typename P::domainP>(),
+                sk.key.get<typename P::targetP>());
+}
+
+template <class P>
+void bknttgen(BootstrappingKeyNTT<P>& bkntt,
+              const Key<typename P::domainP>& domainkey,
+              const Key<typename P::targetP>& targetkey)
+{
     Polynomial<typename P::targetP> plainpoly = {};
     for (int i = 0; i < P::domainP::k * P::domainP::n; i++) {
         int count = 0;
@@ -54,20 +96,19 @@ void bkfftgen(BootstrappingKeyFFT<P>& bkfft,
              j++) {
             if (j != 0) {
                 plainpoly[0] = domainkey[i] == j;
-                //std::cout << "p";
-                bkfft[i][count] = trgswfftSymEncrypt<typename P::targetP>(
-                    plainpoly, targetkey);
+                ApplyNTT2trgsw<typename P::targetP>(
+                    bkntt[i][count], trgswSymEncrypt<typename P::targetP>(
+                                         plainpoly, targetkey));
                 count++;
             }
         }
     }
-    //std::cout << "q" << std::endl;
 }
 
 template <class P>
-void bkfftgen(BootstrappingKeyFFT<P>& bkfft, const SecretKey& sk)
+void bknttgen(BootstrappingKeyNTT<P>& bkntt, const SecretKey& sk)
 {
-    bkfftgen<P>(bkfft, sk.key.get<typename P::domainP>(),
+    bknttgen<P>(bkntt, sk.key.get<typename P::domainP>(),
                 sk.key.get<typename P::targetP>());
 }
 
@@ -277,10 +318,10 @@ struct EvalKey {
     std::shared_ptr<BootstrappingKeyFFT<lvl02param>> bkfftlvl02;
     std::shared_ptr<BootstrappingKeyFFT<lvlh2param>> bkfftlvlh2;
     // BootstrappingKeyNTT
-    std::shared_ptr<BootstrappingKeyFFT<lvl01param>> bknttlvl01;
-    std::shared_ptr<BootstrappingKeyFFT<lvlh1param>> bknttlvlh1;
-    std::shared_ptr<BootstrappingKeyFFT<lvl02param>> bknttlvl02;
-    std::shared_ptr<BootstrappingKeyFFT<lvlh2param>> bknttlvlh2;
+    std::shared_ptr<BootstrappingKeyNTT<lvl01param>> bknttlvl01;
+    std::shared_ptr<BootstrappingKeyNTT<lvlh1param>> bknttlvlh1;
+    std::shared_ptr<BootstrappingKeyNTT<lvl02param>> bknttlvl02;
+    std::shared_ptr<BootstrappingKeyNTT<lvlh2param>> bknttlvlh2;
     // KeySwitchingKey
     std::shared_ptr<KeySwitchingKey<lvl10param>> iksklvl10;
     std::shared_ptr<KeySwitchingKey<lvl1hparam>> iksklvl1h;
@@ -373,6 +414,33 @@ struct EvalKey {
             static_assert(false_v<typename P::T>, "Not predefined parameter!");
     }
 
+    template <class P>
+    void emplacebkntt(const SecretKey& sk)
+    {
+        if constexpr (std::is_same_v<P, lvl01param>) {
+            bknttlvl01 = std::unique_ptr<BootstrappingKeyNTT<lvl01param>>(
+                new (std::align_val_t(64)) BootstrappingKeyNTT<lvl01param>());
+            bknttgen<lvl01param>(*bknttlvl01, sk);
+        }
+        else if constexpr (std::is_same_v<P, lvlh1param>) {
+            bknttlvlh1 = std::unique_ptr<BootstrappingKeyNTT<lvlh1param>>(
+                new (std::align_val_t(64)) BootstrappingKeyNTT<lvlh1param>());
+            bknttgen<lvlh1param>(*bknttlvlh1, sk);
+        }
+        else if constexpr (std::is_same_v<P, lvl02param>) {
+            bknttlvl02 = std::unique_ptr<BootstrappingKeyNTT<lvl02param>>(
+                new (std::align_val_t(64)) BootstrappingKeyNTT<lvl02param>());
+            bknttgen<lvl02param>(*bknttlvl02, sk);
+        }
+        else if constexpr (std::is_same_v<P, lvlh2param>) {
+            bknttlvlh2 = std::unique_ptr<BootstrappingKeyNTT<lvlh2param>>(
+                new (std::align_val_t(64)) BootstrappingKeyNTT<lvlh2param>());
+            bknttgen<lvlh2param>(*bknttlvlh2, sk);
+        }
+        else
+            static_assert(false_v<typename P::T>, "Not predefined parameter!");
+    }
+
     template <class P>
     void emplacebk2bkfft()
     {
@@ -567,6 +635,25 @@ struct EvalKey {
             static_assert(false_v<typename P::T>, "Not predefined parameter!");
     }
 
+    template <class P>
+    BootstrappingKeyNTT<P>& getbkntt() const
+    {
+        if constexpr (std::is_same_v<P, lvl01param>) {
+            return *bknttlvl01;
+        }
+        else if constexpr (std::is_same_v<P, lvlh1param>) {
+            return *bknttlvlh1;
+        }
+        else if constexpr (std::is_same_v<P, lvl02param>) {
+            return *bknttlvl02;
+        }
+        else if constexpr (std::is_same_v<P, lvlh2param>) {
+            return *bknttlvlh2;
+        }
+        else
+            static_assert(false_v<typename P::T>, "Not predefined parameter!");
+    }
+
     template <class P>
     KeySwitchingKey<P>& getiksk() const
     {
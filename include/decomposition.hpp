@@ -2,6 +2,12 @@
 
 #include <array>
 #include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "mulfft.hpp"
 #include "params.hpp"
@@ -46,11 +52,13 @@ constexpr typename P::T offsetgen()
     return offset;
 }
 
-template <class P>
-inline void Decomposition(DecomposedPolynomial<P> &decpoly,
-                          const Polynomial<P> &poly, typename P::T randbits = 0)
+// Digit ii of coefficient i of poly to digit[ii * stride + i], as Digit:
+// P::T like Decomposition, or the signed digit as int32_t or double. This is
+// the plain loop; DecompositionDigits is the same with vector kernels.
+template <class P, class Digit = typename P::T>
+inline void DecompositionDigitsScalar(Digit *digit, size_t stride,
+                                      const typename P::T *poly)
 {
-
     // lvl1 offset 0x82080000,         roundoffsetBit: 13, roundoffset: 0x2000,    totaloffset 0x82082000
     // lvl2 offset 0x8040201000000000, roundoffsetBit: 27, roundoffset: 0x8000000, totaloffset 0x8040201008000000
     constexpr typename P::T offset = offsetgen<P>();
@@ -71,14 +79,175 @@ inline void Decomposition(DecomposedPolynomial<P> &decpoly,
             auto digitsToShift = maxDigits - (ii + 1) * P::Bgbit;
             auto shiftedValue = valuePlusOffset >> digitsToShift;
             auto maskedValue = shiftedValue & mask;
-            decpoly[ii][i] = maskedValue - halfBg;
+            const typename P::T value = maskedValue - halfBg;
+            if constexpr (std::is_same_v<Digit, typename P::T>)
+                digit[ii * stride + i] = value;
+            else
+                digit[ii * stride + i] = static_cast<Digit>(
+                    static_cast<std::make_signed_t<typename P::T>>(value));
         }
     }
 }
 
-template <class P, int batch>
-inline void Decompositionbatch(DecomposedPolynomialn<P, batch> &decpoly,
-                          const Polynomialn<P, batch> &poly, typename P::T randbits = 0)
+// DecompositionDigitsScalar with AVX-512 or AVX2 kernels for 32 and 64-bit
+// torus when the compiler targets them. One vector of coefficients is
+// offset once and gives all l digits; signed digits are narrowed or
+// converted in register, so an int32_t or double consumer needs no pass of
+// its own.
+template <class P, class Digit = typename P::T>
+inline void DecompositionDigits(Digit *digit, size_t stride,
+                                const typename P::T *poly)
+{
+    static_assert(std::is_same_v<Digit, typename P::T> ||
+                      std::is_same_v<Digit, int32_t> ||
+                      std::is_same_v<Digit, double>,
+                  "Digits are P::T, int32_t or double");
+#if defined(__AVX512F__) || defined(__AVX2__)
+    using T = typename P::T;
+    constexpr T offset = offsetgen<P>();
+    constexpr uint32_t roundoffsetBit = std::numeric_limits<T>::digits - P::l * P::Bgbit - 1;
+    constexpr T totaloffset = offset + (T(1) << roundoffsetBit);
+    constexpr T mask = static_cast<T>((1ULL << P::Bgbit) - 1);
+    constexpr T halfBg = (1ULL << (P::Bgbit - 1));
+    constexpr uint32_t maxDigits = std::numeric_limits<T>::digits;
+    // Shift counts go in a register, so that the loop over digits need not
+    // be unrolled into immediates.
+    const auto count = [](int ii) {
+        return _mm_cvtsi32_si128(maxDigits - (ii + 1) * P::Bgbit);
+    };
+#endif
+#if defined(__AVX512F__)
+    if constexpr (std::is_same_v<T, uint32_t> && P::n % 16 == 0) {
+        const __m512i off = _mm512_set1_epi32(totaloffset);
+        const __m512i m = _mm512_set1_epi32(mask);
+        const __m512i h = _mm512_set1_epi32(halfBg);
+        for (int i = 0; i < P::n; i += 16) {
+            const __m512i v = _mm512_add_epi32(
+                _mm512_loadu_si512(reinterpret_cast<const void *>(poly + i)),
+                off);
+            for (int ii = 0; ii < P::l; ii++) {
+                const __m512i d = _mm512_sub_epi32(
+                    _mm512_and_si512(_mm512_srl_epi32(v, count(ii)), m), h);
+                Digit *out = digit + ii * stride + i;
+                if constexpr (std::is_same_v<Digit, double>) {
+                    _mm512_storeu_pd(out,
+                                     _mm512_cvtepi32_pd(_mm512_castsi512_si256(d)));
+                    _mm512_storeu_pd(
+                        out + 8, _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(d, 1)));
+                }
+                else
+                    _mm512_storeu_si512(reinterpret_cast<void *>(out), d);
+            }
+        }
+        return;
+    }
+    else if constexpr (std::is_same_v<T, uint64_t> && P::n % 8 == 0) {
+        const __m512i off = _mm512_set1_epi64(totaloffset);
+        const __m512i m = _mm512_set1_epi64(mask);
+        const __m512i h = _mm512_set1_epi64(halfBg);
+        for (int i = 0; i < P::n; i += 8) {
+            const __m512i v = _mm512_add_epi64(
+                _mm512_loadu_si512(reinterpret_cast<const void *>(poly + i)),
+                off);
+            for (int ii = 0; ii < P::l; ii++) {
+                const __m512i d = _mm512_sub_epi64(
+                    _mm512_and_si512(_mm512_srl_epi64(v, count(ii)), m), h);
+                Digit *out = digit + ii * stride + i;
+                if constexpr (std::is_same_v<Digit, T>)
+                    _mm512_storeu_si512(reinterpret_cast<void *>(out), d);
+                else if constexpr (std::is_same_v<Digit, int32_t>)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                                        _mm512_cvtepi64_epi32(d));
+                else
+                    _mm512_storeu_pd(
+                        out, _mm512_cvtepi32_pd(_mm512_cvtepi64_epi32(d)));
+            }
+        }
+        return;
+    }
+#elif defined(__AVX2__)
+    if constexpr (std::is_same_v<T, uint32_t> && P::n % 8 == 0) {
+        const __m256i off = _mm256_set1_epi32(totaloffset);
+        const __m256i m = _mm256_set1_epi32(mask);
+        const __m256i h = _mm256_set1_epi32(halfBg);
+        for (int i = 0; i < P::n; i += 8) {
+            const __m256i v = _mm256_add_epi32(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(poly + i)),
+                off);
+            for (int ii = 0; ii < P::l; ii++) {
+                const __m256i d = _mm256_sub_epi32(
+                    _mm256_and_si256(_mm256_srl_epi32(v, count(ii)), m), h);
+                Digit *out = digit + ii * stride + i;
+                if constexpr (std::is_same_v<Digit, double>) {
+                    _mm256_storeu_pd(out,
+                                     _mm256_cvtepi32_pd(_mm256_castsi256_si128(d)));
+                    _mm256_storeu_pd(
+                        out + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)));
+                }
+                else
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), d);
+            }
+        }
+        return;
+    }
+    else if constexpr (std::is_same_v<T, uint64_t> && P::n % 4 == 0) {
+        const __m256i off = _mm256_set1_epi64x(totaloffset);
+        const __m256i m = _mm256_set1_epi64x(mask);
+        const __m256i h = _mm256_set1_epi64x(halfBg);
+        // The low halves of the four lanes, to narrow them to int32_t.
+        const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+        for (int i = 0; i < P::n; i += 4) {
+            const __m256i v = _mm256_add_epi64(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(poly + i)),
+                off);
+            for (int ii = 0; ii < P::l; ii++) {
+                const __m256i d = _mm256_sub_epi64(
+                    _mm256_and_si256(_mm256_srl_epi64(v, count(ii)), m), h);
+                Digit *out = digit + ii * stride + i;
+                if constexpr (std::is_same_v<Digit, T>)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), d);
+                else {
+                    const __m128i d32 = _mm256_castsi256_si128(
+                        _mm256_permutevar8x32_epi32(d, low));
+                    if constexpr (std::is_same_v<Digit, int32_t>)
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), d32);
+                    else
+                        _mm256_storeu_pd(out, _mm256_cvtepi32_pd(d32));
+                }
+            }
+        }
+        return;
+    }
+#endif
+    DecompositionDigitsScalar<P, Digit>(digit, stride, poly);
+}
+
+template <class P>
+inline void Decomposition(DecomposedPolynomial<P> &decpoly,
+                          const Polynomial<P> &poly, typename P::T randbits = 0)
+{
+    DecompositionDigits<P>(decpoly[0].data(), P::n, poly.data());
+}
+
+// decpoly holds P::l planes of batch polynomials: digit ii of lane j is
+// decpoly[ii * batch + j], the layout of DecomposedPolynomialn.
+template <class P>
+inline void Decompositionbatch(Polynomial<P> *decpoly, const Polynomial<P> *poly,
+                               size_t batch, typename P::T randbits = 0)
+{
+    for (size_t j = 0; j < batch; j++)
+        DecompositionDigits<P>(decpoly[j].data(), batch * P::n,
+                               poly[j].data());
+}
+
+// The digits of (X^a - 1) * poly, 0 <= a < 2N, equal to those of
+// PolynomialMulByXaiMinusOne followed by Decomposition. The rotated
+// difference of each coefficient goes straight to its digits instead of
+// through a temporary polynomial. Digit ii is written to digit[ii * stride].
+template <class P>
+inline void DecompositionMulByXaiMinusOne(Polynomial<P> *digit, size_t stride,
+                                          const Polynomial<P> &poly,
+                                          const typename P::T a)
 {
     constexpr typename P::T offset = offsetgen<P>();
     constexpr uint32_t roundoffsetBit = std::numeric_limits<typename P::T>::digits - P::l * P::Bgbit - 1;
@@ -89,16 +258,59 @@ inline void Decompositionbatch(DecomposedPolynomialn<P, batch> &decpoly,
     constexpr typename P::T halfBg = (1ULL << (P::Bgbit - 1));
     constexpr uint32_t maxDigits = std::numeric_limits<typename P::T>::digits;
 
-    for (int j = 0; j < batch; j++) {
-        for (int i = 0; i < P::n; i++) {
-            auto valuePlusOffset = poly[j][i] + totaloffset;
-            for (int ii = 0; ii < P::l; ii++) {
-                auto digitsToShift = maxDigits - (ii + 1) * P::Bgbit;
-                auto shiftedValue = valuePlusOffset >> digitsToShift;
-                auto maskedValue = shiftedValue & mask;
-                decpoly[ii][j][i] = maskedValue - halfBg;
-            }
-        }
+    // One pass per digit, each a plain stream of two input ranges into one
+    // output plane, so that it vectorises like Decomposition. The ranges go
+    // through their own base pointers; unsigned index arithmetic would keep
+    // the loads from being seen as contiguous.
+    const int shift = a < P::n ? a : a - P::n;
+    // Negation as (x ^ s) - s: the wrapped head is negated for a < N, the
+    // rest for a >= N.
+    const typename P::T tail = a < P::n ? 0 : ~typename P::T(0);
+    const typename P::T head = ~tail;
+    const typename P::T *in = poly.data();
+    const typename P::T *wrapped = in + (P::n - shift);
+    const typename P::T *rest = in + shift;
+    for (int ii = 0; ii < P::l; ii++) {
+        const uint32_t digitsToShift = maxDigits - (ii + 1) * P::Bgbit;
+        typename P::T *out = digit[ii * stride].data();
+#pragma omp simd
+        for (int i = 0; i < shift; i++)
+            out[i] = ((((wrapped[i] ^ head) - head - in[i] + totaloffset) >>
+                       digitsToShift) &
+                      mask) -
+                     halfBg;
+        out += shift;
+#pragma omp simd
+        for (int i = 0; i < P::n - shift; i++)
+            out[i] = ((((in[i] ^ tail) - tail - rest[i] + totaloffset) >>
+                       digitsToShift) &
+                      mask) -
+                     halfBg;
     }
 }
-}  // namespace TFHEpp
\ No newline at end of file
+
+template <class P>
+inline void DecompositionMulByXaiMinusOne(DecomposedPolynomial<P> &decpoly,
+                                          const Polynomial<P> &poly,
+                                          const typename P::T a)
+{
+    DecompositionMulByXaiMinusOne<P>(decpoly.data(), 1, poly, a);
+}
+
+// Lane j of poly rotated by a[j], digits in the layout of Decompositionbatch.
+template <class P>
+inline void DecompositionMulByXaiMinusOnebatch(Polynomial<P> *decpoly,
+                                               const Polynomial<P> *poly,
+                                               const int *a, size_t batch)
+{
+    for (size_t j = 0; j < batch; j++)
+        DecompositionMulByXaiMinusOne<P>(decpoly + j, batch, poly[j], a[j]);
+}
+
+template <class P, int batch>
+inline void Decompositionbatch(DecomposedPolynomialn<P, batch> &decpoly,
+                          const Polynomialn<P, batch> &poly, typename P::T randbits = 0)
+{
+    Decompositionbatch<P>(decpoly[0].data(), poly.data(), batch, randbits);
+}
+}  // namespace TFHEpp
@@ -39,12 +39,12 @@ void CMUXFFTwithPolynomialMulByXaiMinusOne(
     TRLWE<typename bkP::targetP> &acc,
     const BootstrappingKeyElementFFT<bkP> &cs, const int a)
 {
+    // The rotation is fused into the decomposition of the external
+    // product, so (X^a - 1) * acc is never stored.
     if constexpr (bkP::domainP::key_value_diff == 1) {
         alignas(64) TRLWE<typename bkP::targetP> temp;
-        for (int k = 0; k < bkP::targetP::k + 1; k++)
-            PolynomialMulByXaiMinusOne<typename bkP::targetP>(temp[k], acc[k],
-                                                              a);
-        trgswfftExternalProduct<typename bkP::targetP>(temp, temp, cs[0]);
+        trgswfftExternalProductMulByXaiMinusOne<typename bkP::targetP>(
+            temp, acc, a, cs[0]);
         for (int k = 0; k < bkP::targetP::k + 1; k++)
             for (int i = 0; i < bkP::targetP::n; i++) acc[k][i] += temp[k][i];
     }
@@ -56,11 +56,8 @@ void CMUXFFTwithPolynomialMulByXaiMinusOne(
             if (i != 0) {
                 const int mod = (a * i) % (2 * bkP::targetP::n);
                 const int index = mod > 0 ? mod : mod + (2 * bkP::targetP::n);
-                for (int k = 0; k < bkP::targetP::k + 1; k++)
-                    PolynomialMulByXaiMinusOne<typename bkP::targetP>(
-                        temp[k], acc[k], index);
-                trgswfftExternalProduct<typename bkP::targetP>(temp, temp,
-                                                               cs[count]);
+                trgswfftExternalProductMulByXaiMinusOne<
+                    typename bkP::targetP>(temp, acc, index, cs[count]);
                 for (int k = 0; k < bkP::targetP::k + 1; k++)
                     for (int n = 0; n < bkP::targetP::n; n++)
                         acc[k][n] += temp[k][n];
@@ -70,41 +67,115 @@ void CMUXFFTwithPolynomialMulByXaiMinusOne(
     }
 }
 
-template <class bkP, int batch>
-void CMUXFFTwithPolynomialMulByXaiMinusOnebatch(
-    TRLWEn<typename bkP::targetP, batch> &acc,
-    const BootstrappingKeyElementFFT<bkP> &cs, const intArray<batch> &aArray)
+// Rotations of the TRGSW of an unrolled key element, a[r * stride] being
+// the rotation of its coefficient r: the TRGSW of a combination of values,
+// in the order of bkfftgen, gets the sum of a[r] times the value of
+// coefficient r. That of TRGSW c is written to e[c * stride].
+template <class bkP>
+void UnrolledRotations(int *e, const int *a, size_t stride = 1)
 {
-    if constexpr (bkP::domainP::key_value_diff == 1) {
-        alignas(64) TRLWEn<typename bkP::targetP, batch> temp;
-        for (int j = 0; j < batch; j++)
+    constexpr int values = bkP::domainP::key_value_diff + 1;
+    constexpr int Nx2 = 2 * bkP::targetP::n;
+    int count = 0;
+    for (int t = 0; count < bkelements<bkP>(); t++) {
+        bool zero = true;
+        int sum = 0;
+        for (int r = 0, rest = t; r < bkP::Addends; r++, rest /= values) {
+            const int value = bkP::domainP::key_value_min + rest % values;
+            zero = zero && value == 0;
+            sum += a[r * stride] * value;
+        }
+        if (zero) continue;
+        const int mod = sum % Nx2;
+        e[count * stride] = mod >= 0 ? mod : mod + Nx2;
+        count++;
+    }
+}
+
+// The step of a blind rotation with a key unrolled over Addends
+// coefficients s[r], a[r] being their rotations: acc *= X^(sum of a[r]
+// s[r]), as acc += the sum over the TRGSW c of cs of (X^e[c] - 1) * acc
+// times cs[c], with e from UnrolledRotations. One external product per
+// step, its digits transformed once for all the TRGSW.
+template <class bkP>
+void CMUXFFTwithPolynomialMulByXaiMinusOneUnrolled(
+    TRLWE<typename bkP::targetP> &acc,
+    const BootstrappingKeyElementFFT<bkP> &cs, const int *a)
+{
+    using P = typename bkP::targetP;
+    constexpr int terms = bkelements<bkP>();
+    int e[terms];
+    const TRGSWFFT<P> *key[terms];
+    UnrolledRotations<bkP>(e, a);
+    for (int c = 0; c < terms; c++) key[c] = &cs[c];
+    alignas(64) TRLWE<P> temp;
+    trgswfftExternalProductMulByXaiMinusOneSum<P>(temp, acc, e, key, terms);
+    for (int k = 0; k < P::k + 1; k++)
+        for (int i = 0; i < P::n; i++) acc[k][i] += temp[k][i];
+}
+
+template <class bkP>
+void CMUXNTTwithPolynomialMulByXaiMinusOne(
+    TRLWE<typename bkP::targetP> &acc,
+    const BootstrappingKeyElementNTT<bkP> &cs, const int a)
+{
+    alignas(64) TRLWE<typename bkP::targetP> temp;
+    int count = 0;
+    for (int i = bkP::domainP::key_value_min; i <= bkP::domainP::key_value_max;
+         i++) {
+        if (i != 0) {
+            const int mod = (a * i) % (2 * bkP::targetP::n);
+            const int index = mod > 0 ? mod : mod + (2 * bkP::targetP::n);
             for (int k = 0; k < bkP::targetP::k + 1; k++)
-                PolynomialMulByXaiMinusOne<typename bkP::targetP>(temp[k][j], acc[k][j],
-                                                                  aArray[j]);
-        trgswfftExternalProductbatch<typename bkP::targetP, batch>(temp, temp, cs[0]);
-        for (int j = 0; j < batch; j++)
+                PolynomialMulByXaiMinusOne<typename bkP::targetP>(
+                    temp[k], acc[k], index);
+            trgswnttExternalProduct<typename bkP::targetP>(temp, temp,
+                                                           cs[count]);
             for (int k = 0; k < bkP::targetP::k + 1; k++)
-                for (int i = 0; i < bkP::targetP::n; i++) acc[k][j][i] += temp[k][j][i];
+                for (int n = 0; n < bkP::targetP::n; n++)
+                    acc[k][n] += temp[k][n];
+            count++;
+        }
+    }
+}
+
+// acc holds batch TRLWE as planes; lane j is rotated by aArray[j]. next is
+// the key element of the following step, prefetched during this one.
+template <class bkP>
+void CMUXFFTwithPolynomialMulByXaiMinusOnebatch(
+    TRLWEPlanes<typename bkP::targetP> acc,
+    const BootstrappingKeyElementFFT<bkP> &cs, const int *aArray,
+    size_t batch, const BootstrappingKeyElementFFT<bkP> *next = nullptr)
+{
+    using P = typename bkP::targetP;
+    WorkspaceFrame frame;
+    const TRLWEPlanes<P> temp = frame.planes<P>(batch);
+    if constexpr (bkP::domainP::key_value_diff == 1) {
+        trgswfftExternalProductMulByXaiMinusOnebatch<P>(
+            temp, acc, aArray, cs[0], batch, next ? &(*next)[0] : nullptr);
+        for (size_t j = 0; j < batch; j++)
+            for (int k = 0; k < P::k + 1; k++)
+                for (int i = 0; i < P::n; i++) acc[k][j][i] += temp[k][j][i];
     }
     else {
-        alignas(32) TRLWEn<typename bkP::targetP, batch> temp;
+        int *const index = frame.take<int>(batch);
         int count = 0;
         for (int i = bkP::domainP::key_value_min;
              i <= bkP::domainP::key_value_max; i++) {
             if (i != 0) {
-
-                for (int j = 0; j < batch; j++) {
-                    const int mod = (aArray[j] * i) % (2 * bkP::targetP::n);
-                    const int index = mod > 0 ? mod : mod + (2 * bkP::targetP::n);
-                    for (int k = 0; k < bkP::targetP::k + 1; k++)
-                        PolynomialMulByXaiMinusOne<typename bkP::targetP>(
-                            temp[k][j], acc[k][j], index);
+                for (size_t j = 0; j < batch; j++) {
+                    const int mod = (aArray[j] * i) % (2 * P::n);
+                    index[j] = mod > 0 ? mod : mod + (2 * P::n);
                 }
-                trgswfftExternalProductbatch<typename bkP::targetP, batch>(temp, temp,
-                                                               cs[count]);
-                for (int j = 0; j < batch; j++)
-                    for (int k = 0; k < bkP::targetP::k + 1; k++)
-                        for (int n = 0; n < bkP::targetP::n; n++)
+                const TRGSWFFT<P> *prefetch =
+                    count + 1 < static_cast<int>(cs.size()) ? &cs[count + 1]
+                    : next                                 ? &(*next)[0]
+                                                           : nullptr;
+                trgswfftExternalProductMulByXaiMinusOnebatch<P>(
+                    temp, acc, index, cs[count], batch, prefetch);
+                for (size_t j = 0; j < batch; j++)
+                    for (int k = 0; k < P::k + 1; k++)
+                        for (int n = 0; n < P::n; n++)
                             acc[k][j][n] += temp[k][j][n];
                 count++;
             }
@@ -112,5 +183,43 @@ void CMUXFFTwithPolynomialMulByXaiMinusOnebatch(
     }
 }
 
+// acc holds batch TRLWE as planes, and aArray[r * batch + j] is the
+// rotation of coefficient r for lane j, as
+// CMUXFFTwithPolynomialMulByXaiMinusOneUnrolled. next is the key element
+// of the following step, prefetched during this one.
+template <class bkP>
+void CMUXFFTwithPolynomialMulByXaiMinusOneUnrolledbatch(
+    TRLWEPlanes<typename bkP::targetP> acc,
+    const BootstrappingKeyElementFFT<bkP> &cs, const int *aArray,
+    size_t batch, const BootstrappingKeyElementFFT<bkP> *next = nullptr)
+{
+    using P = typename bkP::targetP;
+    constexpr int terms = bkelements<bkP>();
+    WorkspaceFrame frame;
+    const TRLWEPlanes<P> temp = frame.planes<P>(batch);
+    int *const e = frame.take<int>(terms * batch);
+    for (size_t j = 0; j < batch; j++)
+        UnrolledRotations<bkP>(e + j, aArray + j, batch);
+    const TRGSWFFT<P> *key[terms], *prefetch[terms];
+    for (int c = 0; c < terms; c++) {
+        key[c] = &cs[c];
+        prefetch[c] = next ? &(*next)[c] : nullptr;
+    }
+    trgswfftExternalProductMulByXaiMinusOneSumbatch<P>(
+        temp, acc, e, key, terms, batch, prefetch, next ? terms : 0);
+    for (size_t j = 0; j < batch; j++)
+        for (int k = 0; k < P::k + 1; k++)
+            for (int i = 0; i < P::n; i++) acc[k][j][i] += temp[k][j][i];
+}
+
+template <class bkP, int batch>
+void CMUXFFTwithPolynomialMulByXaiMinusOnebatch(
+    TRLWEn<typename bkP::targetP, batch> &acc,
+    const BootstrappingKeyElementFFT<bkP> &cs, const intArray<batch> &aArray)
+{
+    CMUXFFTwithPolynomialMulByXaiMinusOnebatch<bkP>(
+        planes<typename bkP::targetP, batch>(acc), cs, aArray.data(), batch);
+}
+
 
 }  // namespace TFHEpp
\ No newline at end of file
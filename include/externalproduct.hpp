@@ -3,104 +3,397 @@
 #include <array>
 #include <cstdint>
 #include "mulfft.hpp"
+#include "mulntt.hpp"
 #include "params.hpp"
 #include "trlwe.hpp"
+#include "batchbuffer.hpp"
 #include "decomposition.hpp"
 #include <iostream>
 
 namespace TFHEpp {
 
+// decompose(k, decpoly) writes the digits of component k of the TRLWE to
+// multiply, and mac(restrlwefft, decpolyfft) the frequency domain product
+// of the digit spectra. res is only written at the end, so it may be that
+// TRLWE.
+template <class P, class Decompose, class MAC>
+void trgswfftExternalProductMACImpl(TRLWE<P> &res, Decompose decompose,
+                                    MAC mac)
+{
+    // All digits first, then one multiply-accumulate pass over the spectra.
+    // An offload engine gets the digits in a single submission per product
+    // instead of one per digit. The batch calls of the CPU engines start an
+    // OpenMP team, which costs more than the few transforms of one product,
+    // so those go one digit at a time.
+    constexpr int digits = (P::k + 1) * P::l;
+    WorkspaceFrame frame;
+    DecomposedPolynomial<P> *const decpoly =
+        frame.take<DecomposedPolynomial<P>>(P::k + 1);
+    PolynomialInFD<P> *const decpolyfft = frame.take<PolynomialInFD<P>>(digits);
+    for (int k = 0; k < P::k + 1; k++) decompose(k, decpoly[k]);
+    if (fftbackend<P>().offload())
+        TwistIFFTbatch<P>(decpolyfft, decpoly[0].data(), digits);
+    else
+        for (int k = 0; k < P::k + 1; k++)
+            for (int i = 0; i < P::l; i++)
+                TwistIFFT<P>(decpolyfft[i + k * P::l], decpoly[k][i]);
+    alignas(64) TRLWEInFD<P> restrlwefft;
+    mac(restrlwefft, decpolyfft);
+    for (int k = 0; k < P::k + 1; k++) TwistFFT<P>(res[k], restrlwefft[k]);
+}
+
+template <class P, class Decompose>
+void trgswfftExternalProductImpl(TRLWE<P> &res, Decompose decompose,
+                                 const TRGSWFFT<P> &trgswfft)
+{
+    trgswfftExternalProductMACImpl<P>(
+        res, decompose,
+        [&](TRLWEInFD<P> &restrlwefft, const PolynomialInFD<P> *decpolyfft) {
+            MACInFD<P::n, P::k + 1>(
+                [&](int m) { return restrlwefft[m].data(); },
+                [&](int d) { return decpolyfft[d].data(); },
+                [&](int d, int m) { return trgswfft[d][m].data(); },
+                (P::k + 1) * P::l);
+        });
+}
+
 template <class P>
 void trgswfftExternalProduct(TRLWE<P> &res, const TRLWE<P> &trlwe,
                              const TRGSWFFT<P> &trgswfft)
 {
     std::cout << "e";
-    alignas(64) DecomposedPolynomial<P> decpoly;
-    Decomposition<P>(decpoly, trlwe[0]);
-    alignas(64) PolynomialInFD<P> decpolyfft;
-    TwistIFFT<P>(decpolyfft, decpoly[0]);
-    alignas(64) TRLWEInFD<P> restrlwefft;
-    for (int m = 0; m < P::k + 1; m++)
-        MulInFD<P::n>(restrlwefft[m], decpolyfft, trgswfft[0][m]);
-    for (int i = 1; i < P::l; i++) {
-        TwistIFFT<P>(decpolyfft, decpoly[i]);
-        for (int m = 0; m < P::k + 1; m++)
-            FMAInFD<P::n>(restrlwefft[m], decpolyfft, trgswfft[i][m]);
+    trgswfftExternalProductImpl<P>(
+        res,
+        [&](int k, DecomposedPolynomial<P> &decpoly) {
+            Decomposition<P>(decpoly, trlwe[k]);
+        },
+        trgswfft);
+}
+
+// (X^a - 1) * trlwe times trgswfft, the product of a blind rotation step,
+// with the rotation fused into the decomposition. res may be trlwe.
+template <class P>
+void trgswfftExternalProductMulByXaiMinusOne(TRLWE<P> &res,
+                                             const TRLWE<P> &trlwe,
+                                             const typename P::T a,
+                                             const TRGSWFFT<P> &trgswfft)
+{
+    trgswfftExternalProductImpl<P>(
+        res,
+        [&](int k, DecomposedPolynomial<P> &decpoly) {
+            DecompositionMulByXaiMinusOne<P>(decpoly, trlwe[k], a);
+        },
+        trgswfft);
+}
+
+// res = sum over t < terms of ((X^a[t] - 1) * trlwe) times *trgswfft[t],
+// the step of a blind rotation with an unrolled key. trlwe is decomposed
+// and transformed once, its digit spectra are multiplied by every TRGSW,
+// one after the other, and the monomials are applied to those products in
+// FD. Terms with a[t] equal to 0 are zero and skipped. res may be trlwe.
+template <class P>
+void trgswfftExternalProductMulByXaiMinusOneSum(
+    TRLWE<P> &res, const TRLWE<P> &trlwe, const int *a,
+    const TRGSWFFT<P> *const *trgswfft, int terms)
+{
+    constexpr int K = P::k + 1;
+    WorkspaceFrame frame;
+    PolynomialInFD<P> *const factor = frame.take<PolynomialInFD<P>>(terms);
+    TRLWEInFD<P> *const product = frame.take<TRLWEInFD<P>>(terms);
+    const TRGSWFFT<P> **const key = frame.take<const TRGSWFFT<P> *>(terms);
+    int nonzero = 0;
+    for (int t = 0; t < terms; t++)
+        if (a[t] != 0) {
+            MonomialMinusOneInFD<P>(factor[nonzero], a[t]);
+            key[nonzero++] = trgswfft[t];
+        }
+    if (nonzero == 0) {
+        res = {};
+        return;
     }
-    for (int k = 1; k < P::k + 1; k++) {
-        Decomposition<P>(decpoly, trlwe[k]);
+    trgswfftExternalProductMACImpl<P>(
+        res,
+        [&](int k, DecomposedPolynomial<P> &decpoly) {
+            Decomposition<P>(decpoly, trlwe[k]);
+        },
+        [&](TRLWEInFD<P> &restrlwefft, const PolynomialInFD<P> *decpolyfft) {
+            for (int t = 0; t < nonzero; t++)
+                MACInFD<P::n, K>(
+                    [&](int m) { return product[t][m].data(); },
+                    [&](int d) { return decpolyfft[d].data(); },
+                    [&](int d, int m) { return (*key[t])[d][m].data(); },
+                    K * P::l);
+            MulSumInFD<P::n, K>(
+                [&](int m) { return restrlwefft[m].data(); },
+                [&](int t, int m) { return product[t][m].data(); },
+                [&](int t) { return factor[t].data(); }, nonzero);
+        });
+}
+
+// Same product in the NTT domain. The result is exact: it equals the sum
+// of the naive negacyclic products of the digits with the TRGSW rows.
+template <class P>
+void trgswnttExternalProduct(TRLWE<P> &res, const TRLWE<P> &trlwe,
+                             const TRGSWNTT<P> &trgswntt)
+{
+    // The NTT takes the signed digits as int32_t, which the decomposition
+    // writes directly.
+    alignas(64) std::array<std::array<int32_t, P::n>, P::l> decpoly;
+    alignas(64) PolynomialInNTT<P> decpolyntt;
+    alignas(64) TRLWEInNTT<P> restrlwentt;
+    for (int k = 0; k < P::k + 1; k++) {
+        DecompositionDigits<P, int32_t>(decpoly[0].data(), P::n,
+                                        trlwe[k].data());
         for (int i = 0; i < P::l; i++) {
-            TwistIFFT<P>(decpolyfft, decpoly[i]);
+            TwistNTT<P>(decpolyntt, decpoly[i].data());
             for (int m = 0; m < P::k + 1; m++)
-                FMAInFD<P::n>(restrlwefft[m], decpolyfft,
-                              trgswfft[i + k * P::l][m]);
+                for (int t = 0; t < nttlimbs<P>; t++)
+                    if (k == 0 && i == 0)
+                        MulInNTT<P>(restrlwentt[m][t], decpolyntt,
+                                    trgswntt[0][m][t]);
+                    else
+                        FMAInNTT<P>(restrlwentt[m][t], decpolyntt,
+                                    trgswntt[i + k * P::l][m][t]);
         }
     }
-    for (int k = 0; k < P::k + 1; k++) TwistFFT<P>(res[k], restrlwefft[k]);
+    for (int m = 0; m < P::k + 1; m++) TwistINTT<P>(res[m], restrlwentt[m]);
 }
 
 
-template <class P, int batch>
-void trgswfftExternalProductbatch(TRLWEn<P, batch> &res, const TRLWEn<P, batch> &trlwe,
-                             const TRGSWFFTn<P, batch> &trgswfft)
+// Lanes of trgswfftExternalProductbatchMACImpl taken at a time. The
+// digits, digit spectra and product spectra of a block, beside one TRGSW,
+// fit in half of L2, as the tiles of BlindRotatebatch. Past that the
+// spectra go back and forth to memory and the batch is slower than one
+// product per lane. An offload FFT engine gets the whole batch.
+// At lvl2 a block holds two or three lanes at most, which do not pay for
+// the batch calls of the CPU engines, so the lanes go one at a time, as
+// single products.
+template <class P>
+size_t ExternalProductbatchLanes(size_t batch)
 {
-    //std::cout << "trgswfftExternalProductbatch";
-    alignas(64) std::unique_ptr<DecomposedPolynomialn<P, batch>> decpolyPtr = std::make_unique<DecomposedPolynomialn<P, batch>>();
-    Decompositionbatch<P, batch>((*decpolyPtr), trlwe[0]);
+    if (batch == 0) return 1;
+    if (fftbackend<P>().offload()) return batch;
+    if constexpr (std::is_same_v<P, lvl2param>) return 1;
+    constexpr size_t lane = P::l * sizeof(Polynomial<P>) +
+                            P::l * sizeof(TRLWEInFD<P>) + sizeof(TRLWEInFD<P>);
+    const size_t l2 = L2CacheSize() / 2;
+    const size_t lanes = std::clamp<size_t>(
+        l2 > sizeof(TRGSWFFT<P>) + lane ? (l2 - sizeof(TRGSWFFT<P>)) / lane
+                                        : 1,
+        1, batch);
+    const size_t blocks = (batch + lanes - 1) / lanes;
+    return (batch + blocks - 1) / blocks;
+}
 
-    alignas(64) std::unique_ptr<PolynomialInFDn<P, batch>> decpolyfftPtr = std::make_unique<PolynomialInFDn<P, batch>>();
-    TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[0]);
+// The batch is taken in blocks of ExternalProductbatchLanes lanes. Within
+// a block all l*(k+1) digit transforms are submitted before the first
+// wait, so an offload engine can stream them while the host decomposes the
+// next row. The frequency domain product is then taken in blocks of
+// points: prefetch(begin, end) is called once per block of points of the
+// last block of lanes, then mac(j, res, a, begin, end) for every lane j,
+// with res(m) and a(d) returning the product spectra and the digit spectra
+// of that lane. decompose(k, decpoly, first, count) writes the digits of
+// component k of lanes first to first + count - 1, in the layout of
+// Decompositionbatch for count lanes.
+template <class P, class Decompose, class MAC, class Prefetch>
+void trgswfftExternalProductbatchMACImpl(TRLWEPlanes<P> res,
+                                         Decompose decompose, MAC mac,
+                                         Prefetch prefetch, size_t batch)
+{
+    constexpr int digits = (P::k + 1) * P::l;
+    const bool offload = fftbackend<P>().offload();
+    const size_t lanes = ExternalProductbatchLanes<P>(batch);
+    // Tens of megabytes for large batches on an offload engine, taken from
+    // the thread's workspace rather than allocated on every call.
+    WorkspaceFrame frame;
+    Polynomial<P> *const decpoly = frame.take<Polynomial<P>>(P::l * lanes);
+    PolynomialInFD<P> *const decpolyfft =
+        frame.take<PolynomialInFD<P>>(digits * lanes);
+    PolynomialInFD<P> *const restrlwefft =
+        frame.take<PolynomialInFD<P>>((P::k + 1) * lanes);
 
-    alignas(64) std::unique_ptr<TRLWEInFDn<P, batch>> restrlwefftPtr = std::make_unique<TRLWEInFDn<P, batch>>();
+    for (size_t first = 0; first < batch; first += lanes) {
+        const size_t count = std::min(lanes, batch - first);
+        // A block of one lane, which is all that fits in L2 at lvl2, goes
+        // one polynomial at a time through the CPU engines, as the single
+        // product does. Their batch calls start an OpenMP region each.
+        const bool serial = count == 1 && !offload;
+        FFTTicket ticket = 0;
+        for (int k = 0; k < P::k + 1; k++) {
+            decompose(k, decpoly, first, count);
+            for (int i = 0; i < P::l; i++)
+                if (serial)
+                    TwistIFFT<P>(decpolyfft[i + k * P::l], decpoly[i]);
+                else
+                    ticket = TwistIFFTbatchAsync<P>(
+                        &decpolyfft[(i + k * P::l) * count],
+                        &decpoly[i * count], count);
+        }
+        WaitFFT<P>(ticket);
 
-    for (int m = 0; m < P::k + 1; m++)
-        MulInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr), trgswfft[0][m]);
-    for (int i = 1; i < P::l; i++) {
-        TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[i]);
-        for (int m = 0; m < P::k + 1; m++)
-            FMAInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr), trgswfft[i][m]);
-    }
-    for (int k = 1; k < P::k + 1; k++) {
-        Decompositionbatch<P, batch>((*decpolyPtr), trlwe[k]);
-        for (int i = 0; i < P::l; i++) {
-            TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[i]);
-            for (int m = 0; m < P::k + 1; m++)
-                FMAInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr),
-                              trgswfft[i + k * P::l][m]);
+        // Blocks of points small enough that the key rows of a block stay
+        // in L1 while every lane is multiplied by them.
+        constexpr int block = 64;
+        const bool last = first + count == batch;
+        for (int begin = 0; begin < P::n / 2; begin += block) {
+            if (last) prefetch(begin, begin + block);
+            for (size_t j = 0; j < count; j++)
+                mac(
+                    first + j,
+                    [&](int m) { return restrlwefft[m * count + j].data(); },
+                    [&](int d) { return decpolyfft[d * count + j].data(); },
+                    begin, begin + block);
         }
+
+        for (int k = 0; k < P::k + 1; k++)
+            if (serial)
+                TwistFFT<P>(res[k][first], restrlwefft[k]);
+            else
+                ticket = TwistFFTbatchAsync<P>(
+                    res[k] + first, &restrlwefft[k * count], count);
+        WaitFFT<P>(ticket);
     }
-    for (int k = 0; k < P::k + 1; k++) TwistFFTbatch<P, batch>(res[k], (*restrlwefftPtr)[k]);
 }
 
-template <class P, int batch>
-void trgswfftExternalProductbatch(TRLWEn<P, batch> &res, const TRLWEn<P, batch> &trlwe,
-                             const TRGSWFFT<P> &trgswfft)
+// The products are accumulated by MACInFD, as in trgswfftExternalProduct.
+// key(d, m) points to component m of row d for lane 0, and lane j reads it
+// at offset j * bstride. Row d of prefetch, if given, is requested from
+// memory while the lanes consume row d of key.
+template <class P, class Decompose, class Key>
+void trgswfftExternalProductbatchImpl(TRLWEPlanes<P> res, Decompose decompose,
+                                      Key key, size_t bstride, size_t batch,
+                                      const TRGSWFFT<P> *prefetch = nullptr)
 {
-    alignas(64) std::unique_ptr<DecomposedPolynomialn<P, batch>> decpolyPtr = std::make_unique<DecomposedPolynomialn<P, batch>>();
-    Decompositionbatch<P, batch>((*decpolyPtr), trlwe[0]);
+    constexpr int digits = (P::k + 1) * P::l;
+    trgswfftExternalProductbatchMACImpl<P>(
+        res, decompose,
+        [&](size_t j, auto restrlwefft, auto decpolyfft, int begin, int end) {
+            MACInFD<P::n, P::k + 1>(
+                restrlwefft, decpolyfft,
+                [&](int d, int m) { return key(d, m)[j * bstride].data(); },
+                digits, begin, end);
+        },
+        [&](int begin, int end) {
+            if (prefetch)
+                for (int d = 0; d < digits; d++)
+                    PrefetchInFD<P>((*prefetch)[d], begin, end);
+        },
+        batch);
+}
 
-    alignas(64) std::unique_ptr<PolynomialInFDn<P, batch>> decpolyfftPtr = std::make_unique<PolynomialInFDn<P, batch>>();
-    TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[0]);
+// batch TRLWE given as planes, every lane with the same TRGSW. res may be
+// trlwe. prefetch is the TRGSW the caller multiplies by next, if any.
+template <class P>
+void trgswfftExternalProductbatch(TRLWEPlanes<P> res, ConstTRLWEPlanes<P> trlwe,
+                                  const TRGSWFFT<P> &trgswfft, size_t batch,
+                                  const TRGSWFFT<P> *prefetch = nullptr)
+{
+    trgswfftExternalProductbatchImpl<P>(
+        res,
+        [&](int k, Polynomial<P> *decpoly, size_t first, size_t count) {
+            Decompositionbatch<P>(decpoly, trlwe[k] + first, count);
+        },
+        [&](int d, int m) { return &trgswfft[d][m]; }, 0, batch, prefetch);
+}
 
-    alignas(64) std::unique_ptr<TRLWEInFDn<P, batch>> restrlwefftPtr = std::make_unique<TRLWEInFDn<P, batch>>();
+// Lane j with the TRGSW of lane j of trgswfft.
+template <class P>
+void trgswfftExternalProductbatch(TRLWEPlanes<P> res, ConstTRLWEPlanes<P> trlwe,
+                                  const TRGSWFFTBatch<P> &trgswfft, size_t batch)
+{
+    trgswfftExternalProductbatchImpl<P>(
+        res,
+        [&](int k, Polynomial<P> *decpoly, size_t first, size_t count) {
+            Decompositionbatch<P>(decpoly, trlwe[k] + first, count);
+        },
+        [&](int d, int m) { return trgswfft.at(d, m); }, 1, batch);
+}
 
-    for (int m = 0; m < P::k + 1; m++)
-        MulInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr), trgswfft[0][m]);
-    for (int i = 1; i < P::l; i++) {
-        TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[i]);
-        for (int m = 0; m < P::k + 1; m++)
-            FMAInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr), trgswfft[i][m]);
-    }
-    for (int k = 1; k < P::k + 1; k++) {
-        Decompositionbatch<P, batch>((*decpolyPtr), trlwe[k]);
-        for (int i = 0; i < P::l; i++) {
-            TwistIFFTbatch<P, batch>((*decpolyfftPtr), (*decpolyPtr)[i]);
-            for (int m = 0; m < P::k + 1; m++)
-                FMAInFDbatch<P, batch>((*restrlwefftPtr)[m], (*decpolyfftPtr),
-                              trgswfft[i + k * P::l][m]);
-        }
-    }
-    for (int k = 0; k < P::k + 1; k++) TwistFFTbatch<P, batch>(res[k], (*restrlwefftPtr)[k]);
+// Lane j of (X^a[j] - 1) * trlwe times trgswfft, as
+// trgswfftExternalProductMulByXaiMinusOne.
+template <class P>
+void trgswfftExternalProductMulByXaiMinusOnebatch(
+    TRLWEPlanes<P> res, ConstTRLWEPlanes<P> trlwe, const int *a,
+    const TRGSWFFT<P> &trgswfft, size_t batch,
+    const TRGSWFFT<P> *prefetch = nullptr)
+{
+    trgswfftExternalProductbatchImpl<P>(
+        res,
+        [&](int k, Polynomial<P> *decpoly, size_t first, size_t count) {
+            DecompositionMulByXaiMinusOnebatch<P>(decpoly, trlwe[k] + first,
+                                                  a + first, count);
+        },
+        [&](int d, int m) { return &trgswfft[d][m]; }, 0, batch, prefetch);
+}
+
+// Lane j of the sum over t < terms of ((X^a[t * batch + j] - 1) * trlwe)
+// times *trgswfft[t], as trgswfftExternalProductMulByXaiMinusOneSum. The
+// prefetchterms TRGSW of prefetch are requested from memory meanwhile.
+template <class P>
+void trgswfftExternalProductMulByXaiMinusOneSumbatch(
+    TRLWEPlanes<P> res, ConstTRLWEPlanes<P> trlwe, const int *a,
+    const TRGSWFFT<P> *const *trgswfft, int terms, size_t batch,
+    const TRGSWFFT<P> *const *prefetch = nullptr, int prefetchterms = 0)
+{
+    constexpr int K = P::k + 1;
+    constexpr int digits = K * P::l;
+    WorkspaceFrame frame;
+    // The factors and products of the terms of one lane, of which a block
+    // of points is used at a time.
+    PolynomialInFD<P> *const factor = frame.take<PolynomialInFD<P>>(terms);
+    TRLWEInFD<P> *const product = frame.take<TRLWEInFD<P>>(terms);
+    int *const term = frame.take<int>(terms);
+    trgswfftExternalProductbatchMACImpl<P>(
+        res,
+        [&](int k, Polynomial<P> *decpoly, size_t first, size_t count) {
+            Decompositionbatch<P>(decpoly, trlwe[k] + first, count);
+        },
+        [&](size_t j, auto restrlwefft, auto decpolyfft, int begin, int end) {
+            int nonzero = 0;
+            for (int t = 0; t < terms; t++)
+                if (a[t * batch + j] != 0) {
+                    MonomialMinusOneInFD<P>(factor[nonzero], a[t * batch + j],
+                                            begin, end);
+                    term[nonzero++] = t;
+                }
+            for (int t = 0; t < nonzero; t++)
+                MACInFD<P::n, K>(
+                    [&](int m) { return product[t][m].data(); }, decpolyfft,
+                    [&](int d, int m) {
+                        return (*trgswfft[term[t]])[d][m].data();
+                    },
+                    digits, begin, end);
+            MulSumInFD<P::n, K>(
+                restrlwefft,
+                [&](int t, int m) { return product[t][m].data(); },
+                [&](int t) { return factor[t].data(); }, nonzero, begin, end);
+        },
+        [&](int begin, int end) {
+            for (int t = 0; t < prefetchterms; t++)
+                for (int d = 0; d < digits; d++)
+                    PrefetchInFD<P>((*prefetch[t])[d], begin, end);
+        },
+        batch);
+}
+
+template <class P, int batch>
+void trgswfftExternalProductbatch(TRLWEn<P, batch> &res, const TRLWEn<P, batch> &trlwe,
+                             const TRGSWFFTn<P, batch> &trgswfft)
+{
+    trgswfftExternalProductbatchImpl<P>(
+        planes<P, batch>(res),
+        [&](int k, Polynomial<P> *decpoly, size_t first, size_t count) {
+            Decompositionbatch<P>(decpoly, trlwe[k].data() + first, count);
+        },
+        [&](int d, int m) { return trgswfft[d][m].data(); }, 1, batch);
+}
+
+template <class P, int batch>
+void trgswfftExternalProductbatch(TRLWEn<P, batch> &res, const TRLWEn<P, batch> &trlwe,
+                             const TRGSWFFT<P> &trgswfft)
+{
+    trgswfftExternalProductbatch<P>(planes<P, batch>(res),
+                                    planes<P, batch>(trlwe), trgswfft, batch);
 }
 
 
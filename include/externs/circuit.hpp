@@ -0,0 +1,13 @@
+#pragma once
+#include"../circuit.hpp"
+
+namespace TFHEpp{
+#define INST(iksP, brP, mu)                                          \
+    extern template void EvalCircuit<iksP, brP, mu>(                 \
+        std::vector<TLWE<typename brP::targetP>> & res,              \
+        const Circuit &circuit, const CircuitSchedule &schedule,     \
+        const std::vector<TLWE<typename iksP::domainP>> &in,         \
+        const EvalKey &ek, std::vector<CircuitLevelStats> *stats)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+}
@@ -36,6 +36,94 @@ TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
 TFHEPP_EXPLICIT_INSTANTIATION_GATE_BATCH_IKSBR(INST)
 #undef INST
 
+#define INST(iksP, brP, mu)                                        \
+    extern template void HomMixedbatch<iksP, brP, mu>(         \
+        TLWE<typename brP::targetP> * res, const GateOp *ops,      \
+        const TLWE<typename iksP::domainP> *ca,                    \
+        const TLWE<typename iksP::domainP> *cb, size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomNANDbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomNORbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomXNORbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomANDbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomORbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomXORbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomANDNYbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomANDYNbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomORNYbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+#define INST(iksP, brP, mu)                                                \
+    extern template void HomORYNbatch<iksP, brP, mu>(TLWE<typename brP::targetP> *res, \
+                                        const TLWE<typename iksP::domainP> *ca, \
+                                        const TLWE<typename iksP::domainP> *cb, \
+                                        size_t batch, const EvalKey &ek)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
 #define INST(iksP, brP, mu)                                                \
     extern template void HomNOR<iksP, brP, mu>(TLWE<typename brP::targetP> &res, \
                                         const TLWE<typename iksP::domainP> &ca, \
@@ -124,6 +212,22 @@ INST(lvl1param);
 INST(lvl0param);
 #undef INST
 
+#define INST(P)                                                               \
+    extern template void HomMUXbatch<P>(TLWE<P> * res, const TLWE<P> *cs,     \
+                                        const TLWE<P> *c1, const TLWE<P> *c0, \
+                                        size_t batch, const EvalKey &ek)
+INST(lvl1param);
+INST(lvl0param);
+#undef INST
+
+#define INST(P)                                                                \
+    extern template void HomNMUXbatch<P>(TLWE<P> * res, const TLWE<P> *cs,     \
+                                         const TLWE<P> *c1, const TLWE<P> *c0, \
+                                         size_t batch, const EvalKey &ek)
+INST(lvl1param);
+INST(lvl0param);
+#undef INST
+
 #define INST(bkP)                                                              \
     extern template void HomMUXwoIKSandSE<bkP>(TRLWE<typename bkP::targetP> & res,    \
                                         const TLWE<typename bkP::domainP> &cs, \
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fftpipeline.hpp"
+#include "params.hpp"
+#include "utils.hpp"
+
+namespace TFHEpp {
+
+// Negacyclic FFT engine for one ring dimension. All engines share the
+// frequency domain layout of FFT_Processor_FFTW (res[i] = Re,
+// res[i + N/2] = Im), so keys and spectra can be moved between them.
+class FFTBackend {
+public:
+    virtual ~FFTBackend() = default;
+
+    virtual void execute_reverse_torus32(double *res, const uint32_t *a) = 0;
+    virtual void execute_reverse_torus32(double *res, const uint32_t *a,
+                                         unsigned batch) = 0;
+    virtual void execute_direct_torus32(uint32_t *res, const double *a) = 0;
+    virtual void execute_direct_torus32(uint32_t *res, const double *a,
+                                        unsigned batch) = 0;
+    virtual void execute_direct_torus32_rescale(uint32_t *res, const double *a,
+                                                const double delta) = 0;
+    virtual void execute_reverse_torus64(double *res, const uint64_t *a) = 0;
+    virtual void execute_direct_torus64(uint64_t *res, const double *a) = 0;
+    virtual void execute_direct_torus64_rescale(uint64_t *res, const double *a,
+                                                const double delta) = 0;
+    virtual void execute_reverse_torus64(double *res, const uint64_t *a,
+                                         unsigned batch) = 0;
+    virtual void execute_direct_torus64(uint64_t *res, const double *a,
+                                        unsigned batch) = 0;
+
+    // Asynchronous batched transforms. The input may be reused as soon as
+    // the call returns; the output is valid once wait() has been called
+    // with the returned ticket or a later one. Engines without an offload
+    // device transform on the spot and return 0.
+    virtual FFTTicket submit_reverse_torus32(double *res, const uint32_t *a,
+                                             unsigned batch)
+    {
+        execute_reverse_torus32(res, a, batch);
+        return 0;
+    }
+    virtual FFTTicket submit_direct_torus32(uint32_t *res, const double *a,
+                                            unsigned batch)
+    {
+        execute_direct_torus32(res, a, batch);
+        return 0;
+    }
+    virtual void wait(FFTTicket ticket) { static_cast<void>(ticket); }
+
+    // True when transforms run on an offload device, which wants batches as
+    // large as possible.
+    virtual bool offload() const { return false; }
+};
+
+template <class Processor, class = void>
+struct has_async_fft : std::false_type {};
+
+template <class Processor>
+struct has_async_fft<Processor,
+                     std::void_t<decltype(std::declval<Processor &>().wait(
+                         FFTTicket{}))>> : std::true_type {};
+
+template <class Processor, class = void>
+struct has_batch_torus64 : std::false_type {};
+
+template <class Processor>
+struct has_batch_torus64<
+    Processor, std::void_t<decltype(std::declval<Processor &>()
+                                        .execute_direct_torus64(
+                                            std::declval<uint64_t *>(),
+                                            std::declval<const double *>(),
+                                            1u))>> : std::true_type {};
+
+struct NoLock {
+    void lock() {}
+    void unlock() {}
+};
+
+// Wraps one of the FFT processors. Processors that are not thread-safe are
+// serialised with Mutex.
+template <class Processor, class Mutex = NoLock>
+class FFTBackendAdapter final : public FFTBackend {
+    Processor &fftp;
+    Mutex mtx;
+
+public:
+    FFTBackendAdapter(Processor &fftp) : fftp(fftp) {}
+
+    void execute_reverse_torus32(double *res, const uint32_t *a) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_reverse_torus32(res, a);
+    }
+    void execute_reverse_torus32(double *res, const uint32_t *a,
+                                 unsigned batch) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_reverse_torus32(res, a, batch);
+    }
+    void execute_direct_torus32(uint32_t *res, const double *a) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_direct_torus32(res, a);
+    }
+    void execute_direct_torus32(uint32_t *res, const double *a,
+                                unsigned batch) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_direct_torus32(res, a, batch);
+    }
+    void execute_direct_torus32_rescale(uint32_t *res, const double *a,
+                                        const double delta) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_direct_torus32_rescale(res, a, delta);
+    }
+    void execute_reverse_torus64(double *res, const uint64_t *a) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_reverse_torus64(res, a);
+    }
+    void execute_direct_torus64(uint64_t *res, const double *a) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_direct_torus64(res, a);
+    }
+    void execute_direct_torus64_rescale(uint64_t *res, const double *a,
+                                        const double delta) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        fftp.execute_direct_torus64_rescale(res, a, delta);
+    }
+    // Processors without batched 64-bit transforms (the lvl1-only FPGA
+    // one) go one polynomial at a time.
+    void execute_reverse_torus64(double *res, const uint64_t *a,
+                                 unsigned batch) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        if constexpr (has_batch_torus64<Processor>::value)
+            fftp.execute_reverse_torus64(res, a, batch);
+        else
+            for (unsigned i = 0; i < batch; i++)
+                fftp.execute_reverse_torus64(res + (size_t)i * fftp.N,
+                                             a + (size_t)i * fftp.N);
+    }
+    void execute_direct_torus64(uint64_t *res, const double *a,
+                                unsigned batch) override
+    {
+        std::lock_guard<Mutex> lock(mtx);
+        if constexpr (has_batch_torus64<Processor>::value)
+            fftp.execute_direct_torus64(res, a, batch);
+        else
+            for (unsigned i = 0; i < batch; i++)
+                fftp.execute_direct_torus64(res + (size_t)i * fftp.N,
+                                            a + (size_t)i * fftp.N);
+    }
+    FFTTicket submit_reverse_torus32(double *res, const uint32_t *a,
+                                     unsigned batch) override
+    {
+        if constexpr (has_async_fft<Processor>::value) {
+            std::lock_guard<Mutex> lock(mtx);
+            return fftp.submit_reverse_torus32(res, a, batch);
+        }
+        else
+            return FFTBackend::submit_reverse_torus32(res, a, batch);
+    }
+    FFTTicket submit_direct_torus32(uint32_t *res, const double *a,
+                                    unsigned batch) override
+    {
+        if constexpr (has_async_fft<Processor>::value) {
+            std::lock_guard<Mutex> lock(mtx);
+            return fftp.submit_direct_torus32(res, a, batch);
+        }
+        else
+            return FFTBackend::submit_direct_torus32(res, a, batch);
+    }
+    void wait(FFTTicket ticket) override
+    {
+        if constexpr (has_async_fft<Processor>::value) {
+            std::lock_guard<Mutex> lock(mtx);
+            fftp.wait(ticket);
+        }
+    }
+    bool offload() const override { return has_async_fft<Processor>::value; }
+};
+
+// A named set of backends, one per ring dimension.
+struct FFTEngine {
+    std::string name;
+    FFTBackend *lvl1;
+    FFTBackend *lvl2;
+};
+
+// The registry holds "fftw" (when built with USE_FFTW3), "simd" and "fpga"
+// (when built with USE_FPGA and a device was found). The process-wide
+// engine is picked on first use from the TFHEPP_FFT_BACKEND environment
+// variable, else the FPGA if present, else the CPU engine chosen at build
+// time. Each thread can override it.
+// Engines live as long as the process and may be selected by any thread,
+// so a name can be registered only once: RegisterFFTEngine returns false
+// and changes nothing if name is taken.
+bool RegisterFFTEngine(const std::string &name, FFTBackend *lvl1,
+                       FFTBackend *lvl2);
+std::vector<std::string> FFTEngineNames();
+// Both return false and change nothing if name is not registered.
+bool SelectFFTEngine(const std::string &name);
+// An empty name makes the calling thread follow the process-wide engine
+// again.
+bool SelectThreadFFTEngine(const std::string &name);
+
+namespace detail {
+inline thread_local const FFTEngine *thread_fftengine = nullptr;
+inline std::atomic<const FFTEngine *> default_fftengine{nullptr};
+const FFTEngine &InitDefaultFFTEngine();
+}  // namespace detail
+
+inline const FFTEngine &CurrentFFTEngine()
+{
+    if (const FFTEngine *e = detail::thread_fftengine) return *e;
+    if (const FFTEngine *e =
+            detail::default_fftengine.load(std::memory_order_acquire))
+        return *e;
+    return detail::InitDefaultFFTEngine();
+}
+
+template <class P>
+inline FFTBackend &fftbackend()
+{
+    if constexpr (P::n == lvl1param::n)
+        return *CurrentFFTEngine().lvl1;
+    else if constexpr (P::n == lvl2param::n)
+        return *CurrentFFTEngine().lvl2;
+    else
+        static_assert(false_v<typename P::T>, "Undefined FFT backend!");
+}
+
+}  // namespace TFHEpp
@@ -75,18 +75,57 @@ extern void* fftfpga_complex_malloc(const size_t sz);
 extern void* fftfpgaf_complex_malloc(const size_t sz);
 
 
+
 /**
  * @brief  compute an out-of-place single precision complex 1D-FFT on the FPGA
  * @param  N    : integer pointer to size of FFT3d  
  * @param  inp  : float2 pointer to input data of size N
  * @param  out  : float2 pointer to output data of size N
  * @param  inv  : int toggle to activate backward FFT
- * @param  iter : number of iterations of the N point FFT
- * @return fpga_t : time taken in milliseconds for data transfers and execution
+ * @param  iter : number of iterations of the N point FFT, any value. The
+ *                batch is cut into chunks that persistent per-channel
+ *                workers pick up as soon as their channel is idle.
+ * @return fpga_t : time taken in milliseconds for data transfers and
+ *                  execution by the busiest channel
  */
 extern fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned iter);
 extern fpga_t fftfpgaf_c2c_1d_(const unsigned N, const float2 *inp, float2 *out, const bool inv);
 
+/**
+ * @brief  allocate the device buffers, kernels and queues used by the two
+ *         calls above once, for batches of up to max_batch N-point
+ *         transforms. They are kept until fpga_final(). Without this call
+ *         they are created on first use and grown when a larger batch
+ *         arrives.
+ * @param  N         : number of points of each FFT
+ * @param  max_batch : largest batch that will be passed
+ * @return false if the FPGA is not initialized, N is not a power of 2 or
+ *         the channel workers could not be started
+ */
+extern bool fftfpgaf_c2c_1d_reserve(const unsigned N, const unsigned max_batch);
+
+/**
+ * Utilisation of one FFT channel since start or the last reset
+ */
+typedef struct fpga_channel_stats {
+  unsigned long long transforms;  /**< N-point transforms computed */
+  unsigned long long launches;    /**< kernel launches */
+  double busy_t;                  /**< milliseconds spent on transfers and execution */
+} fpga_channel_stats;
+
+/**
+ * @brief  copy the utilisation counters of the FFT channels
+ * @param  stats        : array of at least max_channels entries
+ * @param  max_channels : number of entries to fill at most
+ * @return number of channels
+ */
+extern unsigned fftfpgaf_channel_stats(fpga_channel_stats *stats, const unsigned max_channels);
+
+/**
+ * @brief  reset the utilisation counters of all FFT channels
+ */
+extern void fftfpgaf_reset_channel_stats();
+
 #ifdef __cplusplus
 }
 #endif
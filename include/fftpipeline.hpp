@@ -0,0 +1,155 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fftfpga.h"
+
+namespace TFHEpp {
+
+// Identifies a transform submitted to an asynchronous FFT engine. Tickets
+// are handed out in increasing order starting at 1; 0 means the transform
+// has already completed.
+using FFTTicket = uint64_t;
+
+// Feeds a batched single precision FFT device (fpga_fft or a stand-in)
+// from depth buffer sets so that the host can prepare batch i+1 while the
+// device transfers and transforms batch i.
+//
+// submit() runs fill on the calling thread to write the device input into
+// a free buffer set and hands the set to a device thread. drain reads the
+// device output once the transform is done; it runs on the host thread
+// that completes the ticket, in submission order: either wait(), or a
+// later submit() that needs the buffer set back. Nothing is left waiting
+// on the caller, so any number of transforms can be submitted before the
+// first wait().
+//
+// A pipeline is driven by one host thread at a time.
+class FFTOffloadPipeline {
+public:
+    using Device = std::function<fpga_t(unsigned num, const float2 *inp,
+                                        float2 *out, bool inv,
+                                        unsigned batch)>;
+    using Fill = std::function<void(float2 *inbuf)>;
+    using Drain = std::function<void(const float2 *outbuf)>;
+
+    FFTOffloadPipeline(unsigned num, unsigned max_batch, Device device,
+                       unsigned depth = 2)
+        : num(num), max_batch(max_batch), device(std::move(device)),
+          slots(depth < 2 ? 2 : depth)
+    {
+        for (Slot &s : slots) {
+            s.inbuf.resize(size_t(num) * max_batch);
+            s.outbuf.resize(size_t(num) * max_batch);
+        }
+        worker = std::thread([this] { device_loop(); });
+    }
+
+    FFTOffloadPipeline(const FFTOffloadPipeline &) = delete;
+    FFTOffloadPipeline &operator=(const FFTOffloadPipeline &) = delete;
+
+    ~FFTOffloadPipeline()
+    {
+        wait_all();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    unsigned depth() const { return slots.size(); }
+    unsigned batch_capacity() const { return max_batch; }
+
+    // batch must not exceed max_batch.
+    FFTTicket submit(bool inv, unsigned batch, const Fill &fill, Drain drain)
+    {
+        const FFTTicket ticket = ++submitted;
+        // The buffer set still holds the ticket submitted depth calls ago.
+        if (ticket > slots.size()) wait(ticket - slots.size());
+        Slot &s = slot(ticket);
+        fill(s.inbuf.data());
+        s.inv = inv;
+        s.batch = batch;
+        s.drain = std::move(drain);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            s.state = Slot::Queued;
+            queue.push_back(ticket);
+        }
+        cv.notify_all();
+        return ticket;
+    }
+
+    // Completes every ticket up to and including ticket.
+    void wait(FFTTicket ticket)
+    {
+        while (completed < ticket && completed < submitted) {
+            Slot &s = slot(completed + 1);
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return s.state == Slot::Done; });
+            }
+            s.drain(s.outbuf.data());
+            s.drain = nullptr;
+            last_runtime = s.runtime;
+            s.state = Slot::Free;
+            completed++;
+        }
+    }
+
+    void wait_all() { wait(submitted); }
+
+    // Device timing of the most recently completed transform.
+    fpga_t runtime() const { return last_runtime; }
+
+private:
+    struct Slot {
+        enum State { Free, Queued, Done };
+        std::vector<float2> inbuf, outbuf;
+        State state = Free;
+        bool inv = false;
+        unsigned batch = 0;
+        Drain drain;
+        fpga_t runtime{};
+    };
+
+    Slot &slot(FFTTicket ticket) { return slots[ticket % slots.size()]; }
+
+    void device_loop()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            cv.wait(lock, [&] { return stop || !queue.empty(); });
+            if (queue.empty()) return;
+            Slot &s = slot(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            s.runtime =
+                device(num, s.inbuf.data(), s.outbuf.data(), s.inv, s.batch);
+            lock.lock();
+            s.state = Slot::Done;
+            cv.notify_all();
+        }
+    }
+
+    const unsigned num, max_batch;
+    Device device;
+    std::vector<Slot> slots;
+    FFTTicket submitted = 0, completed = 0;
+    fpga_t last_runtime{};
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<FFTTicket> queue;
+    bool stop = false;
+    std::thread worker;
+};
+
+}  // namespace TFHEpp
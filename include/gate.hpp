@@ -18,20 +18,89 @@ inline void HomGate(TLWE<typename brP::targetP> &res,
     GateBootstrapping<iksP, brP, mu>(res, res, ek);
 }
 
+template <class iksP, class brP, typename brP::targetP::T mu, int casign,
+          int cbsign, std::make_signed_t<typename iksP::domainP::T> offset>
+inline void HomGatebatch(TLWE<typename brP::targetP> *res,
+                         const TLWE<typename iksP::domainP> *ca,
+                         const TLWE<typename iksP::domainP> *cb, size_t batch,
+                         const EvalKey &ek)
+{
+    for (size_t j = 0; j < batch; j++)
+        for (int i = 0; i <= iksP::domainP::k * iksP::domainP::n; i++)
+            res[j][i] = casign * ca[j][i] + cbsign * cb[j][i];
+
+    for (size_t j = 0; j < batch; j++)
+        res[j][iksP::domainP::k * iksP::domainP::n] += offset;
+
+    GateBootstrappingbatch<iksP, brP, mu>(res, res, batch, ek);
+}
+
 template <class iksP, class brP, typename brP::targetP::T mu, int casign,
           int cbsign, std::make_signed_t<typename iksP::domainP::T> offset, int batch>
 inline void HomGatebatch(TLWEn<typename brP::targetP, batch> &res,
                     const TLWEn<typename iksP::domainP, batch> &ca,
                     const TLWEn<typename iksP::domainP, batch> &cb, const EvalKey &ek)
 {
-    for (int j = 0; j < batch; j++)
-        for (int i = 0; i <= iksP::domainP::k * iksP::domainP::n; i++)
-            res[j][i] = casign * ca[j][i] + cbsign * cb[j][i];
+    HomGatebatch<iksP, brP, mu, casign, cbsign, offset>(res.data(), ca.data(),
+                                                        cb.data(), batch, ek);
+}
 
-    for (int j = 0; j < batch; j++)
-        res[j][iksP::domainP::k * iksP::domainP::n] += offset;
 
-    GateBootstrappingbatch<iksP, brP, mu, batch>(res, res, ek);
+// Two-input gates that differ only in the linear combination before the
+// bootstrapping, for batches that mix them.
+enum class GateOp : uint8_t {
+    NAND,
+    AND,
+    OR,
+    NOR,
+    XOR,
+    XNOR,
+    ANDNY,
+    ANDYN,
+    ORNY,
+    ORYN
+};
+
+// casign * ca + cbsign * cb + offset * mu, as in the HomGate calls below.
+struct GateLinear {
+    int casign, cbsign, offset;
+};
+
+constexpr GateLinear gatelinear(GateOp op)
+{
+    switch (op) {
+    case GateOp::NAND: return {-1, -1, 1};
+    case GateOp::AND: return {1, 1, -1};
+    case GateOp::OR: return {1, 1, 1};
+    case GateOp::NOR: return {-1, -1, -1};
+    case GateOp::XOR: return {2, 2, 2};
+    case GateOp::XNOR: return {-2, -2, -2};
+    case GateOp::ANDNY: return {-1, 1, -1};
+    case GateOp::ANDYN: return {1, -1, -1};
+    case GateOp::ORNY: return {-1, 1, 1};
+    case GateOp::ORYN: return {1, -1, 1};
+    }
+    return {0, 0, 0};
+}
+
+// Lane j computes ops[j] on ca[j] and cb[j]; all lanes share one
+// GateBootstrappingbatch. res may be ca or cb.
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomMixedbatch(TLWE<typename brP::targetP> *res, const GateOp *ops,
+                   const TLWE<typename iksP::domainP> *ca,
+                   const TLWE<typename iksP::domainP> *cb, size_t batch,
+                   const EvalKey &ek)
+{
+    for (size_t j = 0; j < batch; j++) {
+        const GateLinear lin = gatelinear(ops[j]);
+        for (int i = 0; i <= iksP::domainP::k * iksP::domainP::n; i++)
+            res[j][i] = lin.casign * ca[j][i] + lin.cbsign * cb[j][i];
+        res[j][iksP::domainP::k * iksP::domainP::n] +=
+            lin.offset * iksP::domainP::mu;
+    }
+
+    GateBootstrappingbatch<iksP, brP, mu>(res, res, batch, ek);
 }
 
 
@@ -82,6 +151,19 @@ void HomNANDbatch(TLWEn<typename brP::targetP, batch> &res,
     HomGatebatch<iksP, brP, mu, -1, -1, iksP::domainP::mu, batch>(res, ca, cb, ek);
 }
 
+// batch gates on ciphertexts at ca and cb, batch known at run time. res may
+// be ca or cb.
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomNANDbatch(TLWE<typename brP::targetP> *res,
+                  const TLWE<typename iksP::domainP> *ca,
+                  const TLWE<typename iksP::domainP> *cb, size_t batch,
+                  const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, -1, -1, iksP::domainP::mu>(res, ca, cb, batch,
+                                                           ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -92,6 +174,16 @@ void HomNOR(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, -1, -1, -iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomNORbatch(TLWE<typename brP::targetP> *res,
+                 const TLWE<typename iksP::domainP> *ca,
+                 const TLWE<typename iksP::domainP> *cb, size_t batch,
+                 const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, -1, -1, -iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 
 template <class iksP = lvl10param, class brP = lvl01param,
@@ -103,6 +195,16 @@ void HomXNOR(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, -2, -2, -2 * iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomXNORbatch(TLWE<typename brP::targetP> *res,
+                  const TLWE<typename iksP::domainP> *ca,
+                  const TLWE<typename iksP::domainP> *cb, size_t batch,
+                  const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, -2, -2, -2 * iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -113,6 +215,16 @@ void HomAND(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, 1, 1, -iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomANDbatch(TLWE<typename brP::targetP> *res,
+                 const TLWE<typename iksP::domainP> *ca,
+                 const TLWE<typename iksP::domainP> *cb, size_t batch,
+                 const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, 1, 1, -iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -123,6 +235,16 @@ void HomOR(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, 1, 1, iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomORbatch(TLWE<typename brP::targetP> *res,
+                const TLWE<typename iksP::domainP> *ca,
+                const TLWE<typename iksP::domainP> *cb, size_t batch,
+                const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, 1, 1, iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -133,6 +255,16 @@ void HomXOR(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, 2, 2, 2 * iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomXORbatch(TLWE<typename brP::targetP> *res,
+                 const TLWE<typename iksP::domainP> *ca,
+                 const TLWE<typename iksP::domainP> *cb, size_t batch,
+                 const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, 2, 2, 2 * iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -143,6 +275,16 @@ void HomANDNY(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, -1, 1, -iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomANDNYbatch(TLWE<typename brP::targetP> *res,
+                   const TLWE<typename iksP::domainP> *ca,
+                   const TLWE<typename iksP::domainP> *cb, size_t batch,
+                   const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, -1, 1, -iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -153,6 +295,16 @@ void HomANDYN(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, 1, -1, -iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomANDYNbatch(TLWE<typename brP::targetP> *res,
+                   const TLWE<typename iksP::domainP> *ca,
+                   const TLWE<typename iksP::domainP> *cb, size_t batch,
+                   const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, 1, -1, -iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
 void HomORNY(TLWE<typename brP::targetP> &res,
@@ -162,6 +314,16 @@ void HomORNY(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, -1, 1, iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomORNYbatch(TLWE<typename brP::targetP> *res,
+                  const TLWE<typename iksP::domainP> *ca,
+                  const TLWE<typename iksP::domainP> *cb, size_t batch,
+                  const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, -1, 1, iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 template <class iksP = lvl10param, class brP = lvl01param,
           typename brP::targetP::T mu = lvl1param::mu>
@@ -172,6 +334,16 @@ void HomORYN(TLWE<typename brP::targetP> &res,
     HomGate<iksP, brP, mu, 1, -1, iksP::domainP::mu>(res, ca, cb, ek);
 }
 
+template <class iksP = lvl10param, class brP = lvl01param,
+          typename brP::targetP::T mu = lvl1param::mu>
+void HomORYNbatch(TLWE<typename brP::targetP> *res,
+                  const TLWE<typename iksP::domainP> *ca,
+                  const TLWE<typename iksP::domainP> *cb, size_t batch,
+                  const EvalKey &ek)
+{
+    HomGatebatch<iksP, brP, mu, 1, -1, iksP::domainP::mu>(res, ca, cb, batch, ek);
+}
+
 
 // 3input
 // cs?c1:c0
@@ -217,6 +389,54 @@ void HomNMUX(TLWE<P> &res, const TLWE<P> &cs, const TLWE<P> &c1,
     for (int i = 0; i <= P::k * P::n; i++) res[i] = -res[i];
 }
 
+// batch multiplexers. The 2 * batch bootstraps of the two AND terms run as
+// one batch. res may be any of the inputs.
+template <class P = lvl1param>
+void HomMUXbatch(TLWE<P> *res, const TLWE<P> *cs, const TLWE<P> *c1,
+                 const TLWE<P> *c0, size_t batch, const EvalKey &ek)
+{
+    // temp[j] = cs AND c1, temp[batch + j] = !cs AND c0 before bootstrapping
+    WorkspaceFrame frame;
+    TLWE<P> *const temp = frame.take<TLWE<P>>(2 * batch);
+    for (size_t j = 0; j < batch; j++) {
+        for (int i = 0; i <= P::k * P::n; i++) {
+            temp[j][i] = cs[j][i] + c1[j][i];
+            temp[batch + j][i] = -cs[j][i] + c0[j][i];
+        }
+        temp[j][P::k * P::n] -= P::mu;
+        temp[batch + j][P::k * P::n] -= P::mu;
+    }
+    if constexpr (std::is_same_v<P, lvl1param>) {
+        GateBootstrappingbatch<lvl10param, lvl01param, lvl1param::mu>(
+            temp, temp, 2 * batch, ek);
+        for (size_t j = 0; j < batch; j++) {
+            for (int i = 0; i <= P::k * lvl1param::n; i++)
+                res[j][i] = temp[j][i] + temp[batch + j][i];
+            res[j][P::k * P::n] += P::mu;
+        }
+    }
+    else if constexpr (std::is_same_v<P, lvl0param>) {
+        TLWE<lvl1param> *const and10 = frame.take<TLWE<lvl1param>>(2 * batch);
+        GateBootstrappingTLWE2TLWEFFTbatch<lvl01param>(
+            and10, temp, *ek.bkfftlvl01,
+            mupolygen<lvl1param, lvl1param::mu>(), 2 * batch);
+        for (size_t j = 0; j < batch; j++)
+            for (int i = 0; i <= lvl1param::k * lvl1param::n; i++)
+                and10[j][i] += and10[batch + j][i];
+        IdentityKeySwitchbatch<lvl10param>(res, and10, batch, *ek.iksklvl10);
+        for (size_t j = 0; j < batch; j++) res[j][P::k * P::n] += P::mu;
+    }
+}
+
+template <class P = lvl1param>
+void HomNMUXbatch(TLWE<P> *res, const TLWE<P> *cs, const TLWE<P> *c1,
+                  const TLWE<P> *c0, size_t batch, const EvalKey &ek)
+{
+    HomMUXbatch<P>(res, cs, c1, c0, batch, ek);
+    for (size_t j = 0; j < batch; j++)
+        for (int i = 0; i <= P::k * P::n; i++) res[j][i] = -res[j][i];
+}
+
 
 
 template <class bkP>
@@ -24,15 +24,52 @@ void GateBootstrappingTLWE2TLWEFFT(
     SampleExtractIndex<typename P::targetP>(res, acc, 0);
 }
 
+template <class P>
+void GateBootstrappingTLWE2TLWENTT(
+    TLWE<typename P::targetP> &res, const TLWE<typename P::domainP> &tlwe,
+    const BootstrappingKeyNTT<P> &bkntt,
+    const Polynomial<typename P::targetP> &testvector)
+{
+    alignas(64) TRLWE<typename P::targetP> acc;
+    BlindRotate<P>(acc, tlwe, bkntt, testvector);
+    SampleExtractIndex<typename P::targetP>(res, acc, 0);
+}
+
+// The lanes of one worker, with its own accumulators.
+template <class P>
+void GateBootstrappingTLWE2TLWEFFTslice(
+    TLWE<typename P::targetP> *res, const TLWE<typename P::domainP> *tlwe,
+    const BootstrappingKeyFFT<P> &bkfft,
+    const Polynomial<typename P::targetP> &testvector, size_t batch)
+{
+    WorkspaceFrame frame;
+    const TRLWEPlanes<typename P::targetP> acc =
+        frame.planes<typename P::targetP>(batch);
+    BlindRotateslice<P>(acc, tlwe, bkfft, testvector, batch);
+    SampleExtractIndexbatch<typename P::targetP>(res, acc, 0, batch);
+}
+
+template <class P>
+void GateBootstrappingTLWE2TLWEFFTbatch(
+    TLWE<typename P::targetP> *res, const TLWE<typename P::domainP> *tlwe,
+    const BootstrappingKeyFFT<P> &bkfft,
+    const Polynomial<typename P::targetP> &testvector, size_t batch)
+{
+    ParallelLanes(batch, BatchThreads<P>(batch),
+                  [&](size_t first, size_t count) {
+                      GateBootstrappingTLWE2TLWEFFTslice<P>(
+                          res + first, tlwe + first, bkfft, testvector, count);
+                  });
+}
+
 template <class P, int batch>
 void GateBootstrappingTLWE2TLWEFFTbatch(
     TLWEn<typename P::targetP, batch> &res, const TLWEn<typename P::domainP, batch> &tlwe,
     const BootstrappingKeyFFT<P> &bkfft,
     const Polynomial<typename P::targetP> &testvector)
 {
-    alignas(64) std::unique_ptr<TRLWEn<typename P::targetP, batch>> accPtr = std::make_unique<TRLWEn<typename P::targetP, batch>>();
-    BlindRotatebatch<P, batch>(*accPtr, tlwe, bkfft, testvector);
-    SampleExtractIndexbatch<typename P::targetP, batch>(res, *accPtr, 0);
+    GateBootstrappingTLWE2TLWEFFTbatch<P>(res.data(), tlwe.data(), bkfft,
+                                          testvector, batch);
 }
 
 
@@ -56,18 +93,45 @@ void GateBootstrapping(TLWE<typename iksP::domainP> &res,
 }
 
 
+// Same gate bootstrapping with the exact NTT bootstrapping key.
+template <class iksP, class bkP, typename bkP::targetP::T mu>
+void GateBootstrappingNTT(TLWE<typename iksP::domainP> &res,
+                          const TLWE<typename iksP::domainP> &tlwe,
+                          const EvalKey &ek)
+{
+    alignas(64) TLWE<typename iksP::targetP> tlwelvl0;
+    IdentityKeySwitch<iksP>(tlwelvl0, tlwe, ek.getiksk<iksP>());
+    GateBootstrappingTLWE2TLWENTT<bkP>(res, tlwelvl0, ek.getbkntt<bkP>(),
+                                       mupolygen<typename bkP::targetP, mu>());
+}
+
+// res may be tlwe.
+template <class iksP, class bkP, typename bkP::targetP::T mu>
+void GateBootstrappingbatch(TLWE<typename iksP::domainP> *res,
+                            const TLWE<typename iksP::domainP> *tlwe,
+                            size_t batch, const EvalKey &ek)
+{
+    ParallelLanes(batch, BatchThreads<bkP>(batch), [&](size_t first,
+                                                       size_t count) {
+        WorkspaceFrame frame;
+        TLWE<typename iksP::targetP> *const tlwelvl0 =
+            frame.take<TLWE<typename iksP::targetP>>(count);
+
+        IdentityKeySwitchbatch<iksP>(tlwelvl0, tlwe + first, count,
+                                     ek.getiksk<iksP>());
+
+        GateBootstrappingTLWE2TLWEFFTslice<bkP>(
+            res + first, tlwelvl0, ek.getbkfft<bkP>(),
+            mupolygen<typename bkP::targetP, mu>(), count);
+    });
+}
+
 template <class iksP, class bkP, typename bkP::targetP::T mu, int batch>
 void GateBootstrappingbatch(TLWEn<typename iksP::domainP, batch> &res,
                        const TLWEn<typename iksP::domainP, batch> &tlwe,
                        const EvalKey &ek)
 {
-    alignas(64) std::unique_ptr<TLWEn<typename iksP::targetP, batch>> tlwelvl0Ptr = std::make_unique<TLWEn<typename iksP::targetP, batch>>();
-
-    for (int j = 0; j < batch; j++)
-        IdentityKeySwitch<iksP>((*tlwelvl0Ptr)[j], tlwe[j], ek.getiksk<iksP>());
-
-    GateBootstrappingTLWE2TLWEFFTbatch<bkP, batch>(res, *tlwelvl0Ptr, ek.getbkfft<bkP>(),
-                                       mupolygen<typename bkP::targetP, mu>());
+    GateBootstrappingbatch<iksP, bkP, mu>(res.data(), tlwe.data(), batch, ek);
 }
 
 
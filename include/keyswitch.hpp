@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 
 #include "params.hpp"
@@ -102,6 +103,70 @@ void CatIdentityKeySwitch(
     }
 }
 
+// IdentityKeySwitch on batch TLWE, res[j] from tlwe[j]. The key is walked
+// once per tile of lanes, each row ksk[i][j][a] being subtracted from every
+// lane whose digit selects it while the row is in L1. Tiles are sized so
+// that their results stay in half of L2.
+template <class P>
+void IdentityKeySwitchbatch(TLWE<typename P::targetP> *res,
+                            const TLWE<typename P::domainP> *tlwe,
+                            size_t batch, const KeySwitchingKey<P> &ksk)
+{
+    constexpr uint32_t mask = (1U << P::basebit) - 1;
+    constexpr uint domain_digit =
+        std::numeric_limits<typename P::domainP::T>::digits;
+    constexpr uint target_digit =
+        std::numeric_limits<typename P::targetP::T>::digits;
+    constexpr typename P::domainP::T prec_offset =
+        (P::basebit * P::t) < domain_digit
+            ? 1ULL << (domain_digit - (1 + P::basebit * P::t))
+            : 0;
+    constexpr int targetlen = P::targetP::k * P::targetP::n + 1;
+
+    for (size_t j = 0; j < batch; j++) {
+        res[j] = {};
+        if constexpr (domain_digit == target_digit)
+            res[j][P::targetP::k * P::targetP::n] =
+                tlwe[j][P::domainP::k * P::domainP::n];
+        else if constexpr (domain_digit > target_digit)
+            res[j][P::targetP::k * P::targetP::n] =
+                (tlwe[j][P::domainP::k * P::domainP::n] +
+                 (1ULL << (domain_digit - target_digit - 1))) >>
+                (domain_digit - target_digit);
+        else if constexpr (domain_digit < target_digit)
+            res[j][P::targetP::k * P::targetP::n] =
+                static_cast<typename P::targetP::T>(
+                    tlwe[j][P::domainP::k * P::domainP::n])
+                << (target_digit - domain_digit);
+    }
+
+    const size_t tile = std::max<size_t>(
+        1, L2CacheSize() / 2 / sizeof(TLWE<typename P::targetP>));
+    WorkspaceFrame frame;
+    typename P::domainP::T *const aibar =
+        frame.take<typename P::domainP::T>(std::min(tile, batch));
+    for (size_t first = 0; first < batch; first += tile) {
+        const size_t count = std::min(tile, batch - first);
+        TLWE<typename P::targetP> *const out = res + first;
+        for (int i = 0; i < P::domainP::k * P::domainP::n; i++) {
+            for (size_t j = 0; j < count; j++)
+                aibar[j] = tlwe[first + j][i] + prec_offset;
+            for (int l = 0; l < P::t; l++)
+                for (size_t j = 0; j < count; j++) {
+                    const uint32_t aij =
+                        (aibar[j] >> (domain_digit - (l + 1) * P::basebit)) &
+                        mask;
+                    if (aij == 0) continue;
+                    const typename P::targetP::T *const row =
+                        ksk[i][l][aij - 1].data();
+                    typename P::targetP::T *const acc = out[j].data();
+#pragma omp simd
+                    for (int k = 0; k < targetlen; k++) acc[k] -= row[k];
+                }
+        }
+    }
+}
+
 template <class P>
 void SubsetIdentityKeySwitch(TLWE<typename P::targetP> &res,
                              const TLWE<typename P::domainP> &tlwe,
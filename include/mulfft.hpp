@@ -1,39 +1,123 @@
 #pragma once
+#include "fftbackend.hpp"
 #include "mult_fft_fpga.hpp"
-#include <fft_processor_fftw.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
 
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace TFHEpp {
 
-template <class P, int batch>
-inline void TwistFFTbatch(Polynomialn<P, batch> &res, const PolynomialInFDn<P, batch> &a)
+// The batch transforms take batch consecutive polynomials. The runtime
+// count forms below are the implementation; the int batch templates are
+// views of them on std::array storage.
+template <class P>
+inline void TwistFFTbatch(Polynomial<P> *res, const PolynomialInFD<P> *a,
+                          size_t batch)
 {
     //std::cout << "b";
     if constexpr (std::is_same_v<P, lvl1param>)
-        TwistFpgaFFTbatch(res[0].data(), a[0].data(), batch);
+        fftbackend<P>().execute_direct_torus32(res[0].data(), a[0].data(),
+                                               batch);
+    else if constexpr (std::is_same_v<P, lvl2param>)
+        fftbackend<P>().execute_direct_torus64(res[0].data(), a[0].data(),
+                                               batch);
     else
         static_assert(false_v<typename P::T>, "Undefined TwistFFT batch!");
 }
 
+template <class P>
+inline void TwistIFFTbatch(PolynomialInFD<P> *res, const Polynomial<P> *a,
+                           size_t batch)
+{
+    //std::cout << "B";
+    if constexpr (std::is_same_v<P, lvl1param>)
+        fftbackend<P>().execute_reverse_torus32(res[0].data(), a[0].data(),
+                                                batch);
+    else if constexpr (std::is_same_v<P, lvl2param>)
+        fftbackend<P>().execute_reverse_torus64(res[0].data(), a[0].data(),
+                                                batch);
+    else
+        static_assert(false_v<typename P::T>, "Undefined TwistIFFT batch!");
+}
+
+template <class P, int batch>
+inline void TwistFFTbatch(Polynomialn<P, batch> &res, const PolynomialInFDn<P, batch> &a)
+{
+    TwistFFTbatch<P>(res.data(), a.data(), batch);
+}
+
 template <class P, int batch>
 inline void TwistIFFTbatch(PolynomialInFDn<P, batch> &res, const Polynomialn<P, batch> &a)
 {
-    //std::cout << "B";
+    TwistIFFTbatch<P>(res.data(), a.data(), batch);
+}
+
+// Asynchronous forms of the two above: the input may be reused on return,
+// the result is ready after WaitFFT<P> on the returned ticket. lvl2 never
+// leaves the CPU, so its transforms complete on the spot.
+template <class P>
+inline FFTTicket TwistFFTbatchAsync(Polynomial<P> *res,
+                                    const PolynomialInFD<P> *a, size_t batch)
+{
     if constexpr (std::is_same_v<P, lvl1param>)
-        TwistFpgaIFFTbatch(res[0].data(), a[0].data(), batch);
+        return fftbackend<P>().submit_direct_torus32(res[0].data(),
+                                                     a[0].data(), batch);
+    else if constexpr (std::is_same_v<P, lvl2param>) {
+        TwistFFTbatch<P>(res, a, batch);
+        return 0;
+    }
+    else
+        static_assert(false_v<typename P::T>, "Undefined TwistFFT batch!");
+}
+
+template <class P>
+inline FFTTicket TwistIFFTbatchAsync(PolynomialInFD<P> *res,
+                                     const Polynomial<P> *a, size_t batch)
+{
+    if constexpr (std::is_same_v<P, lvl1param>)
+        return fftbackend<P>().submit_reverse_torus32(res[0].data(),
+                                                      a[0].data(), batch);
+    else if constexpr (std::is_same_v<P, lvl2param>) {
+        TwistIFFTbatch<P>(res, a, batch);
+        return 0;
+    }
     else
         static_assert(false_v<typename P::T>, "Undefined TwistIFFT batch!");
 }
 
+template <class P, int batch>
+inline FFTTicket TwistFFTbatchAsync(Polynomialn<P, batch> &res,
+                                    const PolynomialInFDn<P, batch> &a)
+{
+    return TwistFFTbatchAsync<P>(res.data(), a.data(), batch);
+}
+
+template <class P, int batch>
+inline FFTTicket TwistIFFTbatchAsync(PolynomialInFDn<P, batch> &res,
+                                     const Polynomialn<P, batch> &a)
+{
+    return TwistIFFTbatchAsync<P>(res.data(), a.data(), batch);
+}
+
+template <class P>
+inline void WaitFFT(FFTTicket ticket)
+{
+    fftbackend<P>().wait(ticket);
+}
+
 template <class P>
 inline void TwistFFT(Polynomial<P> &res, const PolynomialInFD<P> &a)
 {
     //std::cout << "*";
-    if constexpr (std::is_same_v<P, lvl1param>)
-        TwistFpgaFFT<P::n>(res, a);
+    if constexpr (std::is_same_v<typename P::T, uint32_t>)
+        fftbackend<P>().execute_direct_torus32(res.data(), a.data());
     else if constexpr (std::is_same_v<typename P::T, uint64_t>)
-        fftplvl2.execute_direct_torus64(res.data(), a.data());
+        fftbackend<P>().execute_direct_torus64(res.data(), a.data());
     else
         static_assert(false_v<typename P::T>, "Undefined TwistFFT!");
 }
@@ -43,10 +127,12 @@ template <class P>
 inline void TwistFFTrescale(Polynomial<P> &res, const PolynomialInFD<P> &a)
 {
     //std::cout << "&";
-    if constexpr (std::is_same_v<P, lvl1param>)
-        TwistFpgaFFTrescale<P>(res, a);
-    else if constexpr (std::is_same_v<P, lvl2param>)
-        fftplvl2.execute_direct_torus64_rescale(res.data(), a.data(), P::delta);
+    if constexpr (std::is_same_v<typename P::T, uint32_t>)
+        fftbackend<P>().execute_direct_torus32_rescale(res.data(), a.data(),
+                                                       P::delta);
+    else if constexpr (std::is_same_v<typename P::T, uint64_t>)
+        fftbackend<P>().execute_direct_torus64_rescale(res.data(), a.data(),
+                                                       P::delta);
     else
         static_assert(false_v<typename P::T>, "Undefined TwistFFT!");
 }
@@ -55,10 +141,10 @@ template <class P>
 inline void TwistIFFT(PolynomialInFD<P> &res, const Polynomial<P> &a)
 {
     //std::cout << "%";
-    if constexpr (std::is_same_v<P, lvl1param>)
-        TwistFpgaIFFT<P::n>(res, a);
+    if constexpr (std::is_same_v<typename P::T, uint32_t>)
+        fftbackend<P>().execute_reverse_torus32(res.data(), a.data());
     else if constexpr (std::is_same_v<typename P::T, uint64_t>)
-        fftplvl2.execute_reverse_torus64(res.data(), a.data());
+        fftbackend<P>().execute_reverse_torus64(res.data(), a.data());
     else
         static_assert(false_v<typename P::T>, "Undefined TwistIFFT!");
 }
@@ -114,6 +200,17 @@ inline void MulInFDbatch(PolynomialInFDn<P, batch> &res, const PolynomialInFDn<P
     }
 }
 
+// Runtime count form: lane j uses b[j * bstride], so bstride is 0 for one
+// operand shared by every lane and 1 for one operand per lane.
+template <class P>
+inline void MulInFDbatch(PolynomialInFD<P> *res, const PolynomialInFD<P> *a,
+                         const PolynomialInFD<P> *b, size_t bstride,
+                         size_t batch)
+{
+    for (size_t j = 0; j < batch; j++)
+        MulInFD<P::n>(res[j], a[j], b[j * bstride]);
+}
+
 
 // Be careful about memory accesses (We assume b has relatively high memory access cost)
 template <uint32_t N>
@@ -149,6 +246,202 @@ inline void FMAInFDbatch(PolynomialInFDn<P, batch> &res, const PolynomialInFDn<P
     }
 }
 
+template <class P>
+inline void FMAInFDbatch(PolynomialInFD<P> *res, const PolynomialInFD<P> *a,
+                         const PolynomialInFD<P> *b, size_t bstride,
+                         size_t batch)
+{
+    for (size_t j = 0; j < batch; j++)
+        FMAInFD<P::n>(res[j], a[j], b[j * bstride]);
+}
+
+
+// Software prefetch of the k+1 spectra of one TRGSW row, into L2.
+template <class P>
+inline void PrefetchInFD(const TRLWEInFD<P> &row)
+{
+    const char *p = reinterpret_cast<const char *>(row.data());
+    for (size_t i = 0; i < sizeof(row); i += 64) __builtin_prefetch(p + i, 0, 2);
+}
+
+// The same for the points [begin, end) of both halves of every spectrum.
+template <class P>
+inline void PrefetchInFD(const TRLWEInFD<P> &row, int begin, int end)
+{
+    for (const PolynomialInFD<P> &poly : row)
+        for (int half = 0; half < 2; half++) {
+            const char *p = reinterpret_cast<const char *>(
+                poly.data() + half * P::n / 2);
+            for (size_t i = begin * sizeof(double); i < end * sizeof(double);
+                 i += 64)
+                __builtin_prefetch(p + i, 0, 2);
+        }
+}
+
+// The frequency domain product of an external product over the points
+// [begin, end) of N/2: res(m) = sum of a(d) * b(d, m) over d < digits, for
+// the K outputs m < K. The accessors return the N doubles of a polynomial
+// in FD. A block of points of all K outputs is held in registers while
+// every digit spectrum is read once against its K key rows, and res is
+// written once, where MulInFD and FMAInFD make two passes per (d, m) and
+// re-read res each time. The products are accumulated in the order of
+// MulInFD followed by FMAInFD, so the result is the same.
+template <uint32_t N, int K, class R, class A, class B>
+inline void MACInFD(R res, A a, B b, int digits, int begin = 0,
+                    int end = N / 2)
+{
+    constexpr int Ns2 = N / 2;
+#if defined(__AVX512F__)
+    // Two vectors of eight points per output: 4K accumulators, and the
+    // digit and key vectors, fit in the 32 registers for K up to 3.
+    constexpr int W = 8, U = 2;
+    using Vec = __m512d;
+    const auto load = [](const double *p) { return _mm512_loadu_pd(p); };
+    const auto store = [](double *p, Vec v) { _mm512_storeu_pd(p, v); };
+    const auto fmadd = [](Vec x, Vec y, Vec z) { return _mm512_fmadd_pd(x, y, z); };
+    const auto fnmadd = [](Vec x, Vec y, Vec z) { return _mm512_fnmadd_pd(x, y, z); };
+    const auto zero = []() { return _mm512_setzero_pd(); };
+#elif defined(__AVX2__) && defined(__FMA__)
+    // 16 registers: one vector of four points per output.
+    constexpr int W = 4, U = 1;
+    using Vec = __m256d;
+    const auto load = [](const double *p) { return _mm256_loadu_pd(p); };
+    const auto store = [](double *p, Vec v) { _mm256_storeu_pd(p, v); };
+    const auto fmadd = [](Vec x, Vec y, Vec z) { return _mm256_fmadd_pd(x, y, z); };
+    const auto fnmadd = [](Vec x, Vec y, Vec z) { return _mm256_fnmadd_pd(x, y, z); };
+    const auto zero = []() { return _mm256_setzero_pd(); };
+#else
+    constexpr int W = 1, U = 4;
+    using Vec = double;
+    const auto load = [](const double *p) { return *p; };
+    const auto store = [](double *p, Vec v) { *p = v; };
+    const auto fmadd = [](Vec x, Vec y, Vec z) { return std::fma(x, y, z); };
+    const auto fnmadd = [](Vec x, Vec y, Vec z) { return std::fma(-x, y, z); };
+    const auto zero = []() { return 0.0; };
+#endif
+    for (int i = begin; i < end; i += W * U) {
+        Vec re[K][U], im[K][U];
+        for (int m = 0; m < K; m++)
+            for (int u = 0; u < U; u++) re[m][u] = im[m][u] = zero();
+        for (int d = 0; d < digits; d++) {
+            const double *ad = a(d);
+            Vec are[U], aim[U];
+            for (int u = 0; u < U; u++) {
+                are[u] = load(ad + i + u * W);
+                aim[u] = load(ad + Ns2 + i + u * W);
+            }
+            for (int m = 0; m < K; m++) {
+                const double *bm = b(d, m);
+                for (int u = 0; u < U; u++) {
+                    const Vec bre = load(bm + i + u * W);
+                    const Vec bim = load(bm + Ns2 + i + u * W);
+                    re[m][u] = fmadd(are[u], bre, re[m][u]);
+                    im[m][u] = fmadd(aim[u], bre, im[m][u]);
+                    im[m][u] = fmadd(are[u], bim, im[m][u]);
+                    re[m][u] = fnmadd(aim[u], bim, re[m][u]);
+                }
+            }
+        }
+        for (int m = 0; m < K; m++) {
+            double *rm = res(m);
+            for (int u = 0; u < U; u++) {
+                store(rm + i + u * W, re[m][u]);
+                store(rm + Ns2 + i + u * W, im[m][u]);
+            }
+        }
+    }
+}
+
+// Monomials in FD. Point i of a spectrum is the value of the polynomial
+// at a root of unity zeta_i = exp(pi I exponent[i] / N), times a scale of
+// the engine, so X^e - 1 multiplies point i by zeta_i^e - 1. The exponents
+// are read back from the transforms of 1 and X: every engine lays out its
+// spectra the same way, since the keys in FD are shared between them.
+template <class P>
+struct MonomialInFD {
+    std::array<uint32_t, P::n / 2> exponent;
+    // cos and sin of pi t / N for t < 2N
+    std::array<double, 2 * P::n> re, im;
+};
+
+template <class P>
+const MonomialInFD<P> &monomialinfd()
+{
+    static const MonomialInFD<P> table = [] {
+        constexpr int Ns2 = P::n / 2;
+        MonomialInFD<P> x;
+        Polynomial<P> one = {}, monomial = {};
+        one[0] = 1;
+        monomial[1] = 1;
+        PolynomialInFD<P> fone, fmonomial;
+        TwistIFFT<P>(fone, one);
+        TwistIFFT<P>(fmonomial, monomial);
+        for (int i = 0; i < Ns2; i++) {
+            // fmonomial / fone at point i
+            const double re =
+                fmonomial[i] * fone[i] + fmonomial[i + Ns2] * fone[i + Ns2];
+            const double im =
+                fmonomial[i + Ns2] * fone[i] - fmonomial[i] * fone[i + Ns2];
+            const long e = std::lround(std::atan2(im, re) * P::n / M_PI);
+            x.exponent[i] = static_cast<uint32_t>(e & (2 * P::n - 1));
+        }
+        for (int t = 0; t < 2 * P::n; t++) {
+            x.re[t] = std::cos(t * M_PI / P::n);
+            x.im[t] = std::sin(t * M_PI / P::n);
+        }
+        return x;
+    }();
+    return table;
+}
+
+// The spectrum of X^e - 1 over the points [begin, end) of N/2, for e in
+// [0, 2N).
+template <class P>
+inline void MonomialMinusOneInFD(PolynomialInFD<P> &res, int e, int begin = 0,
+                                 int end = P::n / 2)
+{
+    constexpr int Ns2 = P::n / 2;
+    constexpr uint32_t mask = 2 * P::n - 1;
+    const MonomialInFD<P> &x = monomialinfd<P>();
+    for (int i = begin; i < end; i++) {
+        const uint32_t index = x.exponent[i] * e & mask;
+        res[i] = x.re[index] - 1.0;
+        res[i + Ns2] = x.im[index];
+    }
+}
+
+// res(m) = sum over t < terms of f(t) * a(t, m) for the K outputs m < K,
+// over the points [begin, end) of N/2. The accessors return the N doubles
+// of a polynomial in FD.
+template <uint32_t N, int K, class R, class A, class F>
+inline void MulSumInFD(R res, A a, F f, int terms, int begin = 0,
+                       int end = N / 2)
+{
+    constexpr int Ns2 = N / 2;
+    for (int m = 0; m < K; m++) {
+        double *const rre = res(m), *const rim = rre + Ns2;
+        for (int t = 0; t < terms; t++) {
+            const double *const are = a(t, m), *const aim = are + Ns2;
+            const double *const fre = f(t), *const fim = fre + Ns2;
+            if (t == 0)
+#pragma omp simd
+                for (int i = begin; i < end; i++) {
+                    rre[i] = fre[i] * are[i] - fim[i] * aim[i];
+                    rim[i] = fre[i] * aim[i] + fim[i] * are[i];
+                }
+            else
+#pragma omp simd
+                for (int i = begin; i < end; i++) {
+                    rre[i] += fre[i] * are[i] - fim[i] * aim[i];
+                    rim[i] += fre[i] * aim[i] + fim[i] * are[i];
+                }
+        }
+        if (terms == 0) {
+            std::fill(rre + begin, rre + end, 0.0);
+            std::fill(rim + begin, rim + end, 0.0);
+        }
+    }
+}
 
 template <class P>
 inline void PolyMulNaive(Polynomial<P> &res, const Polynomial<P> &a,
@@ -217,7 +510,7 @@ inline void PolyMulbatch(Polynomialn<P, batch> &res, const Polynomialn<P, batch>
     if constexpr (std::is_same_v<typename P::T, uint32_t>)
         PolyMulFFTbatch<P, batch>(res, a, b);
     else
-        static_assert(false_v<typename P::T>, "PolyMulbatch!");
+        for (int j = 0; j < batch; j++) PolyMulNaive<P>(res[j], a[j], b[j]);
 
 }
 
@@ -0,0 +1,99 @@
+#pragma once
+#include <type_traits>
+
+#include "ntt_processor_simd.h"
+#include "params.hpp"
+#include "utils.hpp"
+
+namespace TFHEpp {
+
+template <class P>
+inline const auto &nttprocessor()
+{
+    if constexpr (P::n == lvl1param::n)
+        return nttsimdlvl1;
+    else if constexpr (P::n == lvl2param::n)
+        return nttsimdlvl2;
+    else
+        static_assert(false_v<typename P::T>, "Undefined NTT size!");
+}
+
+// Decomposed digits, small signed values, to the NTT domain.
+template <class P>
+inline void TwistNTT(PolynomialInNTT<P> &res, const Polynomial<P> &a)
+{
+    alignas(64) std::array<int32_t, P::n> digits;
+    for (int i = 0; i < P::n; i++)
+        digits[i] = static_cast<std::make_signed_t<typename P::T>>(a[i]);
+    nttprocessor<P>().execute_reverse_int(res.data(), digits.data());
+}
+
+// Digits already signed, as DecompositionDigits<P, int32_t> writes them.
+template <class P>
+inline void TwistNTT(PolynomialInNTT<P> &res, const int32_t *digits)
+{
+    nttprocessor<P>().execute_reverse_int(res.data(), digits);
+}
+
+// Key polynomial to the NTT domain, one transform per signed 32-bit limb:
+// a = sum_t limb_t * 2^(32 t).
+template <class P>
+inline void TwistNTTKey(std::array<PolynomialInNTT<P>, nttlimbs<P>> &res,
+                        const Polynomial<P> &a)
+{
+    alignas(64) std::array<int32_t, P::n> limb;
+    if constexpr (nttlimbs<P> == 1) {
+        for (int i = 0; i < P::n; i++) limb[i] = static_cast<int32_t>(a[i]);
+        nttprocessor<P>().execute_reverse_int_montgomery(res[0].data(),
+                                                         limb.data());
+    }
+    else if constexpr (nttlimbs<P> == 2) {
+        alignas(64) std::array<int32_t, P::n> high;
+        for (int i = 0; i < P::n; i++) {
+            limb[i] = static_cast<int32_t>(a[i]);
+            high[i] = static_cast<int64_t>(a[i] - static_cast<int64_t>(limb[i])) >> 32;
+        }
+        nttprocessor<P>().execute_reverse_int_montgomery(res[0].data(),
+                                                         limb.data());
+        nttprocessor<P>().execute_reverse_int_montgomery(res[1].data(),
+                                                         high.data());
+    }
+    else
+        static_assert(false_v<typename P::T>, "Undefined TwistNTTKey!");
+}
+
+// Exact product back to the torus, recombining the limbs.
+template <class P>
+inline void TwistINTT(Polynomial<P> &res,
+                      const std::array<PolynomialInNTT<P>, nttlimbs<P>> &a)
+{
+    if constexpr (std::is_same_v<typename P::T, uint32_t>)
+        nttprocessor<P>().execute_direct_torus32(res.data(), a[0].data());
+    else if constexpr (std::is_same_v<typename P::T, uint64_t>) {
+        alignas(64) std::array<int64_t, P::n> low, high;
+        nttprocessor<P>().execute_direct_int64(low.data(), a[0].data());
+        nttprocessor<P>().execute_direct_int64(high.data(), a[1].data());
+        for (int i = 0; i < P::n; i++)
+            res[i] = static_cast<uint64_t>(low[i]) +
+                     (static_cast<uint64_t>(high[i]) << 32);
+    }
+    else
+        static_assert(false_v<typename P::T>, "Undefined TwistINTT!");
+}
+
+// b is a key polynomial from TwistNTTKey.
+template <class P>
+inline void MulInNTT(PolynomialInNTT<P> &res, const PolynomialInNTT<P> &a,
+                     const PolynomialInNTT<P> &b)
+{
+    nttprocessor<P>().mul(res.data(), a.data(), b.data());
+}
+
+template <class P>
+inline void FMAInNTT(PolynomialInNTT<P> &res, const PolynomialInNTT<P> &a,
+                     const PolynomialInNTT<P> &b)
+{
+    nttprocessor<P>().fma(res.data(), a.data(), b.data());
+}
+
+}  // namespace TFHEpp
@@ -3,6 +3,8 @@
 #include "mult_fft.hpp"
 #include "params.hpp"
 #include "utils.hpp"
+#include "fftbackend.hpp"
+
 #ifdef USE_FPGA
 #include <fft_processor_fpga.h>
 
@@ -73,36 +75,44 @@ inline void TwistFpgaFFTrescale(Polynomial<P> &res, const PolynomialInFD<P> &a)
 
 #else
 
+// Without an FPGA the helpers run on the selected CPU FFT engine.
+inline TFHEpp::FFTBackend &cpufftlvl1()
+{
+    return TFHEpp::fftbackend<TFHEpp::lvl1param>();
+}
+
 template <int N>
 inline void TwistFpgaFFT(std::array<uint64_t, N> &res, const std::array<double, N> &a)
 {
-    fftplvl1.execute_direct_torus64(res.data(), a.data());
+    cpufftlvl1().execute_direct_torus64(res.data(), a.data());
 }
 
 template <int N>
 inline void TwistFpgaFFT(std::array<uint32_t, N> &res, const std::array<double, N> &a)
 {
-    fftplvl1.execute_direct_torus32(res.data(), a.data());
+    cpufftlvl1().execute_direct_torus32(res.data(), a.data());
 }
 
 
 template <int N>
 inline void TwistFpgaIFFT(std::array<double, N> &res, const std::array<uint64_t, N> &a)
 {
-    fftplvl1.execute_reverse_torus64(res.data(), a.data());
+    cpufftlvl1().execute_reverse_torus64(res.data(), a.data());
 }
 
 template <int N>
 inline void TwistFpgaIFFT(std::array<double, N> &res, const std::array<uint32_t, N> &a)
 {
-    fftplvl1.execute_reverse_torus32(res.data(), a.data());
+    cpufftlvl1().execute_reverse_torus32(res.data(), a.data());
 }
 
 inline void TwistFpgaFFTbatch(uint32_t *a, const double *res, unsigned batch)
 {
+    cpufftlvl1().execute_direct_torus32(a, res, batch);
 }
 inline void TwistFpgaIFFTbatch(double *res, const uint32_t *a, unsigned batch)
 {
+    cpufftlvl1().execute_reverse_torus32(res, a, batch);
 }
 
 namespace TFHEpp {
@@ -111,11 +121,11 @@ inline void TwistFpgaFFTrescale(Polynomial<P> &res, const PolynomialInFD<P> &a)
 {
     if constexpr (std::is_same_v<P, lvl1param>) {
         if constexpr (std::is_same_v<typename P::T, uint32_t>)
-            fftplvl1.execute_direct_torus32_rescale(res.data(), a.data(),
-                                                    P::delta);
+            cpufftlvl1().execute_direct_torus32_rescale(res.data(), a.data(),
+                                                        P::delta);
         else if constexpr (std::is_same_v<typename P::T, uint64_t>)
-            fftplvl1.execute_direct_torus64_rescale(res.data(), a.data(),
-                                                    P::delta);
+            cpufftlvl1().execute_direct_torus64_rescale(res.data(), a.data(),
+                                                        P::delta);
         else
             static_assert(false_v<typename P::T>, "TwistFpgaFFTrescale!");
     }
@@ -2,6 +2,7 @@
 #include <array>
 #include <cmath>
 #include <cstdint>
+#include <limits>
 
 namespace TFHEpp {
 
@@ -34,6 +35,15 @@ struct lvlh2param {
     static constexpr uint32_t Addends = 1;
 };
 
+// Bootstrapping key unrolled over pairs of lvl0 coefficients: half the
+// blind rotation steps of lvl01param, with three TRGSW per key element
+// instead of one. Only the FFT key and blind rotation support it.
+struct lvl01unrolledparam {
+    using domainP = lvl0param;
+    using targetP = lvl1param;
+    static constexpr uint32_t Addends = 2;
+};
+
 template <class P>
 using Key = std::array<typename P::T, P::k * P::n>;
 
@@ -97,13 +107,44 @@ using TRGSWFFT = aligned_array<TRLWEInFD<P>, (P::k + 1) * P::l>;
 template <class P, int batch>
 using TRGSWFFTn = aligned_array<TRLWEInFDn<P, batch>, (P::k + 1) * P::l>;
 
+// NTT domain (thirdparties/nttsimd). Keys over a 64-bit torus are split
+// into two 32-bit limbs so that every product stays exact.
+template <class P>
+constexpr int nttlimbs = std::numeric_limits<typename P::T>::digits / 32;
+
+template <class P>
+using PolynomialInNTT = std::array<uint64_t, P::n>;
+
+template <class P>
+using TRLWEInNTT =
+    std::array<std::array<PolynomialInNTT<P>, nttlimbs<P>>, P::k + 1>;
+
+template <class P>
+using TRGSWNTT = aligned_array<TRLWEInNTT<P>, (P::k + 1) * P::l>;
+
 template <class P>
 using BootstrappingKeyElement =
     std::array<TRGSW<typename P::targetP>, P::domainP::key_value_diff>;
+// TRGSW of an element of BootstrappingKeyFFT<P>, which covers Addends
+// coefficients of the domain key: one per combination of their values
+// other than all zero.
+template <class P>
+constexpr int bkelements()
+{
+    int combinations = 1;
+    for (uint32_t r = 0; r < P::Addends; r++)
+        combinations *= P::domainP::key_value_diff + 1;
+    return combinations - 1;
+}
+
 template <class P>
 using BootstrappingKeyElementFFT =
-    std::array<TRGSWFFT<typename P::targetP>, P::domainP::key_value_diff>;
+    std::array<TRGSWFFT<typename P::targetP>, bkelements<P>()>;
+
 
+template <class P>
+using BootstrappingKeyElementNTT =
+    std::array<TRGSWNTT<typename P::targetP>, P::domainP::key_value_diff>;
 
 template <class P>
 using BootstrappingKey =
@@ -112,6 +153,9 @@ template <class P>
 using BootstrappingKeyFFT =
     std::array<BootstrappingKeyElementFFT<P>,
                P::domainP::k * P::domainP::n / P::Addends>;
+template <class P>
+using BootstrappingKeyNTT =
+    std::array<BootstrappingKeyElementNTT<P>, P::domainP::k * P::domainP::n>;
 
 
 template <class P>
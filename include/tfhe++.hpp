@@ -1,5 +1,6 @@
 #pragma once
 
+#include "circuit.hpp"
 #include "cloudkey.hpp"
 #include "cmuxmem.hpp"
 #include "detwfa.hpp"
@@ -27,6 +28,7 @@
 #ifndef __clang__
 // Because of some resons (may be clang bug?) this will gives linking error
 // caused by mismatching name mangling.
+#include "externs/circuit.hpp"
 #include "externs/gate.hpp"
 #include "externs/gatebootstrapping.hpp"
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <iostream>
 #include "mulfft.hpp"
+#include "mulntt.hpp"
 #include "params.hpp"
 #include "trlwe.hpp"
 #include "decomposition.hpp"
@@ -20,6 +21,15 @@ TRGSWFFT<P> ApplyFFT2trgsw(const TRGSW<P> &trgsw)
     return trgswfft;
 }
 
+// Written in place: a lvl2 TRGSW in the NTT domain takes 512 KiB.
+template <class P>
+void ApplyNTT2trgsw(TRGSWNTT<P> &trgswntt, const TRGSW<P> &trgsw)
+{
+    for (int i = 0; i < (P::k + 1) * P::l; i++)
+        for (int j = 0; j < (P::k + 1); j++)
+            TwistNTTKey<P>(trgswntt[i][j], trgsw[i][j]);
+}
+
 template <class P, int batch>
 TRGSWFFTn<P, batch> ApplyFFT2trgswbatch(const TRGSWn<P, batch> &trgsw)
 {
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include "batchbuffer.hpp"
 #include "mulfft.hpp"
 #include "params.hpp"
 #include <iostream>
@@ -390,10 +391,11 @@ void SampleExtractIndex(TLWE<P> &tlwe, const TRLWE<P> &trlwe, const int index)
     tlwe[P::k * P::n] = trlwe[P::k][index];
 }
 
-template <class P, int batch>
-void SampleExtractIndexbatch(TLWEn<P, batch> &tlwe, const TRLWEn<P, batch> &trlwe, const int index)
+template <class P>
+void SampleExtractIndexbatch(TLWE<P> *tlwe, ConstTRLWEPlanes<P> trlwe,
+                             const int index, size_t batch)
 {
-    for (int j= 0; j< batch;j++) {
+    for (size_t j = 0; j < batch; j++) {
         for (int k = 0; k < P::k; k++) {
             for (int i = 0; i <= index; i++)
                 tlwe[j][k * P::n + i] = trlwe[k][j][index - i];
@@ -404,5 +406,12 @@ void SampleExtractIndexbatch(TLWEn<P, batch> &tlwe, const TRLWEn<P, batch> &trlw
     }
 }
 
+template <class P, int batch>
+void SampleExtractIndexbatch(TLWEn<P, batch> &tlwe, const TRLWEn<P, batch> &trlwe, const int index)
+{
+    SampleExtractIndexbatch<P>(tlwe.data(), planes<P, batch>(trlwe), index,
+                               batch);
+}
+
 
 }  // namespace TFHEpp
\ No newline at end of file
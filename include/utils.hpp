@@ -8,9 +8,13 @@
 #include <array>
 #include <cmath>
 #include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <limits>
 #include <random>
+#include <string>
+
+#include <unistd.h>
 
 namespace TFHEpp {
 #ifdef USE_RANDEN
@@ -230,4 +234,26 @@ inline void Automorphism(Polynomial<P> &res, const Polynomial<P> &poly,
     }
 }
 
+// Per-core L2 size in bytes, for sizing the working set of batch loops.
+// Taken from sysconf or sysfs; 1 MiB when neither reports it.
+inline size_t L2CacheSize()
+{
+    static const size_t size = [] {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        const long s = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (s > 0) return static_cast<size_t>(s);
+#endif
+        std::ifstream sysfs("/sys/devices/system/cpu/cpu0/cache/index2/size");
+        std::string str;
+        if (sysfs >> str && !str.empty()) {
+            size_t value = std::strtoul(str.c_str(), nullptr, 10);
+            if (str.back() == 'K') value <<= 10;
+            if (str.back() == 'M') value <<= 20;
+            if (value > 0) return value;
+        }
+        return static_cast<size_t>(1) << 20;
+    }();
+    return size;
+}
+
 }  // namespace TFHEpp
@@ -0,0 +1,546 @@
+#include <circuit.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace TFHEpp {
+
+namespace {
+bool GateTruth(GateOp op, bool a, bool b)
+{
+    switch (op) {
+    case GateOp::NAND: return !(a & b);
+    case GateOp::AND: return a & b;
+    case GateOp::OR: return a | b;
+    case GateOp::NOR: return !(a | b);
+    case GateOp::XOR: return a ^ b;
+    case GateOp::XNOR: return !(a ^ b);
+    case GateOp::ANDNY: return !a & b;
+    case GateOp::ANDYN: return a & !b;
+    case GateOp::ORNY: return !a | b;
+    case GateOp::ORYN: return a | !b;
+    }
+    return false;
+}
+
+// The GateOp with truth table t, bit a | b << 1 giving op(a, b), or -1 for
+// the six tables that are not a gate.
+int TableOp(uint8_t t)
+{
+    static const std::array<int, 16> op = [] {
+        std::array<int, 16> res;
+        res.fill(-1);
+        for (int op = 0; op <= static_cast<int>(GateOp::ORYN); op++) {
+            uint8_t t = 0;
+            for (int m = 0; m < 4; m++)
+                t |= GateTruth(static_cast<GateOp>(op), m & 1, m >> 1) << m;
+            res[t] = op;
+        }
+        return res;
+    }();
+    return op[t & 15];
+}
+}  // namespace
+
+Circuit::Wire Circuit::input()
+{
+    node.push_back({Kind::Input, GateOp::NAND, false, 0, 0});
+    ins.push_back(node.size() - 1);
+    return node.size() - 1;
+}
+
+Circuit::Wire Circuit::constant(bool value)
+{
+    node.push_back({Kind::Constant, GateOp::NAND, value, 0, 0});
+    return node.size() - 1;
+}
+
+Circuit::Wire Circuit::NOT(Wire a)
+{
+    node.push_back({Kind::Not, GateOp::NAND, false, a, a});
+    return node.size() - 1;
+}
+
+Circuit::Wire Circuit::gate(GateOp op, Wire a, Wire b)
+{
+    node.push_back({Kind::Gate, op, false, a, b});
+    return node.size() - 1;
+}
+
+size_t Circuit::bootstraps() const
+{
+    return std::count_if(node.begin(), node.end(), [](const Node &n) {
+        return n.kind == Kind::Gate;
+    });
+}
+
+std::vector<uint8_t> Circuit::evaluate(const std::vector<uint8_t> &in) const
+{
+    std::vector<uint8_t> value(node.size());
+    for (size_t i = 0; i < ins.size(); i++) value[ins[i]] = in[i];
+    for (size_t i = 0; i < node.size(); i++) {
+        const Node &n = node[i];
+        switch (n.kind) {
+        case Kind::Input: break;
+        case Kind::Constant: value[i] = n.value; break;
+        case Kind::Not: value[i] = !value[n.a]; break;
+        case Kind::Gate: value[i] = GateTruth(n.op, value[n.a], value[n.b]);
+        }
+    }
+    std::vector<uint8_t> res(outs.size());
+    for (size_t i = 0; i < outs.size(); i++) res[i] = value[outs[i]];
+    return res;
+}
+
+CircuitSchedule::CircuitSchedule(const Circuit &circuit)
+{
+    using Kind = Circuit::Kind;
+    const std::vector<Circuit::Node> &node = circuit.nodes();
+    std::vector<size_t> level(node.size());
+    size_t depth = 0;
+    for (size_t i = 0; i < node.size(); i++) {
+        const Circuit::Node &n = node[i];
+        if (n.kind == Kind::Not) level[i] = level[n.a];
+        if (n.kind == Kind::Gate)
+            level[i] = 1 + std::max(level[n.a], level[n.b]);
+        depth = std::max(depth, level[i]);
+    }
+    gates.assign(depth + 1, {});
+    free.assign(depth + 1, {});
+    for (size_t i = 0; i < node.size(); i++)
+        (node[i].kind == Kind::Gate ? gates : free)[level[i]].push_back(i);
+    for (const auto &g : gates) width = std::max(width, g.size());
+
+    // Level l runs in two phases: 2l gathers the operands of gates[l] and
+    // writes its results, 2l + 1 evaluates free[l] one by one. A buffer can
+    // be handed out again at the start of the phase after its last reader,
+    // or at the start of that phase if the reader is a gate.
+    auto phase = [&](size_t i) {
+        return 2 * level[i] + (node[i].kind == Kind::Gate ? 0 : 1);
+    };
+    std::vector<size_t> release(node.size());
+    for (size_t i = 0; i < node.size(); i++) {
+        release[i] = std::max(release[i], phase(i) + 1);
+        const size_t read =
+            node[i].kind == Kind::Gate ? phase(i) : phase(i) + 1;
+        if (node[i].kind == Kind::Not || node[i].kind == Kind::Gate)
+            release[node[i].a] = std::max(release[node[i].a], read);
+        if (node[i].kind == Kind::Gate)
+            release[node[i].b] = std::max(release[node[i].b], read);
+    }
+    for (const Circuit::Wire w : circuit.outputs())
+        release[w] = std::numeric_limits<size_t>::max();
+
+    std::vector<std::vector<Circuit::Wire>> releaseat(2 * depth + 3);
+    for (size_t i = 0; i < node.size(); i++)
+        if (release[i] < releaseat.size()) releaseat[release[i]].push_back(i);
+
+    slot.resize(node.size());
+    std::vector<uint32_t> unused;
+    for (size_t p = 0; p < 2 * depth + 2; p++) {
+        for (const Circuit::Wire w : releaseat[p]) unused.push_back(slot[w]);
+        for (const Circuit::Wire w : (p % 2 ? free : gates)[p / 2]) {
+            if (unused.empty())
+                slot[w] = slots++;
+            else {
+                slot[w] = unused.back();
+                unused.pop_back();
+            }
+        }
+    }
+}
+
+namespace {
+// A BLIF signal: the truth table of up to three named inputs, bit m giving
+// the value for input i = (m >> i) & 1.
+struct BLIFDef {
+    std::vector<std::string> in;
+    uint8_t table;
+};
+
+// Reads the next logical line, joining continuations and dropping comments.
+bool BLIFLine(std::istream &is, std::vector<std::string> &tokens)
+{
+    tokens.clear();
+    std::string line, part;
+    while (std::getline(is, part)) {
+        if (const size_t hash = part.find('#'); hash != std::string::npos)
+            part.erase(hash);
+        const bool more = !part.empty() && part.back() == '\\';
+        if (more) part.pop_back();
+        line += part + ' ';
+        if (more) continue;
+        std::istringstream words(line);
+        for (std::string w; words >> w;) tokens.push_back(w);
+        if (!tokens.empty()) return true;
+        line.clear();
+    }
+    return !tokens.empty();
+}
+
+// The truth tables of the Yosys internal gate cells, as pin order and
+// table. $_MUX_ is Y = S ? B : A.
+bool YosysCell(const std::string &type, std::vector<std::string> &pins,
+               uint8_t &table)
+{
+    static const std::unordered_map<std::string, uint8_t> two = {
+        {"$_AND_", 0b1000},  {"$_NAND_", 0b0111}, {"$_OR_", 0b1110},
+        {"$_NOR_", 0b0001},  {"$_XOR_", 0b0110},  {"$_XNOR_", 0b1001},
+        {"$_ANDNOT_", 0b0010}, {"$_ORNOT_", 0b1011}};
+    if (type == "$_NOT_" || type == "$_BUF_") {
+        pins = {"A"};
+        table = type == "$_NOT_" ? 0b01 : 0b10;
+    }
+    else if (type == "$_MUX_") {
+        pins = {"A", "B", "S"};
+        table = 0b11001010;
+    }
+    else if (auto it = two.find(type); it != two.end()) {
+        pins = {"A", "B"};
+        table = it->second;
+    }
+    else
+        return false;
+    return true;
+}
+}  // namespace
+
+bool ReadBLIF(Circuit &res, std::istream &is)
+{
+    res = Circuit();
+    std::vector<std::string> inputs, outputs, tokens;
+    std::unordered_map<std::string, BLIFDef> def;
+    bool pending = BLIFLine(is, tokens);
+    while (pending) {
+        const std::string cmd = tokens[0];
+        if (cmd == ".model" || cmd == ".attr" || cmd == ".param" ||
+            cmd == ".cname") {
+            pending = BLIFLine(is, tokens);
+        }
+        else if (cmd == ".inputs" || cmd == ".outputs") {
+            std::vector<std::string> &names =
+                cmd == ".inputs" ? inputs : outputs;
+            names.insert(names.end(), tokens.begin() + 1, tokens.end());
+            pending = BLIFLine(is, tokens);
+        }
+        else if (cmd == ".conn") {
+            if (tokens.size() != 3) return false;
+            def[tokens[2]] = {{tokens[1]}, 0b10};
+            pending = BLIFLine(is, tokens);
+        }
+        else if (cmd == ".names") {
+            if (tokens.size() < 2 || tokens.size() > 4) return false;
+            BLIFDef d{{tokens.begin() + 1, tokens.end() - 1}, 0};
+            const std::string out = tokens.back();
+            const size_t k = d.in.size();
+            // The cover lists the cubes of the on-set, or all of the
+            // off-set when the output column is 0.
+            uint8_t cover = 0;
+            int polarity = -1;
+            while ((pending = BLIFLine(is, tokens)) && tokens[0][0] != '.') {
+                if (tokens.size() != (k ? 2 : 1)) return false;
+                const std::string cube = k ? tokens[0] : "";
+                const std::string bit = k ? tokens[1] : tokens[0];
+                if (cube.size() != k || (bit != "0" && bit != "1") ||
+                    (polarity >= 0 && polarity != bit[0] - '0'))
+                    return false;
+                polarity = bit[0] - '0';
+                for (size_t m = 0; m < (1u << k); m++) {
+                    bool match = true;
+                    for (size_t i = 0; i < k; i++)
+                        if (cube[i] != '-' && cube[i] - '0' != ((m >> i) & 1))
+                            match = false;
+                    if (match) cover |= 1 << m;
+                }
+            }
+            const uint8_t mask = (1 << (1 << k)) - 1;
+            d.table = polarity == 0 ? ~cover & mask : cover;
+            def[out] = d;
+        }
+        else if (cmd == ".subckt" || cmd == ".gate") {
+            BLIFDef d;
+            std::vector<std::string> pins;
+            if (tokens.size() < 2 || !YosysCell(tokens[1], pins, d.table))
+                return false;
+            d.in.resize(pins.size());
+            std::string out;
+            for (size_t t = 2; t < tokens.size(); t++) {
+                const size_t eq = tokens[t].find('=');
+                if (eq == std::string::npos) return false;
+                const std::string pin = tokens[t].substr(0, eq);
+                const std::string net = tokens[t].substr(eq + 1);
+                if (pin == "Y") out = net;
+                for (size_t i = 0; i < pins.size(); i++)
+                    if (pin == pins[i]) d.in[i] = net;
+            }
+            if (out.empty()) return false;
+            for (const std::string &net : d.in)
+                if (net.empty()) return false;
+            def[out] = d;
+            pending = BLIFLine(is, tokens);
+        }
+        else if (cmd == ".end")
+            break;
+        else
+            return false;
+    }
+
+    std::unordered_map<std::string, Circuit::Wire> wire;
+    for (const std::string &name : inputs) wire[name] = res.input();
+
+    // Signals are built depth first from the outputs, so that only the
+    // cone of the outputs is kept. onstack catches combinational loops.
+    std::unordered_map<std::string, bool> onstack;
+    std::vector<std::pair<std::string, bool>> stack;
+    for (const std::string &name : outputs) stack.push_back({name, false});
+    while (!stack.empty()) {
+        auto [name, expanded] = stack.back();
+        stack.pop_back();
+        if (wire.count(name)) continue;
+        const auto it = def.find(name);
+        if (it == def.end()) return false;
+        const BLIFDef &d = it->second;
+        if (!expanded) {
+            if (onstack[name]) return false;
+            onstack[name] = true;
+            stack.push_back({name, true});
+            for (const std::string &in : d.in)
+                if (!wire.count(in)) stack.push_back({in, false});
+            continue;
+        }
+        onstack[name] = false;
+        std::vector<Circuit::Wire> in;
+        for (const std::string &n : d.in) in.push_back(wire.at(n));
+        const uint8_t t = d.table;
+        Circuit::Wire w;
+        if (in.size() == 3) {
+            // Only $_MUX_ has three inputs: (S & B) | (!S & A).
+            w = res.gate(GateOp::OR, res.gate(GateOp::AND, in[2], in[1]),
+                         res.gate(GateOp::ANDNY, in[2], in[0]));
+        }
+        else if (in.size() == 2 && TableOp(t) >= 0)
+            w = res.gate(static_cast<GateOp>(TableOp(t)), in[0], in[1]);
+        else {
+            // Constant, or a copy or NOT of one input.
+            const size_t k = in.size();
+            const uint8_t mask = (1 << (1 << k)) - 1;
+            int from = -1;
+            bool negate = false;
+            for (size_t i = 0; i < k; i++) {
+                uint8_t id = 0;
+                for (size_t m = 0; m < (1u << k); m++)
+                    id |= ((m >> i) & 1) << m;
+                if (t == id) from = i;
+                if (t == (~id & mask)) from = i, negate = true;
+            }
+            if ((t & mask) == 0 || (t & mask) == mask)
+                w = res.constant(t & 1);
+            else if (from < 0)
+                return false;
+            else
+                w = negate ? res.NOT(in[from]) : in[from];
+        }
+        wire[name] = w;
+    }
+    for (const std::string &name : outputs) res.output(wire.at(name));
+    return true;
+}
+
+namespace {
+// A wire of the optimised circuit, maybe negated, or a constant whose
+// value is neg.
+struct Literal {
+    bool constant;
+    Circuit::Wire wire;
+    bool neg;
+};
+
+// The nodes the outputs depend on, and every input.
+Circuit LiveCone(const Circuit &circuit)
+{
+    using Kind = Circuit::Kind;
+    const std::vector<Circuit::Node> &node = circuit.nodes();
+    std::vector<bool> live(node.size());
+    for (const Circuit::Wire w : circuit.outputs()) live[w] = true;
+    for (size_t i = node.size(); i-- > 0;)
+        if (live[i] &&
+            (node[i].kind == Kind::Not || node[i].kind == Kind::Gate)) {
+            live[node[i].a] = true;
+            live[node[i].b] = true;
+        }
+
+    Circuit res;
+    std::vector<Circuit::Wire> wire(node.size());
+    for (size_t i = 0; i < node.size(); i++) {
+        const Circuit::Node &n = node[i];
+        if (n.kind == Kind::Input)
+            wire[i] = res.input();
+        else if (!live[i])
+            continue;
+        else if (n.kind == Kind::Constant)
+            wire[i] = res.constant(n.value);
+        else if (n.kind == Kind::Not)
+            wire[i] = res.NOT(wire[n.a]);
+        else
+            wire[i] = res.gate(n.op, wire[n.a], wire[n.b]);
+    }
+    for (const Circuit::Wire w : circuit.outputs()) res.output(wire[w]);
+    return res;
+}
+}  // namespace
+
+Circuit OptimizeCircuit(const Circuit &circuit, CircuitOptimizeReport *report)
+{
+    using Kind = Circuit::Kind;
+    using Wire = Circuit::Wire;
+    CircuitOptimizeReport r{};
+    r.before = circuit.bootstraps();
+    const Circuit live = LiveCone(circuit);
+    r.removed = r.before - live.bootstraps();
+
+    const std::vector<Circuit::Node> &node = live.nodes();
+    Circuit res;
+    std::vector<Literal> lit(node.size());
+    std::map<std::tuple<uint8_t, Wire, Wire>, Wire> existing;
+
+    // The literal for truth table t over distinct leaves, bit m giving the
+    // value for leaf i = (m >> i) & 1. Leaves t does not depend on are
+    // dropped; kept and found tell what is left and whether the gate
+    // already existed.
+    size_t kept;
+    bool found;
+    auto build = [&](uint8_t t, std::vector<Wire> leaf) -> Literal {
+        for (size_t i = leaf.size(); i-- > 0;) {
+            const size_t k = leaf.size();
+            bool depends = false;
+            for (size_t m = 0; m < (1u << k); m++)
+                if (((t >> m) & 1) != ((t >> (m ^ (1 << i))) & 1))
+                    depends = true;
+            if (depends) continue;
+            uint8_t half = 0;
+            for (size_t m = 0, j = 0; m < (1u << k); m++)
+                if (!((m >> i) & 1)) half |= ((t >> m) & 1) << j++;
+            t = half;
+            leaf.erase(leaf.begin() + i);
+        }
+        kept = leaf.size();
+        found = false;
+        if (leaf.empty()) return {true, 0, static_cast<bool>(t & 1)};
+        if (leaf.size() == 1) return {false, leaf[0], t == 0b01};
+        if (leaf[0] > leaf[1]) {
+            std::swap(leaf[0], leaf[1]);
+            t = (t & 0b1001) | ((t & 0b0010) << 1) | ((t & 0b0100) >> 1);
+        }
+        auto [it, inserted] = existing.try_emplace({t, leaf[0], leaf[1]}, 0);
+        if (inserted)
+            it->second =
+                res.gate(static_cast<GateOp>(TableOp(t)), leaf[0], leaf[1]);
+        found = !inserted;
+        return {false, it->second, false};
+    };
+
+    for (size_t i = 0; i < node.size(); i++) {
+        const Circuit::Node &n = node[i];
+        if (n.kind == Kind::Input) {
+            lit[i] = {false, res.input(), false};
+            continue;
+        }
+        if (n.kind == Kind::Constant) {
+            lit[i] = {true, 0, n.value};
+            continue;
+        }
+        if (n.kind == Kind::Not) {
+            lit[i] = lit[n.a];
+            lit[i].neg = !lit[i].neg;
+            continue;
+        }
+
+        // Look through the gates computing the operands when that leaves
+        // two wires at most, both operands first.
+        const std::array<Literal, 2> operand = {lit[n.a], lit[n.b]};
+        for (const int expand : {3, 1, 2, 0}) {
+            std::vector<Wire> leaf;
+            bool ok = true;
+            for (int o = 0; o < 2; o++) {
+                const Literal &l = operand[o];
+                std::array<Wire, 2> in = {l.wire, l.wire};
+                if ((expand >> o) & 1) {
+                    if (l.constant ||
+                        res.nodes()[l.wire].kind != Kind::Gate) {
+                        ok = false;
+                        break;
+                    }
+                    in = {res.nodes()[l.wire].a, res.nodes()[l.wire].b};
+                }
+                else if (l.constant)
+                    continue;
+                for (const Wire w : in)
+                    if (std::find(leaf.begin(), leaf.end(), w) == leaf.end())
+                        leaf.push_back(w);
+            }
+            if (!ok || leaf.size() > 2) continue;
+
+            auto value = [&](int o, size_t m) {
+                const Literal &l = operand[o];
+                auto leafvalue = [&](Wire w) {
+                    return static_cast<bool>(
+                        (m >> (std::find(leaf.begin(), leaf.end(), w) -
+                               leaf.begin())) &
+                        1);
+                };
+                if (l.constant) return l.neg;
+                if ((expand >> o) & 1) {
+                    const Circuit::Node &g = res.nodes()[l.wire];
+                    return l.neg != GateTruth(g.op, leafvalue(g.a),
+                                              leafvalue(g.b));
+                }
+                return l.neg != leafvalue(l.wire);
+            };
+            uint8_t t = 0;
+            for (size_t m = 0; m < (1u << leaf.size()); m++)
+                t |= GateTruth(n.op, value(0, m), value(1, m)) << m;
+            lit[i] = build(t, leaf);
+
+            if (kept < 2)
+                r.folded++;
+            else if (found)
+                r.shared++;
+            else if (expand)
+                r.merged++;
+            else
+                for (const Literal &l : operand)
+                    if (!l.constant && l.neg) r.absorbed++;
+            break;
+        }
+    }
+
+    for (const Wire w : live.outputs()) {
+        const Literal &l = lit[w];
+        if (l.constant)
+            res.output(res.constant(l.neg));
+        else
+            res.output(l.neg ? res.NOT(l.wire) : l.wire);
+    }
+    Circuit optimized = LiveCone(res);
+    r.removed += res.bootstraps() - optimized.bootstraps();
+    r.after = optimized.bootstraps();
+    if (report) *report = r;
+    return optimized;
+}
+
+#define INST(iksP, brP, mu)                                          \
+    template void EvalCircuit<iksP, brP, mu>(                        \
+        std::vector<TLWE<typename brP::targetP>> & res,              \
+        const Circuit &circuit, const CircuitSchedule &schedule,     \
+        const std::vector<TLWE<typename iksP::domainP>> &in,         \
+        const EvalKey &ek, std::vector<CircuitLevelStats> *stats)
+TFHEPP_EXPLICIT_INSTANTIATION_GATE_IKSBR(INST)
+#undef INST
+
+}  // namespace TFHEpp
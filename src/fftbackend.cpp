@@ -0,0 +1,162 @@
+#include <fftbackend.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include <fft_processor_simd.h>
+#ifdef USE_FFTW3
+#include <fft_processor_fftw.h>
+#endif
+#ifdef USE_FPGA
+#include <fft_processor_fpga.h>
+#endif
+
+namespace TFHEpp {
+
+namespace {
+
+struct FFTRegistry {
+    std::mutex mtx;
+    std::map<std::string, std::unique_ptr<FFTEngine>> engines;
+    std::vector<std::unique_ptr<FFTBackend>> backends;
+
+    FFTBackend *own(std::unique_ptr<FFTBackend> backend)
+    {
+        backends.push_back(std::move(backend));
+        return backends.back().get();
+    }
+
+    bool add(const std::string &name, FFTBackend *lvl1, FFTBackend *lvl2)
+    {
+        return engines
+            .emplace(name, std::make_unique<FFTEngine>(
+                               FFTEngine{name, lvl1, lvl2}))
+            .second;
+    }
+
+    const FFTEngine *find(const std::string &name)
+    {
+        auto it = engines.find(name);
+        return it == engines.end() ? nullptr : it->second.get();
+    }
+
+    FFTRegistry()
+    {
+        FFTBackend *simd1 =
+            own(std::make_unique<FFTBackendAdapter<
+                    FFT_Processor_SIMD<lvl1param::n>>>(fftsimdlvl1));
+        FFTBackend *simd2 =
+            own(std::make_unique<FFTBackendAdapter<
+                    FFT_Processor_SIMD<lvl2param::n>>>(fftsimdlvl2));
+        add("simd", simd1, simd2);
+        FFTBackend *cpu2 = simd2;
+#ifdef USE_FFTW3
+        FFTBackend *fftw2 = own(
+            std::make_unique<FFTBackendAdapter<FFT_Processor_FFTW>>(fftplvl2));
+        add("fftw",
+            own(std::make_unique<FFTBackendAdapter<FFT_Processor_FFTW>>(
+                fftplvl1)),
+            fftw2);
+#ifndef USE_SIMD_FFT
+        cpu2 = fftw2;
+#endif
+#endif
+#ifdef USE_FPGA
+        // The FPGA kernel is single precision and sized for lvl1 only; lvl2
+        // stays on the CPU engine. The host buffers are shared, so calls
+        // are serialised.
+        if (fftFpgaLvl1.available())
+            add("fpga",
+                own(std::make_unique<
+                    FFTBackendAdapter<FFT_Processor_FPGA, std::mutex>>(
+                    fftFpgaLvl1)),
+                cpu2);
+#else
+        static_cast<void>(cpu2);
+#endif
+    }
+};
+
+FFTRegistry &registry()
+{
+    static FFTRegistry reg;
+    return reg;
+}
+
+const char *default_engine_name()
+{
+#ifdef USE_FPGA
+    if (registry().find("fpga")) return "fpga";
+#endif
+#if defined(USE_SIMD_FFT) || !defined(USE_FFTW3)
+    return "simd";
+#else
+    return "fftw";
+#endif
+}
+
+}  // namespace
+
+bool RegisterFFTEngine(const std::string &name, FFTBackend *lvl1,
+                       FFTBackend *lvl2)
+{
+    FFTRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    return reg.add(name, lvl1, lvl2);
+}
+
+std::vector<std::string> FFTEngineNames()
+{
+    FFTRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    std::vector<std::string> names;
+    for (const auto &e : reg.engines) names.push_back(e.first);
+    return names;
+}
+
+bool SelectFFTEngine(const std::string &name)
+{
+    FFTRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    const FFTEngine *e = reg.find(name);
+    if (e == nullptr) return false;
+    detail::default_fftengine.store(e, std::memory_order_release);
+    return true;
+}
+
+bool SelectThreadFFTEngine(const std::string &name)
+{
+    if (name.empty()) {
+        detail::thread_fftengine = nullptr;
+        return true;
+    }
+    FFTRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    const FFTEngine *e = reg.find(name);
+    if (e == nullptr) return false;
+    detail::thread_fftengine = e;
+    return true;
+}
+
+namespace detail {
+const FFTEngine &InitDefaultFFTEngine()
+{
+    FFTRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mtx);
+    if (const FFTEngine *e = default_fftengine.load()) return *e;
+    const FFTEngine *e = nullptr;
+    if (const char *env = std::getenv("TFHEPP_FFT_BACKEND")) {
+        e = reg.find(env);
+        if (e == nullptr)
+            std::cerr << "TFHEPP_FFT_BACKEND: unknown FFT backend " << env
+                      << ", using " << default_engine_name() << std::endl;
+    }
+    if (e == nullptr) e = reg.find(default_engine_name());
+    default_fftengine.store(e, std::memory_order_release);
+    return *e;
+}
+}  // namespace detail
+
+}  // namespace TFHEpp
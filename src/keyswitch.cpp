@@ -9,6 +9,14 @@ namespace TFHEpp {
 TFHEPP_EXPLICIT_INSTANTIATION_KEY_SWITCH_TO_TLWE(INST)
 #undef INST
 
+#define INST(P)                                                   \
+    template void IdentityKeySwitchbatch<P>(                  \
+        TLWE<typename P::targetP> * res,                          \
+        const TLWE<typename P::domainP> *tlwe, size_t batch,      \
+        const KeySwitchingKey<P> &ksk)
+TFHEPP_EXPLICIT_INSTANTIATION_KEY_SWITCH_TO_TLWE(INST)
+#undef INST
+
 #define INST(P)                                \
     template void SubsetIdentityKeySwitch<P>(  \
         TLWE<typename P::targetP> & res,       \
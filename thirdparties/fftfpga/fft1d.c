@@ -5,6 +5,9 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <errno.h>
 #define CL_VERSION_2_0
 #include <CL/cl_ext_intelfpga.h> // to disable interleaving & transfer data to specific banks - CL_CHANNEL_1_INTELFPGA
 #include "CL/opencl.h"
@@ -15,612 +18,463 @@
 #include "opencl_utils.h"
 #include "misc.h"
 
-typedef struct thread_data {
+#define NUM_CHANNELS 4
+// A batch is cut into about this many chunks per channel; channels take
+// the next chunk as soon as they are idle.
+#define CHUNKS_PER_CHANNEL 2
+#define QUEUE_SIZE 64
+
+/**
+ * Persistent state of one of the four FFT pipelines of the bitstream
+ * (fetch/fft1d, fetch_2/fft1d_2, ...). Every pipeline works on its own
+ * memory bank with its own pair of command queues. Queues, kernels and
+ * buffers are created on first use and kept until fpga_final(), so a
+ * transform only copies the data, sets the batch and direction arguments
+ * and launches the kernels.
+ */
+typedef struct fft_channel {
+    cl_command_queue *queue_fft;    // fft1d kernel and transfers
+    cl_command_queue *queue_fetch;  // fetch kernel
+    void (*queue_setup)();
+    void (*queue_cleanup)();
+    const char *fetch_name;
+    const char *fft_name;
+    cl_mem_flags bank;
+    unsigned cpu;                   // host core driving this channel
+    pthread_mutex_t lock;           // held while a transform runs on it
+    pthread_t worker;
+
+    atomic_ullong transforms;       // utilisation counters
+    atomic_ullong launches;
+    atomic_ullong busy_ns;
+
+    cl_kernel fetch_kernel;
+    cl_kernel fft_kernel;
+    cl_mem d_inData;
+    cl_mem d_outData;
+    size_t capacity;                // float2 elements per buffer
+} fft_channel;
+
+static fft_channel channels[NUM_CHANNELS] = {
+    {&queue1, &queue2, queue_setup_1, queue_cleanup_1, "fetch", "fft1d", CL_CHANNEL_1_INTELFPGA, 51, PTHREAD_MUTEX_INITIALIZER},
+    {&queue3, &queue4, queue_setup_2, queue_cleanup_2, "fetch_2", "fft1d_2", CL_CHANNEL_2_INTELFPGA, 52, PTHREAD_MUTEX_INITIALIZER},
+    {&queue5, &queue6, queue_setup_3, queue_cleanup_3, "fetch_3", "fft1d_3", CL_CHANNEL_3_INTELFPGA, 53, PTHREAD_MUTEX_INITIALIZER},
+    {&queue7, &queue8, queue_setup_4, queue_cleanup_4, "fetch_4", "fft1d_4", CL_CHANNEL_4_INTELFPGA, 54, PTHREAD_MUTEX_INITIALIZER},
+};
+
+/**
+ * One fftfpgaf_c2c_1d call. Each channel adds the timings of the chunks it
+ * ran to its own slot, the last chunk to finish posts done.
+ */
+typedef struct fft_job {
     unsigned N;
     const float2 *inp;
     float2 *out;
     int inverse_int;
-    unsigned batch;
-} thread_data;
-
+    atomic_uint remaining;
+    sem_t done;
+    fpga_t times[NUM_CHANNELS];
+} fft_job;
+
+// count transforms starting at first; a NULL job stops the worker
+typedef struct fft_chunk {
+    fft_job *job;
+    unsigned first;
+    unsigned count;
+} fft_chunk;
 
 /**
- * \brief  compute an out-of-place single precision complex 1D-FFT on the FPGA
- * \param  N    : unsigned integer to the number of points in FFT1d  
- * \param  inp  : float2 pointer to input data of size N
- * \param  out  : float2 pointer to output data of size N
- * \param  inv  : toggle for backward transforms
- * \param  batch : number of batched executions of 1D FFT
- * \return fpga_t : time taken in milliseconds for data transfers and execution
+ * Bounded lock-free multi-producer multi-consumer queue of chunks
+ * (D. Vyukov's sequence-numbered ring). The semaphore counts published
+ * chunks so idle workers sleep instead of spinning.
  */
+typedef struct chunk_cell {
+    atomic_size_t seq;
+    fft_chunk chunk;
+} chunk_cell;
+
+static chunk_cell queue_cells[QUEUE_SIZE];
+static atomic_size_t queue_head, queue_tail;
+static sem_t queue_items;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool pool_running = false;
+
+static bool queue_push(const fft_chunk *chunk){
+    size_t pos = atomic_load_explicit(&queue_head, memory_order_relaxed);
+    chunk_cell *cell;
+    for(;;){
+        cell = &queue_cells[pos & (QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if(dif == 0){
+            if(atomic_compare_exchange_weak_explicit(&queue_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if(dif < 0)
+            return false;  // full
+        else
+            pos = atomic_load_explicit(&queue_head, memory_order_relaxed);
+    }
+    cell->chunk = *chunk;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
 
+static bool queue_pop(fft_chunk *chunk){
+    size_t pos = atomic_load_explicit(&queue_tail, memory_order_relaxed);
+    chunk_cell *cell;
+    for(;;){
+        cell = &queue_cells[pos & (QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if(dif == 0){
+            if(atomic_compare_exchange_weak_explicit(&queue_tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if(dif < 0)
+            return false;  // empty
+        else
+            pos = atomic_load_explicit(&queue_tail, memory_order_relaxed);
+    }
+    *chunk = cell->chunk;
+    atomic_store_explicit(&cell->seq, pos + QUEUE_SIZE, memory_order_release);
+    return true;
+}
 
-fpga_t fftfpgaf_c2c_1d_proc_1(const unsigned N, const float2 *inp, float2 *out, int inverse_int, const unsigned batch){
-
-    cpu_set_t cpuset;
-    pthread_t thread;
-    thread = pthread_self();
-    CPU_ZERO(&cpuset);
-    CPU_SET(51, &cpuset); //setting thread affinity to CPU 51
-    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+static void post_chunk(const fft_chunk *chunk){
+    while(!queue_push(chunk))
+        sched_yield();
+    sem_post(&queue_items);
+}
 
-    //int cpu = sched_getcpu();
-    //printf(" a: %d\n ", cpu);
+static void release_buffers(fft_channel *ch){
+    if(ch->d_inData)
+        clReleaseMemObject(ch->d_inData);
+    if(ch->d_outData)
+        clReleaseMemObject(ch->d_outData);
+    ch->d_inData = NULL;
+    ch->d_outData = NULL;
+    ch->capacity = 0;
+}
 
-    fpga_t fft_time = {0.0, 0.0, 0.0, 0};
-    cl_kernel kernel1 = NULL, kernel2 = NULL;
+/**
+ * \brief  make sure the channel has its queues, kernels and buffers for
+ *         at least sz points. Buffers only ever grow; the kernels are
+ *         bound to them again when they do.
+ */
+static void channel_reserve(fft_channel *ch, const size_t sz){
     cl_int status = 0;
-    cl_mem d_inData, d_outData;
-
-    queue_setup_1();
 
-    // Create device buffers - assign the buffers in different banks for more efficient memory access
-    d_inData = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate input device buffer\n");
+    if(ch->fft_kernel == NULL){
+        ch->queue_setup();
 
-    d_outData = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate output device buffer\n");
+        // Create Kernels - names must match the kernel name in the original CL file
+        ch->fetch_kernel = clCreateKernel(program, ch->fetch_name, &status);
+        checkError(status, "Failed to create %s kernel", ch->fetch_name);
+        ch->fft_kernel = clCreateKernel(program, ch->fft_name, &status);
+        checkError(status, "Failed to create %s kernel", ch->fft_name);
+    }
 
+    if(sz <= ch->capacity)
+        return;
 
-    //printf("-- Copying data from host to device\n");
-    // Copy data from host to device
-    status = clEnqueueWriteBuffer(queue1, d_inData, CL_TRUE, 0, sizeof(float2) * N * batch, inp, 0, NULL, NULL);
-    checkError(status, "Failed to copy data to device");
+    release_buffers(ch);
 
-    status = clFinish(queue1);
-    checkError(status, "failed to finish writing buffer using queue1");
+    // Create device buffers - assign the buffers in different banks for more efficient memory access
+    ch->d_inData = clCreateBuffer(context, CL_MEM_READ_ONLY | ch->bank, sizeof(float2) * sz, NULL, &status);
+    checkError(status, "Failed to allocate input device buffer for %s\n", ch->fetch_name);
+    ch->d_outData = clCreateBuffer(context, CL_MEM_WRITE_ONLY | ch->bank, sizeof(float2) * sz, NULL, &status);
+    checkError(status, "Failed to allocate output device buffer for %s\n", ch->fft_name);
+    ch->capacity = sz;
+
+    status = clSetKernelArg(ch->fetch_kernel, 0, sizeof(cl_mem), (void *)&ch->d_inData);
+    checkError(status, "Failed to set %s arg 0", ch->fetch_name);
+    status = clSetKernelArg(ch->fft_kernel, 0, sizeof(cl_mem), (void *)&ch->d_outData);
+    checkError(status, "Failed to set %s arg 0", ch->fft_name);
+}
 
-    // Create Kernels - names must match the kernel name in the original CL file
-    kernel1 = clCreateKernel(program, "fetch", &status);
-    checkError(status, "Failed to create fetch kernel1");
+/**
+ * \brief  run batch N-point transforms on one channel
+ * \return fpga_t : time taken in milliseconds for data transfers and execution
+ */
+static fpga_t channel_fft(fft_channel *ch, const unsigned N, const float2 *inp, float2 *out, int inverse_int, const unsigned batch){
 
-    kernel2 = clCreateKernel(program, "fft1d", &status);
-    checkError(status, "Failed to create fft1d kernel2");
+    fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
+    cl_int status = 0;
+    const size_t sz = (size_t)N * batch;
 
+    channel_reserve(ch, sz);
+    cl_command_queue queue_fft = *ch->queue_fft;
+    cl_command_queue queue_fetch = *ch->queue_fetch;
 
-    // Set the kernel arguments
-    status = clSetKernelArg(kernel1, 0, sizeof(cl_mem), (void *)&d_inData);
-    checkError(status, "Failed to set kernel1 arg 0");
-    status = clSetKernelArg(kernel2, 0, sizeof(cl_mem), (void *)&d_outData);
-    checkError(status, "Failed to set kernel2 arg 0");
-    status = clSetKernelArg(kernel2, 1, sizeof(cl_int), (void*)&batch);
-    checkError(status, "Failed to set kernel2 arg 1");
-    status = clSetKernelArg(kernel2, 2, sizeof(cl_int), (void*)&inverse_int);
-    checkError(status, "Failed to set kernel2 arg 2");
+    // Copy data from host to device
+    double start = getTimeinMilliSec();
+    status = clEnqueueWriteBuffer(queue_fft, ch->d_inData, CL_TRUE, 0, sizeof(float2) * sz, inp, 0, NULL, NULL);
+    checkError(status, "Failed to copy data to device");
+    status = clFinish(queue_fft);
+    checkError(status, "failed to finish writing buffer");
+    fft_time.pcie_write_t = getTimeinMilliSec() - start;
 
+    // Only the batch size and the direction change between calls
+    cl_int batch_int = (cl_int)batch;
+    status = clSetKernelArg(ch->fft_kernel, 1, sizeof(cl_int), (void*)&batch_int);
+    checkError(status, "Failed to set %s arg 1", ch->fft_name);
+    status = clSetKernelArg(ch->fft_kernel, 2, sizeof(cl_int), (void*)&inverse_int);
+    checkError(status, "Failed to set %s arg 2", ch->fft_name);
 
     size_t ls = N/8;
     size_t gs = batch * ls;
 
-    //printf("-- Executing kernels\n");
     cl_event startExec_event, endExec_event;
 
-    // Measure execution time
     // Launch the kernel - we launch a single work item hence enqueue a task
     // FFT1d kernel is the SWI kernel
-    status = clEnqueueTask(queue1, kernel2, 0, NULL, &endExec_event);
-    checkError(status, "Failed to launch fft1d kernel2");
+    status = clEnqueueTask(queue_fft, ch->fft_kernel, 0, NULL, &endExec_event);
+    checkError(status, "Failed to launch %s kernel", ch->fft_name);
 
-    status = clEnqueueNDRangeKernel(queue2, kernel1, 1, NULL, &gs, &ls, 0, NULL, &startExec_event);
-    checkError(status, "Failed to launch fetch kernel1");
+    status = clEnqueueNDRangeKernel(queue_fetch, ch->fetch_kernel, 1, NULL, &gs, &ls, 0, NULL, &startExec_event);
+    checkError(status, "Failed to launch %s kernel", ch->fetch_name);
 
     // Wait for command queue to complete pending events
-    status = clFinish(queue1);
-    checkError(status, "Failed to finish queue1");
-    status = clFinish(queue2);
-    checkError(status, "Failed to finish queue2");
-
+    status = clFinish(queue_fft);
+    checkError(status, "Failed to finish %s queue", ch->fft_name);
+    status = clFinish(queue_fetch);
+    checkError(status, "Failed to finish %s queue", ch->fetch_name);
 
     // Record execution time
     cl_ulong kernel_start = 0, kernel_end = 0;
     clGetEventProfilingInfo(startExec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
     clGetEventProfilingInfo(endExec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
     fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
+    clReleaseEvent(startExec_event);
+    clReleaseEvent(endExec_event);
 
     // Copy results from device to host
-    //printf("-- Transferring results back to host\n");
-    status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * N * batch, out, 0, NULL, NULL);
-    checkError(status, "Failed to copy data from queue1");
-
-    status = clFinish(queue1);
-    checkError(status, "failed to finish reading buffer using queue1");
-
-
-    // Cleanup
-    if (d_inData)
-        clReleaseMemObject(d_inData);
-    if (d_outData)
-        clReleaseMemObject(d_outData);
-
-    if(kernel1)
-        clReleaseKernel(kernel1);
-    if(kernel2)
-        clReleaseKernel(kernel2);
-
-    queue_cleanup_1();
+    start = getTimeinMilliSec();
+    status = clEnqueueReadBuffer(queue_fft, ch->d_outData, CL_TRUE, 0, sizeof(float2) * sz, out, 0, NULL, NULL);
+    checkError(status, "Failed to copy data from device");
+    status = clFinish(queue_fft);
+    checkError(status, "failed to finish reading buffer");
+    fft_time.pcie_read_t = getTimeinMilliSec() - start;
 
     fft_time.valid = 1;
     return fft_time;
 }
 
-void *fftfpgaf_c2c_1d_proc_2(void *arg) {
-
+static void pin_to_cpu(const unsigned cpu){
     cpu_set_t cpuset;
-    pthread_t thread;
-    thread = pthread_self();
     CPU_ZERO(&cpuset);
-    CPU_SET(52, &cpuset); //setting thread affinity to CPU 52
-    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
-
-    //int cpu = sched_getcpu();
-    //printf(" b: %d\n ", cpu);
-
-    thread_data *data = (thread_data *)arg;
-    const unsigned N = data->N;
-    const float2 *inp = data->inp;
-    float2 *out = data->out;
-    int inverse_int = data->inverse_int;
-    const unsigned batch = data->batch;
-
-    cl_kernel kernel3 = NULL, kernel4 = NULL;
-    cl_int status = 0;
-    const float2 *inp_2 =  inp + (N*batch);
-    float2 *out_2 =  out + (N*batch);
-
-    queue_setup_2();
-
-    cl_mem d_inData_2, d_outData_2;
-
-    // Create device buffers - assign the buffers in different banks for more efficient memory access
-
-    d_inData_2 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate input d_inData_2 buffer\n");
-    d_outData_2 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate output d_outData_2 buffer\n");
-
-
-
-    //printf("-- Copying data from host to device\n");
-    // Copy data from host to device
-    status = clEnqueueWriteBuffer(queue3, d_inData_2, CL_TRUE, 0, sizeof(float2) * N * batch, inp_2, 0, NULL, NULL);
-    checkError(status, "Failed to copy data to d_inData_2");
-
-    status = clFinish(queue3);
-    checkError(status, "failed to finish writing buffer using queue3");
-
-    // Create Kernels - names must match the kernel name in the original CL file
-    kernel3 = clCreateKernel(program, "fetch_2", &status);
-    checkError(status, "Failed to create fetch kernel3");
-
-    kernel4 = clCreateKernel(program, "fft1d_2", &status);
-    checkError(status, "Failed to create fft1d kernel4");
-
-    // Set the kernel arguments
-    status = clSetKernelArg(kernel3, 0, sizeof(cl_mem), (void *)&d_inData_2);
-    checkError(status, "Failed to set kernel3 arg 0");
-    status = clSetKernelArg(kernel4, 0, sizeof(cl_mem), (void *)&d_outData_2);
-    checkError(status, "Failed to set kernel4 arg 0");
-    status = clSetKernelArg(kernel4, 1, sizeof(cl_int), (void*)&batch);
-    checkError(status, "Failed to set kernel4 arg 1");
-    status = clSetKernelArg(kernel4, 2, sizeof(cl_int), (void*)&inverse_int);
-    checkError(status, "Failed to set kernel4 arg 2");
-
-
-    size_t ls = N/8;
-    size_t gs = batch * ls;
-
-    //printf("-- Executing kernels\n");
-    cl_event startExec_event_2, endExec_event_2;
-
-    // Measure execution time
-    // Launch the kernel - we launch a single work item hence enqueue a task
-    // FFT1d kernel is the SWI kernel
-
-    status = clEnqueueTask(queue3, kernel4, 0, NULL, &endExec_event_2);
-    checkError(status, "Failed to launch fft1d kernel4");
-
-
-    status = clEnqueueNDRangeKernel(queue4, kernel3, 1, NULL, &gs, &ls, 0, NULL, &startExec_event_2);
-    checkError(status, "Failed to launch fetch kernel3");
-
-    // Wait for command queue to complete pending events
-    status = clFinish(queue3);
-    checkError(status, "Failed to finish queue3");
-    status = clFinish(queue4);
-    checkError(status, "Failed to finish queue4");
-
-    status = clEnqueueReadBuffer(queue3, d_outData_2, CL_TRUE, 0, sizeof(float2) * N * batch, out_2, 0, NULL, NULL);
-    checkError(status, "Failed to copy data from queue3");
-
-    status = clFinish(queue3);
-    checkError(status, "failed to finish reading buffer using queue3");
-
-
-    // Cleanup
-    if (d_inData_2)
-        clReleaseMemObject(d_inData_2);
-    if (d_outData_2)
-        clReleaseMemObject(d_outData_2);
-
-
-    if(kernel3)
-        clReleaseKernel(kernel3);
-    if(kernel4)
-        clReleaseKernel(kernel4);
-
-    queue_cleanup_2();
-    pthread_exit(NULL);
-
+    CPU_SET(cpu, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
 }
 
-void *fftfpgaf_c2c_1d_proc_3(void *arg) {
-
-    cpu_set_t cpuset;
-    pthread_t thread;
-    thread = pthread_self();
-    CPU_ZERO(&cpuset);
-    CPU_SET(53, &cpuset); //setting thread affinity to CPU 53
-    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
-
-    //int cpu = sched_getcpu();
-    //printf(" c: %d\n ", cpu);
-
-    thread_data *data = (thread_data *)arg;
-    const unsigned N = data->N;
-    const float2 *inp = data->inp;
-    float2 *out = data->out;
-    int inverse_int = data->inverse_int;
-    const unsigned batch = data->batch;
-    cl_kernel kernel5 = NULL, kernel6 = NULL;
-    cl_int status = 0;
-
-    const float2 *inp_3 =  inp + (N*batch*2);
-    float2 *out_3 =  out + (N*batch*2);
-
-    //printf("-- Launching%s 1D FFT of %d batches \n", inv ? " inverse":"", batch);
-
-    queue_setup_3();
-    cl_mem d_inData_3, d_outData_3;
-    //printf("Launching%s FFT transform for %d batch \n", inv ? " inverse":"", batch);
-
-    // Create device buffers - assign the buffers in different banks for more efficient memory access
-    d_inData_3 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate input d_inData_3 buffer\n");
-
-    d_outData_3 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_3_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate output d_outData_3 buffer\n");
-
-
-    //printf("-- Copying data from host to device\n");
-    // Copy data from host to device
-
-    status = clEnqueueWriteBuffer(queue5, d_inData_3, CL_TRUE, 0, sizeof(float2) * N * batch, inp_3, 0, NULL, NULL);
-    checkError(status, "Failed to copy data to d_inData_3");
-
-    status = clFinish(queue5);
-    checkError(status, "failed to finish writing buffer using queue5");
-
-    // Create Kernels - names must match the kernel name in the original CL file
-    kernel5 = clCreateKernel(program, "fetch_3", &status);
-    checkError(status, "Failed to create fetch kernel5");
-
-    kernel6 = clCreateKernel(program, "fft1d_3", &status);
-    checkError(status, "Failed to create fft1d kernel6");
-
-
-    // Set the kernel arguments
-    status = clSetKernelArg(kernel5, 0, sizeof(cl_mem), (void *)&d_inData_3);
-    checkError(status, "Failed to set kernel5 arg 0");
-    status = clSetKernelArg(kernel6, 0, sizeof(cl_mem), (void *)&d_outData_3);
-    checkError(status, "Failed to set kernel6 arg 0");
-    status = clSetKernelArg(kernel6, 1, sizeof(cl_int), (void*)&batch);
-    checkError(status, "Failed to set kernel6 arg 1");
-    status = clSetKernelArg(kernel6, 2, sizeof(cl_int), (void*)&inverse_int);
-    checkError(status, "Failed to set kernel6 arg 2");
-
-    size_t ls = N/8;
-    size_t gs = batch * ls;
-
-    //printf("-- Executing kernels\n");
-    cl_event startExec_event_3, endExec_event_3;
-    // Measure execution time
-    // Launch the kernel - we launch a single work item hence enqueue a task
-    // FFT1d kernel is the SWI kernel
-    status = clEnqueueTask(queue5, kernel6, 0, NULL, &endExec_event_3);
-    checkError(status, "Failed to launch fft1d kernel6");
-
-    status = clEnqueueNDRangeKernel(queue6, kernel5, 1, NULL, &gs, &ls, 0, NULL, &startExec_event_3);
-    checkError(status, "Failed to launch fetch kernel5");
-
-    // Wait for command queue to complete pending events
-    status = clFinish(queue5);
-    checkError(status, "Failed to finish queue5");
-    status = clFinish(queue6);
-    checkError(status, "Failed to finish queue6");
-
-
-    // Copy results from device to host
-    //printf("-- Transferring results back to host\n");
-    status = clEnqueueReadBuffer(queue5, d_outData_3, CL_TRUE, 0, sizeof(float2) * N * batch, out_3, 0, NULL, NULL);
-    checkError(status, "Failed to copy data from queue5");
-
-    status = clFinish(queue5);
-    checkError(status, "failed to finish reading buffer using queue5");
-
-    // Cleanup
-    if (d_inData_3)
-        clReleaseMemObject(d_inData_3);
-    if (d_outData_3)
-        clReleaseMemObject(d_outData_3);
-
-    if(kernel5)
-        clReleaseKernel(kernel5);
-    if(kernel6)
-        clReleaseKernel(kernel6);
-
-    queue_cleanup_3();
-    pthread_exit(NULL);
+/**
+ * \brief  run a transform on a channel and account for it
+ */
+static fpga_t channel_run(fft_channel *ch, const unsigned N, const float2 *inp, float2 *out, int inverse_int, const unsigned batch){
+    pthread_mutex_lock(&ch->lock);
+    double start = getTimeinMilliSec();
+    fpga_t t = channel_fft(ch, N, inp, out, inverse_int, batch);
+    double busy = getTimeinMilliSec() - start;
+    pthread_mutex_unlock(&ch->lock);
+
+    atomic_fetch_add_explicit(&ch->transforms, batch, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ch->launches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ch->busy_ns, (unsigned long long)(busy * 1e6), memory_order_relaxed);
+    return t;
 }
 
-void *fftfpgaf_c2c_1d_proc_4(void *arg) {
-
-    cpu_set_t cpuset;
-    pthread_t thread;
-    thread = pthread_self();
-    CPU_ZERO(&cpuset);
-    CPU_SET(54, &cpuset); //setting thread affinity to CPU 54
-    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
-
-    //int cpu = sched_getcpu();
-    //printf(" d: %d\n ", cpu);
-
-    thread_data *data = (thread_data *)arg;
-    const unsigned N = data->N;
-    const float2 *inp = data->inp;
-    float2 *out = data->out;
-    int inverse_int = data->inverse_int;
-    const unsigned batch = data->batch;
-
-    cl_kernel  kernel7 = NULL, kernel8 = NULL;
-    cl_int status = 0;
-
-    const float2 *inp_4 =  inp + (N*batch*3);
-    float2 *out_4 =  out + (N*batch*3);
-
-    queue_setup_4();
-    cl_mem  d_inData_4, d_outData_4;
-    //printf("Launching%s FFT transform for %d batch \n", inv ? " inverse":"", batch);
-
-    // Create device buffers - assign the buffers in different banks for more efficient memory access
-
-    d_inData_4 = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate input d_inData_4 buffer\n");
-
-    d_outData_4 = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_4_INTELFPGA, sizeof(float2) * N * batch, NULL, &status);
-    checkError(status, "Failed to allocate output d_outData_4 buffer\n");
-
-    //printf("-- Copying data from host to device\n");
-    // Copy data from host to device
-    status = clEnqueueWriteBuffer(queue7, d_inData_4, CL_TRUE, 0, sizeof(float2) * N * batch, inp_4, 0, NULL, NULL);
-    checkError(status, "Failed to copy data to d_inData_4");
-
-    status = clFinish(queue7);
-    checkError(status, "failed to finish writing buffer using queue7");
-
-    // Create Kernels - names must match the kernel name in the original CL file
-
-    kernel7 = clCreateKernel(program, "fetch_4", &status);
-    checkError(status, "Failed to create fetch kernel7");
-
-    kernel8 = clCreateKernel(program, "fft1d_4", &status);
-    checkError(status, "Failed to create fft1d kernel8");
-
+static void *channel_worker(void *arg) {
+    fft_channel *ch = (fft_channel *)arg;
+    const unsigned c = ch - channels;
+    pin_to_cpu(ch->cpu);
+
+    for(;;){
+        while(sem_wait(&queue_items) != 0 && errno == EINTR)
+            ;
+        fft_chunk chunk;
+        // a producer that took an earlier slot may still be writing it
+        while(!queue_pop(&chunk))
+            sched_yield();
+        fft_job *job = chunk.job;
+        if(job == NULL)
+            break;
+
+        const size_t offset = (size_t)job->N * chunk.first;
+        fpga_t t = channel_run(ch, job->N, job->inp + offset, job->out + offset, job->inverse_int, chunk.count);
+        job->times[c].pcie_write_t += t.pcie_write_t;
+        job->times[c].exec_t += t.exec_t;
+        job->times[c].pcie_read_t += t.pcie_read_t;
+
+        if(atomic_fetch_sub(&job->remaining, 1) == 1)
+            sem_post(&job->done);
+    }
+    return NULL;
+}
 
-    // Set the kernel arguments
-    status = clSetKernelArg(kernel7, 0, sizeof(cl_mem), (void *)&d_inData_4);
-    checkError(status, "Failed to set kernel7 arg 0");
-    status = clSetKernelArg(kernel8, 0, sizeof(cl_mem), (void *)&d_outData_4);
-    checkError(status, "Failed to set kernel8 arg 0");
-    status = clSetKernelArg(kernel8, 1, sizeof(cl_int), (void*)&batch);
-    checkError(status, "Failed to set kernel8 arg 1");
-    status = clSetKernelArg(kernel8, 2, sizeof(cl_int), (void*)&inverse_int);
-    checkError(status, "Failed to set kernel8 arg 2");
+static bool pool_start(){
+    bool ok = true;
+    pthread_mutex_lock(&pool_lock);
+    if(!pool_running){
+        for(size_t i = 0; i < QUEUE_SIZE; i++)
+            atomic_init(&queue_cells[i].seq, i);
+        atomic_init(&queue_head, 0);
+        atomic_init(&queue_tail, 0);
+        sem_init(&queue_items, 0, 0);
+        unsigned started = 0;
+        for(; started < NUM_CHANNELS; started++){
+            int rc = pthread_create(&channels[started].worker, NULL, channel_worker, &channels[started]);
+            if(rc){
+                printf("ERROR; return code from pthread_create() is %d\n", rc);
+                break;
+            }
+        }
+        if(started < NUM_CHANNELS){
+            fft_chunk stop = {NULL, 0, 0};
+            for(unsigned c = 0; c < started; c++)
+                post_chunk(&stop);
+            for(unsigned c = 0; c < started; c++)
+                pthread_join(channels[c].worker, NULL);
+            sem_destroy(&queue_items);
+            ok = false;
+        }
+        pool_running = ok;
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return ok;
+}
 
-    size_t ls = N/8;
-    size_t gs = batch * ls;
+static void pool_stop(){
+    pthread_mutex_lock(&pool_lock);
+    if(pool_running){
+        fft_chunk stop = {NULL, 0, 0};
+        for(unsigned c = 0; c < NUM_CHANNELS; c++)
+            post_chunk(&stop);
+        for(unsigned c = 0; c < NUM_CHANNELS; c++)
+            pthread_join(channels[c].worker, NULL);
+        sem_destroy(&queue_items);
+        pool_running = false;
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
 
-    //printf("-- Executing kernels\n");
-    cl_event  startExec_event_4, endExec_event_4;
-    // Measure execution time
-    // Launch the kernel - we launch a single work item hence enqueue a task
-    // FFT1d kernel is the SWI kernel
-    status = clEnqueueTask(queue7, kernel8, 0, NULL, &endExec_event_4);
-    checkError(status, "Failed to launch fft1d kernel8");
-    status = clEnqueueNDRangeKernel(queue8, kernel7, 1, NULL, &gs, &ls, 0, NULL, &startExec_event_4);
-    checkError(status, "Failed to launch fetch kernel7");
+static unsigned chunk_size(const unsigned batch){
+    const unsigned chunks = NUM_CHANNELS * CHUNKS_PER_CHANNEL;
+    unsigned size = (batch + chunks - 1) / chunks;
+    return size == 0 ? 1 : size;
+}
 
-    // Wait for command queue to complete pending events
-    status = clFinish(queue7);
-    checkError(status, "Failed to finish queue7");
-    status = clFinish(queue8);
-    checkError(status, "Failed to finish queue8");
+bool fftfpgaf_c2c_1d_reserve(const unsigned N, const unsigned max_batch){
+    if(program == NULL || N == 0 || ( (N & (N-1)) !=0))
+        return false;
 
+    // fftfpgaf_c2c_1d hands out chunks of a batch to whichever channel is
+    // idle, fftfpgaf_c2c_1d_ uses the first one
+    for(unsigned c = 0; c < NUM_CHANNELS; c++){
+        pthread_mutex_lock(&channels[c].lock);
+        channel_reserve(&channels[c], (size_t)N * chunk_size(max_batch));
+        pthread_mutex_unlock(&channels[c].lock);
+    }
+    return pool_start();
+}
 
-    // Copy results from device to host
-    //printf("-- Transferring results back to host\n");
-    status = clEnqueueReadBuffer(queue7, d_outData_4, CL_TRUE, 0, sizeof(float2) * N * batch, out_4, 0, NULL, NULL);
-    checkError(status, "Failed to copy data from queue7");
-
-    status = clFinish(queue7);
-    checkError(status, "failed to finish reading buffer using queue7");
-
-
-    // Cleanup
-    if (d_inData_4)
-        clReleaseMemObject(d_inData_4);
-    if (d_outData_4)
-        clReleaseMemObject(d_outData_4);
-
-    if(kernel7)
-        clReleaseKernel(kernel7);
-    if(kernel8)
-        clReleaseKernel(kernel8);
-    queue_cleanup_4();
-    pthread_exit(NULL);
+void fft_channels_release(){
+    pool_stop();
+    for(unsigned c = 0; c < NUM_CHANNELS; c++){
+        fft_channel *ch = &channels[c];
+        release_buffers(ch);
+        if(ch->fetch_kernel)
+            clReleaseKernel(ch->fetch_kernel);
+        if(ch->fft_kernel)
+            clReleaseKernel(ch->fft_kernel);
+        ch->fetch_kernel = NULL;
+        ch->fft_kernel = NULL;
+        ch->queue_cleanup();
+    }
 }
 
-fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned batch4){
-    pthread_t thread_2, thread_3, thread_4;
-    thread_data data;
+unsigned fftfpgaf_channel_stats(fpga_channel_stats *stats, const unsigned max_channels){
+    unsigned n = max_channels < NUM_CHANNELS ? max_channels : NUM_CHANNELS;
+    for(unsigned c = 0; c < n; c++){
+        stats[c].transforms = atomic_load(&channels[c].transforms);
+        stats[c].launches = atomic_load(&channels[c].launches);
+        stats[c].busy_t = atomic_load(&channels[c].busy_ns) * 1e-6;
+    }
+    return NUM_CHANNELS;
+}
 
+void fftfpgaf_reset_channel_stats(){
+    for(unsigned c = 0; c < NUM_CHANNELS; c++){
+        atomic_store(&channels[c].transforms, 0);
+        atomic_store(&channels[c].launches, 0);
+        atomic_store(&channels[c].busy_ns, 0);
+    }
+}
 
-    fpga_t fft_time = {0.0, 0.0, 0.0, 0};
-    const unsigned batch = batch4/4;
+/**
+ * \brief  compute an out-of-place single precision complex 1D-FFT on the FPGA
+ * \param  N    : unsigned integer to the number of points in FFT1d
+ * \param  inp  : float2 pointer to input data of size N * batch
+ * \param  out  : float2 pointer to output data of size N * batch
+ * \param  inv  : toggle for backward transforms
+ * \param  batch : number of batched executions of 1D FFT, any value
+ * \return fpga_t : time taken in milliseconds for data transfers and
+ *                  execution by the busiest channel
+ */
+fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned batch){
+    fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
 
     // if N is not a power of 2
-    if(inp == NULL || out == NULL || ( (N & (N-1)) !=0)){
+    if(inp == NULL || out == NULL || ( (N & (N-1)) !=0) || batch == 0){
         return fft_time;
     }
+    if(!pool_start())
+        return fft_time;
 
-
+    fft_job job;
+    job.N = N;
+    job.inp = inp;
+    job.out = out;
     // Can't pass bool to device, so convert it to int
-    int inverse_int = (int)inv;
-
-
-    data.N = N;
-    data.inp = inp;
-    data.out = out;
-    data.inverse_int = inverse_int;
-    data.batch = batch;
+    job.inverse_int = (int)inv;
+    memset(job.times, 0, sizeof(job.times));
 
+    const unsigned size = chunk_size(batch);
+    const unsigned num_chunks = (batch + size - 1) / size;
+    atomic_init(&job.remaining, num_chunks);
+    sem_init(&job.done, 0, 0);
 
-    int rc = pthread_create(&thread_2, NULL, fftfpgaf_c2c_1d_proc_2, (void *)&data);
-    if (rc) {
-        printf("ERROR; return code from pthread_create() is %d\n", rc);
-        return fft_time;
-    }
-
-    rc = pthread_create(&thread_3, NULL, fftfpgaf_c2c_1d_proc_3, (void *)&data);
-    if (rc) {
-        printf("ERROR; return code from pthread_create() is %d\n", rc);
-        return fft_time;
+    for(unsigned first = 0; first < batch; first += size){
+        fft_chunk chunk = {&job, first, batch - first < size ? batch - first : size};
+        post_chunk(&chunk);
     }
-
-    rc = pthread_create(&thread_4, NULL, fftfpgaf_c2c_1d_proc_4, (void *)&data);
-    if (rc) {
-        printf("ERROR; return code from pthread_create() is %d\n", rc);
-        return fft_time;
+    while(sem_wait(&job.done) != 0 && errno == EINTR)
+        ;
+    sem_destroy(&job.done);
+
+    for(unsigned c = 0; c < NUM_CHANNELS; c++){
+        double total = job.times[c].pcie_write_t + job.times[c].exec_t + job.times[c].pcie_read_t;
+        if(total > fft_time.pcie_write_t + fft_time.exec_t + fft_time.pcie_read_t)
+            fft_time = job.times[c];
     }
-
-    fft_time = fftfpgaf_c2c_1d_proc_1(N, inp, out, inverse_int, batch);
-
-
-    pthread_join(thread_2, NULL);
-    pthread_join(thread_3, NULL);
-    pthread_join(thread_4, NULL);
-
+    fft_time.valid = 1;
     return fft_time;
 }
 
 
 fpga_t fftfpgaf_c2c_1d_(const unsigned N, const float2 *inp, float2 *out, const bool inv){
 
-    const unsigned batch = 1;
-    fpga_t fft_time = {0.0, 0.0, 0.0, 0};
-    cl_kernel kernel1 = NULL, kernel2 = NULL;
-    cl_int status = 0;
+    fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, 0};
 
     // if N is not a power of 2
     if(inp == NULL || out == NULL || ( (N & (N-1)) !=0)){
         return fft_time;
     }
 
-    //printf("-- Launching%s 1D FFT of %d batches \n", inv ? " inverse":"", batch);
-
-    queue_setup_1();
-
-    cl_mem d_inData, d_outData;
-    //printf("Launching%s FFT transform for %d batch \n", inv ? " inverse":"", batch);
-
-    // Create device buffers - assign the buffers in different banks for more efficient memory access
-    d_inData = clCreateBuffer(context, CL_MEM_READ_ONLY, sizeof(float2) * N, NULL, &status);
-    checkError(status, "Failed to allocate input device buffer\n");
-
-    d_outData = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(float2) * N, NULL, &status);
-    checkError(status, "Failed to allocate output device buffer\n");
-
-    //printf("-- Copying data from host to device\n");
-    // Copy data from host to device
-    status = clEnqueueWriteBuffer(queue1, d_inData, CL_TRUE, 0, sizeof(float2) * N, inp, 0, NULL, NULL);
-    checkError(status, "Failed to copy data to device");
-
-    status = clFinish(queue1);
-    checkError(status, "failed to finish writing buffer using PCIe");
-
     // Can't pass bool to device, so convert it to int
     int inverse_int = (int)inv;
 
-    // Create Kernels - names must match the kernel name in the original CL file
-    kernel1 = clCreateKernel(program, "fetch", &status);
-    checkError(status, "Failed to create fetch kernel");
-
-    kernel2 = clCreateKernel(program, "fft1d", &status);
-    checkError(status, "Failed to create fft1d kernel");
-    // Set the kernel arguments
-    status = clSetKernelArg(kernel1, 0, sizeof(cl_mem), (void *)&d_inData);
-    checkError(status, "Failed to set kernel1 arg 0");
-    status = clSetKernelArg(kernel2, 0, sizeof(cl_mem), (void *)&d_outData);
-    checkError(status, "Failed to set kernel arg 0");
-    status = clSetKernelArg(kernel2, 1, sizeof(cl_int), (void*)&batch);
-    checkError(status, "Failed to set kernel arg 1");
-    status = clSetKernelArg(kernel2, 2, sizeof(cl_int), (void*)&inverse_int);
-    checkError(status, "Failed to set kernel arg 2");
-
-    size_t ls = N/8;
-    size_t gs = ls;
-
-    //printf("-- Executing kernels\n");
-    cl_event startExec_event, endExec_event;
-    // Measure execution time
-    // Launch the kernel - we launch a single work item hence enqueue a task
-    // FFT1d kernel is the SWI kernel
-    status = clEnqueueTask(queue1, kernel2, 0, NULL, &endExec_event);
-    checkError(status, "Failed to launch fft1d kernel");
-
-    status = clEnqueueNDRangeKernel(queue2, kernel1, 1, NULL, &gs, &ls, 0, NULL, &startExec_event);
-    checkError(status, "Failed to launch fetch kernel");
-
-    // Wait for command queue to complete pending events
-    status = clFinish(queue1);
-    checkError(status, "Failed to finish queue1");
-    status = clFinish(queue2);
-    checkError(status, "Failed to finish queue2");
-
-    // Record execution time
-    cl_ulong kernel_start = 0, kernel_end = 0;
-    clGetEventProfilingInfo(startExec_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &kernel_start, NULL);
-    clGetEventProfilingInfo(endExec_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &kernel_end, NULL);
-    fft_time.exec_t = (cl_double)(kernel_end - kernel_start) * (cl_double)(1e-06);
-
-    // Copy results from device to host
-    //printf("-- Transferring results back to host\n");
-    status = clEnqueueReadBuffer(queue1, d_outData, CL_TRUE, 0, sizeof(float2) * N, out, 0, NULL, NULL);
-    checkError(status, "Failed to copy data from device");
-
-    status = clFinish(queue1);
-    checkError(status, "failed to finish reading buffer using PCIe");
-
-    // Cleanup
-    if (d_inData)
-        clReleaseMemObject(d_inData);
-    if (d_outData)
-        clReleaseMemObject(d_outData);
-    if(kernel1)
-        clReleaseKernel(kernel1);
-    if(kernel2)
-        clReleaseKernel(kernel2);
-    queue_cleanup_1();
-
-    fft_time.valid = 1;
-    return fft_time;
+    // A single transform is not worth a hand-off to the workers
+    return channel_run(&channels[0], N, inp, out, inverse_int, 1);
 }
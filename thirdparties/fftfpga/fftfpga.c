@@ -134,11 +134,15 @@ int fpga_initialize(const char *platform_name, const char *path, const bool use_
  */
 void fpga_final(){
   printf("-- Cleaning up FPGA resources ...\n");
+  fft_channels_release();
   if(program) 
     clReleaseProgram(program);
   if(context)
     clReleaseContext(context);
   free(devices);
+  program = NULL;
+  context = NULL;
+  devices = NULL;
 }
 
 /**
@@ -189,6 +193,8 @@ void queue_cleanup_1() {
     clReleaseCommandQueue(queue1);
   if(queue2) 
     clReleaseCommandQueue(queue2);
+  queue1 = NULL;
+  queue2 = NULL;
 }
 
 void queue_cleanup_2() {
@@ -28,4 +28,7 @@ extern void queue_cleanup_3();
 extern void queue_setup_4();
 extern void queue_cleanup_4();
 
+// Releases the kernels, buffers and queues kept by fft1d.c
+extern void fft_channels_release();
+
 #endif
@@ -0,0 +1,277 @@
+// CPU emulator of the fftfpga host library
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fftfpga.h"
+#include "fftfpga_emu.h"
+
+#define MAX_CHANNELS 4
+#define MAX_LOG_N 30
+// Same split as fft1d.c: about two chunks per channel.
+#define CHUNKS_PER_CHANNEL 2
+
+static fpga_emu_config config = {
+    6.0,    // pcie_bandwidth
+    5.0,    // pcie_latency
+    300.0,  // kernel_clock
+    8,      // points_per_cycle
+    20.0,   // launch_overhead
+    4,      // channels
+    false,  // realtime
+};
+
+static bool initialized = false;
+static pthread_mutex_t emu_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Twiddle factors exp(-2 pi i k / N), k < N/2, rounded to single precision
+// as on the device, indexed by log2(N).
+static float2 *twiddles[MAX_LOG_N + 1];
+
+static fpga_channel_stats stats[MAX_CHANNELS];
+
+static void env_double(const char *name, double *value){
+    const char *s = getenv(name);
+    if(s != NULL && *s != '\0')
+        *value = atof(s);
+}
+
+fpga_emu_config fpga_emu_get_config(){
+    pthread_mutex_lock(&emu_lock);
+    fpga_emu_config c = config;
+    pthread_mutex_unlock(&emu_lock);
+    return c;
+}
+
+bool fpga_emu_set_config(const fpga_emu_config *c){
+    if(c == NULL || !(c->pcie_bandwidth > 0) || c->pcie_latency < 0 || !(c->kernel_clock > 0)
+       || c->points_per_cycle == 0 || c->launch_overhead < 0
+       || c->channels == 0 || c->channels > MAX_CHANNELS)
+        return false;
+    pthread_mutex_lock(&emu_lock);
+    config = *c;
+    pthread_mutex_unlock(&emu_lock);
+    return true;
+}
+
+/**
+ * @brief Initialize the emulated FPGA
+ * @param platform_name: ignored
+ * @param path         : path to the binary, only checked for presence
+ * @param use_svm      : must be false, SVM is not emulated
+ * @return 0 if successful
+          -1 Path to binary missing
+          -5 Device does not support required SVM
+ */
+int fpga_initialize(const char *platform_name, const char *path, const bool use_svm){
+    (void)platform_name;
+    printf("-- Initializing FPGA emulator ...\n");
+    if(path == NULL || strlen(path) == 0)
+        return -1;
+    if(use_svm)
+        return -5;
+
+    fpga_emu_config c = fpga_emu_get_config();
+    env_double("FFTFPGA_EMU_PCIE_GBS", &c.pcie_bandwidth);
+    env_double("FFTFPGA_EMU_PCIE_LATENCY_US", &c.pcie_latency);
+    env_double("FFTFPGA_EMU_CLOCK_MHZ", &c.kernel_clock);
+    env_double("FFTFPGA_EMU_LAUNCH_US", &c.launch_overhead);
+    const char *rt = getenv("FFTFPGA_EMU_REALTIME");
+    if(rt != NULL && *rt != '\0')
+        c.realtime = atoi(rt) != 0;
+    if(!fpga_emu_set_config(&c))
+        fprintf(stderr, "-- Ignoring invalid FFTFPGA_EMU_* settings\n");
+
+    initialized = true;
+    return 0;
+}
+
+void fpga_final(){
+    printf("-- Cleaning up FPGA emulator ...\n");
+    pthread_mutex_lock(&emu_lock);
+    for(unsigned i = 0; i <= MAX_LOG_N; i++){
+        free(twiddles[i]);
+        twiddles[i] = NULL;
+    }
+    initialized = false;
+    pthread_mutex_unlock(&emu_lock);
+}
+
+void* fftfpga_complex_malloc(const size_t sz){
+    if(sz == 0)
+        return NULL;
+    return aligned_alloc(64, (sz + 63) / 64 * 64);
+}
+
+void* fftfpgaf_complex_malloc(const size_t sz){
+    if(sz == 0)
+        return NULL;
+    return aligned_alloc(64, (sz + 63) / 64 * 64);
+}
+
+static unsigned log2_of(unsigned N){
+    unsigned bits = 0;
+    while((1u << bits) < N)
+        bits++;
+    return bits;
+}
+
+static const float2 *twiddle_table(const unsigned N){
+    const unsigned bits = log2_of(N);
+    pthread_mutex_lock(&emu_lock);
+    if(twiddles[bits] == NULL && N > 1){
+        float2 *w = malloc(sizeof(float2) * (N / 2));
+        for(unsigned k = 0; k < N / 2; k++){
+            const double angle = -2.0 * M_PI * k / N;
+            w[k].x = cos(angle);
+            w[k].y = sin(angle);
+        }
+        twiddles[bits] = w;
+    }
+    const float2 *w = twiddles[bits];
+    pthread_mutex_unlock(&emu_lock);
+    return w;
+}
+
+/**
+ * Radix-2 decimation in frequency on a natural order input, leaving the
+ * result in bit-reversed order like the fft1d kernel. Unnormalised, with
+ * exp(+2 pi i jk / N) for backward transforms.
+ */
+static void fft_bitrev(float2 *a, const unsigned N, const float2 *w, const bool inv){
+    const float sign = inv ? -1.0f : 1.0f;
+    for(unsigned len = N, stride = 1; len >= 2; len >>= 1, stride <<= 1){
+        const unsigned half = len / 2;
+        for(unsigned s = 0; s < N; s += len){
+            float2 *lo = a + s, *hi = a + s + half;
+            for(unsigned j = 0; j < half; j++){
+                const float wr = w[j * stride].x, wi = sign * w[j * stride].y;
+                const float dr = lo[j].x - hi[j].x, di = lo[j].y - hi[j].y;
+                lo[j].x += hi[j].x;
+                lo[j].y += hi[j].y;
+                hi[j].x = dr * wr - di * wi;
+                hi[j].y = dr * wi + di * wr;
+            }
+        }
+    }
+}
+
+// Modelled time of one launch of count transforms on a channel.
+static fpga_t model_launch(const fpga_emu_config *c, const unsigned N, const unsigned count){
+    fpga_t t = {0.0, 0.0, 0.0, 0.0, 0.0, true};
+    const double bytes = (double)sizeof(float2) * N * count;
+    const double transfer = c->pcie_latency * 1e-3 + bytes / (c->pcie_bandwidth * 1e6);
+    t.pcie_write_t = transfer;
+    t.pcie_read_t = transfer;
+    const double cycles = (double)N * count / c->points_per_cycle;
+    t.exec_t = c->launch_overhead * 1e-3 + cycles / (c->kernel_clock * 1e3);
+    return t;
+}
+
+static double total_of(const fpga_t *t){
+    return t->pcie_write_t + t->exec_t + t->pcie_read_t;
+}
+
+static void wait_until(const struct timespec *start, const double ms){
+    struct timespec deadline = *start;
+    const long long ns = (long long)(ms * 1e6);
+    deadline.tv_sec += ns / 1000000000LL;
+    deadline.tv_nsec += ns % 1000000000LL;
+    if(deadline.tv_nsec >= 1000000000L){
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+        ;
+}
+
+static fpga_t emulate(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned batch, const bool split){
+    fpga_t fft_time = {0.0, 0.0, 0.0, 0.0, 0.0, false};
+    if(!initialized || inp == NULL || out == NULL || N == 0 || (N & (N - 1)) != 0 || batch == 0)
+        return fft_time;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const fpga_emu_config c = fpga_emu_get_config();
+    const float2 *w = twiddle_table(N);
+
+    if(inp != out)
+        memcpy(out, inp, sizeof(float2) * N * batch);
+    if(N > 1)
+        for(unsigned b = 0; b < batch; b++)
+            fft_bitrev(out + (size_t)N * b, N, w, inv);
+
+    // Chunks go to the channel that becomes idle first, as with the
+    // worker pool of fft1d.c.
+    const unsigned channels = split ? c.channels : 1;
+    const unsigned chunks = channels * CHUNKS_PER_CHANNEL;
+    unsigned size = split ? (batch + chunks - 1) / chunks : batch;
+    fpga_t times[MAX_CHANNELS];
+    memset(times, 0, sizeof(times));
+    unsigned long long transforms[MAX_CHANNELS] = {0}, launches[MAX_CHANNELS] = {0};
+    for(unsigned first = 0; first < batch; first += size){
+        const unsigned count = batch - first < size ? batch - first : size;
+        unsigned ch = 0;
+        for(unsigned i = 1; i < channels; i++)
+            if(total_of(&times[i]) < total_of(&times[ch]))
+                ch = i;
+        fpga_t t = model_launch(&c, N, count);
+        times[ch].pcie_write_t += t.pcie_write_t;
+        times[ch].exec_t += t.exec_t;
+        times[ch].pcie_read_t += t.pcie_read_t;
+        transforms[ch] += count;
+        launches[ch]++;
+    }
+
+    pthread_mutex_lock(&emu_lock);
+    for(unsigned ch = 0; ch < channels; ch++){
+        stats[ch].transforms += transforms[ch];
+        stats[ch].launches += launches[ch];
+        stats[ch].busy_t += total_of(&times[ch]);
+        if(total_of(&times[ch]) > total_of(&fft_time))
+            fft_time = times[ch];
+    }
+    pthread_mutex_unlock(&emu_lock);
+    fft_time.valid = true;
+
+    if(c.realtime)
+        wait_until(&start, total_of(&fft_time));
+    return fft_time;
+}
+
+fpga_t fftfpgaf_c2c_1d(const unsigned N, const float2 *inp, float2 *out, const bool inv, const unsigned iter){
+    return emulate(N, inp, out, inv, iter, true);
+}
+
+fpga_t fftfpgaf_c2c_1d_(const unsigned N, const float2 *inp, float2 *out, const bool inv){
+    return emulate(N, inp, out, inv, 1, false);
+}
+
+bool fftfpgaf_c2c_1d_reserve(const unsigned N, const unsigned max_batch){
+    (void)max_batch;
+    if(!initialized || N == 0 || (N & (N - 1)) != 0)
+        return false;
+    twiddle_table(N);
+    return true;
+}
+
+unsigned fftfpgaf_channel_stats(fpga_channel_stats *s, const unsigned max_channels){
+    pthread_mutex_lock(&emu_lock);
+    const unsigned n = max_channels < MAX_CHANNELS ? max_channels : MAX_CHANNELS;
+    for(unsigned ch = 0; ch < n; ch++)
+        s[ch] = stats[ch];
+    pthread_mutex_unlock(&emu_lock);
+    return MAX_CHANNELS;
+}
+
+void fftfpgaf_reset_channel_stats(){
+    pthread_mutex_lock(&emu_lock);
+    memset(stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&emu_lock);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file fftfpga_emu.h
+ * @brief Timing model of the CPU emulator of the fftfpga library
+ *
+ * The emulator implements the API of fftfpga.h on the host: transforms are
+ * computed in single precision and written in bit-reversed order like the
+ * fft1d bitstream, and the fpga_t timings are filled in from the model
+ * below instead of being measured on a device.
+ */
+
+#ifndef FFTFPGA_EMU_H
+#define FFTFPGA_EMU_H
+
+#include <stdbool.h>
+#include "fftfpga.h"
+
+/**
+ * Parameters of the modelled device. Every launch pays the PCIe latency
+ * for each transfer plus the kernel launch overhead; transfers move
+ * 8 bytes per point at the PCIe bandwidth and the kernel consumes
+ * points_per_cycle points per clock cycle.
+ */
+typedef struct fpga_emu_config {
+  double pcie_bandwidth;    /**< GB/s in each direction */
+  double pcie_latency;      /**< microseconds per transfer */
+  double kernel_clock;      /**< MHz */
+  unsigned points_per_cycle;/**< points consumed per cycle by a channel */
+  double launch_overhead;   /**< microseconds per kernel launch */
+  unsigned channels;        /**< independent FFT channels, 1 to 4 */
+  bool realtime;            /**< wait until the modelled time has elapsed */
+} fpga_emu_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  current model parameters. The defaults describe a Stratix 10
+ *         board on PCIe Gen3 x8 and can be overridden with the environment
+ *         variables FFTFPGA_EMU_PCIE_GBS, FFTFPGA_EMU_PCIE_LATENCY_US,
+ *         FFTFPGA_EMU_CLOCK_MHZ, FFTFPGA_EMU_LAUNCH_US and
+ *         FFTFPGA_EMU_REALTIME, read by fpga_initialize
+ */
+extern fpga_emu_config fpga_emu_get_config();
+
+/**
+ * @brief  replace the model parameters
+ * @return false if a parameter is out of range, the model is unchanged
+ */
+extern bool fpga_emu_set_config(const fpga_emu_config *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
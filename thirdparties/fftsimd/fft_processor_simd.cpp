@@ -0,0 +1,593 @@
+#include "fft_processor_simd.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+#define FFTSIMD_AVX512
+#include <immintrin.h>
+#elif defined(__AVX2__) && defined(__FMA__)
+#define FFTSIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#define CAST_DOUBLE_TO_UINT32(d) ((uint32_t)((int64_t)(d)))
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Vector layer. Vec holds W doubles; every kernel below is written once
+// against these helpers.
+// ---------------------------------------------------------------------------
+
+#if defined(FFTSIMD_AVX512)
+
+constexpr int W = 8;
+struct Vec {
+    __m512d v;
+};
+inline Vec operator+(Vec a, Vec b) { return {_mm512_add_pd(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm512_sub_pd(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm512_mul_pd(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm512_div_pd(a.v, b.v)}; }
+// a * b + c, a * b - c
+inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm512_fmadd_pd(a.v, b.v, c.v)}; }
+inline Vec fmsub(Vec a, Vec b, Vec c) { return {_mm512_fmsub_pd(a.v, b.v, c.v)}; }
+inline Vec vset1(double a) { return {_mm512_set1_pd(a)}; }
+inline Vec vload(const double *p) { return {_mm512_loadu_pd(p)}; }
+inline void vstore(double *p, Vec a) { _mm512_storeu_pd(p, a.v); }
+
+inline Vec vload_cvt(const int32_t *p)
+{
+    return {_mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)))};
+}
+inline Vec vload_cvt(const int64_t *p)
+{
+    return {_mm512_cvtepi64_pd(
+        _mm512_loadu_si512(reinterpret_cast<const void *>(p)))};
+}
+
+// (uint32_t)(int64_t)d for every lane.
+inline void vstore_torus32(uint32_t *p, Vec a)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                        _mm512_cvtepi64_epi32(_mm512_cvttpd_epi64(a.v)));
+}
+
+// Converts to the torus modulo 2^64 by shifting the mantissa; see
+// FFT_Processor_FFTW::execute_direct_torus64. Out-of-range shift counts
+// yield zero in sllv/srlv, which is what the conversion needs.
+inline void vstore_torus64(uint64_t *p, Vec a)
+{
+    const __m512i bits = _mm512_castpd_si512(a.v);
+    const __m512i val = _mm512_or_si512(
+        _mm512_and_si512(bits, _mm512_set1_epi64(0x000FFFFFFFFFFFFFl)),
+        _mm512_set1_epi64(0x0010000000000000l));
+    const __m512i expo =
+        _mm512_and_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(0x7FF));
+    const __m512i left =
+        _mm512_sllv_epi64(val, _mm512_sub_epi64(expo, _mm512_set1_epi64(1075)));
+    const __m512i right =
+        _mm512_srlv_epi64(val, _mm512_sub_epi64(_mm512_set1_epi64(1075), expo));
+    const __m512i mag = _mm512_or_si512(left, right);
+    const __m512i sign = _mm512_srai_epi64(bits, 63);
+    _mm512_storeu_si512(
+        reinterpret_cast<void *>(p),
+        _mm512_sub_epi64(_mm512_xor_si512(mag, sign), sign));
+}
+
+inline void transpose(Vec (&r)[W])
+{
+    const __m512i lo2 = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+    const __m512i hi2 = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+    __m512d t[W], u[W];
+    for (int i = 0; i < W; i += 2) {
+        t[i] = _mm512_unpacklo_pd(r[i].v, r[i + 1].v);
+        t[i + 1] = _mm512_unpackhi_pd(r[i].v, r[i + 1].v);
+    }
+    for (int i = 0; i < W; i += 4)
+        for (int j = 0; j < 2; j++) {
+            u[i + j] = _mm512_permutex2var_pd(t[i + j], lo2, t[i + j + 2]);
+            u[i + j + 2] = _mm512_permutex2var_pd(t[i + j], hi2, t[i + j + 2]);
+        }
+    // u[0]: elements 0,4  u[1]: 1,5  u[2]: 2,6  u[3]: 3,7 of rows 0..3,
+    // u[4..7] the same for rows 4..7.
+    for (int j = 0; j < 4; j++) {
+        r[j].v = _mm512_shuffle_f64x2(u[j], u[j + 4], 0x44);
+        r[j + 4].v = _mm512_shuffle_f64x2(u[j], u[j + 4], 0xEE);
+    }
+}
+
+#elif defined(FFTSIMD_AVX2)
+
+constexpr int W = 4;
+struct Vec {
+    __m256d v;
+};
+inline Vec operator+(Vec a, Vec b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm256_div_pd(a.v, b.v)}; }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return {_mm256_fmadd_pd(a.v, b.v, c.v)}; }
+inline Vec fmsub(Vec a, Vec b, Vec c) { return {_mm256_fmsub_pd(a.v, b.v, c.v)}; }
+inline Vec vset1(double a) { return {_mm256_set1_pd(a)}; }
+inline Vec vload(const double *p) { return {_mm256_loadu_pd(p)}; }
+inline void vstore(double *p, Vec a) { _mm256_storeu_pd(p, a.v); }
+
+inline Vec vload_cvt(const int32_t *p)
+{
+    return {_mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)))};
+}
+// AVX2 has no int64 -> double conversion: convert the signed high and the
+// unsigned low 32-bit halves exactly and combine them with a single rounding.
+inline Vec vload_cvt(const int64_t *p)
+{
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i split = _mm256_permutevar8x32_epi32(
+        x, _mm256_setr_epi32(1, 3, 5, 7, 0, 2, 4, 6));
+    const __m256d hi = _mm256_cvtepi32_pd(_mm256_castsi256_si128(split));
+    const __m256d lo = _mm256_add_pd(
+        _mm256_cvtepi32_pd(_mm_xor_si128(_mm256_extracti128_si256(split, 1),
+                                         _mm_set1_epi32(INT32_MIN))),
+        _mm256_set1_pd(2147483648.0));
+    return {_mm256_fmadd_pd(hi, _mm256_set1_pd(4294967296.0), lo)};
+}
+
+// (uint32_t)(int64_t)d: truncate, reduce modulo 2^32 exactly in double and
+// read the low word through the 2^52 + 2^51 rounding constant.
+inline void vstore_torus32(uint32_t *p, Vec a)
+{
+    const __m256d t = _mm256_round_pd(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d q = _mm256_floor_pd(_mm256_mul_pd(t, _mm256_set1_pd(0x1p-32)));
+    const __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(0x1p32), t);
+    const __m256i bits = _mm256_castpd_si256(
+        _mm256_add_pd(r, _mm256_set1_pd(6755399441055744.0)));
+    const __m256i packed = _mm256_permutevar8x32_epi32(
+        bits, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm256_castsi256_si128(packed));
+}
+
+inline void vstore_torus64(uint64_t *p, Vec a)
+{
+    const __m256i bits = _mm256_castpd_si256(a.v);
+    const __m256i val = _mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFl)),
+        _mm256_set1_epi64x(0x0010000000000000l));
+    const __m256i expo = _mm256_and_si256(_mm256_srli_epi64(bits, 52),
+                                          _mm256_set1_epi64x(0x7FF));
+    const __m256i left = _mm256_sllv_epi64(
+        val, _mm256_sub_epi64(expo, _mm256_set1_epi64x(1075)));
+    const __m256i right = _mm256_srlv_epi64(
+        val, _mm256_sub_epi64(_mm256_set1_epi64x(1075), expo));
+    const __m256i mag = _mm256_or_si256(left, right);
+    const __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), bits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                        _mm256_sub_epi64(_mm256_xor_si256(mag, sign), sign));
+}
+
+inline void transpose(Vec (&r)[W])
+{
+    const __m256d t0 = _mm256_unpacklo_pd(r[0].v, r[1].v);
+    const __m256d t1 = _mm256_unpackhi_pd(r[0].v, r[1].v);
+    const __m256d t2 = _mm256_unpacklo_pd(r[2].v, r[3].v);
+    const __m256d t3 = _mm256_unpackhi_pd(r[2].v, r[3].v);
+    r[0].v = _mm256_permute2f128_pd(t0, t2, 0x20);
+    r[1].v = _mm256_permute2f128_pd(t1, t3, 0x20);
+    r[2].v = _mm256_permute2f128_pd(t0, t2, 0x31);
+    r[3].v = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+#else
+
+constexpr int W = 1;
+struct Vec {
+    double v;
+};
+inline Vec operator+(Vec a, Vec b) { return {a.v + b.v}; }
+inline Vec operator-(Vec a, Vec b) { return {a.v - b.v}; }
+inline Vec operator*(Vec a, Vec b) { return {a.v * b.v}; }
+inline Vec operator/(Vec a, Vec b) { return {a.v / b.v}; }
+inline Vec fmadd(Vec a, Vec b, Vec c) { return {std::fma(a.v, b.v, c.v)}; }
+inline Vec fmsub(Vec a, Vec b, Vec c) { return {std::fma(a.v, b.v, -c.v)}; }
+inline Vec vset1(double a) { return {a}; }
+inline Vec vload(const double *p) { return {*p}; }
+inline void vstore(double *p, Vec a) { *p = a.v; }
+inline Vec vload_cvt(const int32_t *p) { return {(double)*p}; }
+inline Vec vload_cvt(const int64_t *p) { return {(double)*p}; }
+inline void vstore_torus32(uint32_t *p, Vec a)
+{
+    *p = CAST_DOUBLE_TO_UINT32(a.v);
+}
+inline void vstore_torus64(uint64_t *p, Vec a)
+{
+    uint64_t bits;
+    __builtin_memcpy(&bits, &a.v, sizeof(bits));
+    const uint64_t val = (bits & 0x000FFFFFFFFFFFFFul) | 0x0010000000000000ul;
+    const int16_t trans = ((bits >> 52) & 0x07FFu) - 1075;
+    const uint64_t mag = trans >= 64    ? 0
+                         : trans > 0    ? (val << trans)
+                         : trans > -64 ? (val >> -trans)
+                                        : 0;
+    *p = (bits >> 63) ? -mag : mag;
+}
+inline void transpose(Vec (&)[W]) {}
+
+#endif
+
+// (re + i im) * (wr + i wi)
+inline void cmul(Vec &re, Vec &im, Vec wr, Vec wi)
+{
+    const Vec r = fmsub(re, wr, im * wi);
+    im = fmadd(re, wi, im * wr);
+    re = r;
+}
+
+// ---------------------------------------------------------------------------
+// Compile-time twiddle tables.
+// ---------------------------------------------------------------------------
+
+constexpr long double pi = 3.141592653589793238462643383279502884L;
+
+constexpr long double sin_series(long double x)
+{
+    long double term = x, sum = x;
+    for (int k = 1; k < 14; k++) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr long double cos_series(long double x)
+{
+    long double term = 1, sum = 1;
+    for (int k = 1; k < 14; k++) {
+        term *= -x * x / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+struct CosSin {
+    double c, s;
+};
+
+// cos and sin of pi * num / den for 0 <= num < 2 * den. The argument is
+// reduced to the first octant so that the series stay accurate.
+constexpr CosSin cossinpi(int64_t num, int64_t den)
+{
+    const int64_t oct = 4 * num / den;
+    const int64_t rem = 4 * num - oct * den;
+    const bool mirrored = oct & 1;
+    const long double x = pi / 4 * (mirrored ? den - rem : rem) / den;
+    const long double c0 = cos_series(x), s0 = sin_series(x);
+    const bool swap = (oct + 1) & 2;
+    long double c = swap ? s0 : c0;
+    long double s = swap ? c0 : s0;
+    if (oct >= 2 && oct <= 5) c = -c;
+    if (oct >= 4) s = -s;
+    return {static_cast<double>(c), static_cast<double>(s)};
+}
+
+constexpr uint32_t bitreverse(uint32_t x, uint32_t n)
+{
+    uint32_t r = 0;
+    for (uint32_t b = 1; b < n; b <<= 1) {
+        r = (r << 1) | (x & 1);
+        x >>= 1;
+    }
+    return r;
+}
+
+// M = N/2 is the size of the complex FFT, R = M/W the number of W-wide
+// chunks.
+template <uint32_t N>
+struct Tables {
+    static constexpr int M = N / 2;
+    static constexpr int R = M / W;
+    // exp(i pi j / N) and conj(exp(i pi j / N)) / M, j < M
+    std::array<double, M> twre{}, twim{}, utre{}, utim{};
+    // DIF stage with half size h: exp(-i pi j / h) at index h + j, j < h
+    std::array<double, M> wre{}, wim{};
+    std::array<uint32_t, R> brR{};
+    std::array<uint32_t, W> brW{};
+};
+
+template <uint32_t N>
+constexpr Tables<N> make_tables()
+{
+    Tables<N> t;
+    constexpr int M = Tables<N>::M;
+    for (int j = 0; j < M; j++) {
+        const CosSin cs = cossinpi(j, N);
+        t.twre[j] = cs.c;
+        t.twim[j] = cs.s;
+        t.utre[j] = cs.c / M;
+        t.utim[j] = -cs.s / M;
+    }
+    t.wre[0] = 1;
+    for (int h = 1; h < M; h <<= 1)
+        for (int j = 0; j < h; j++) {
+            const CosSin cs = cossinpi(j, h);
+            t.wre[h + j] = cs.c;
+            t.wim[h + j] = -cs.s;
+        }
+    for (uint32_t q = 0; q < Tables<N>::R; q++)
+        t.brR[q] = bitreverse(q, Tables<N>::R);
+    for (uint32_t w = 0; w < W; w++) t.brW[w] = bitreverse(w, W);
+    return t;
+}
+
+template <uint32_t N>
+constexpr Tables<N> tables = make_tables<N>();
+
+// ---------------------------------------------------------------------------
+// Kernels.
+//
+// Forward: the first decimation-in-frequency stage is fused with the twist
+// of the folded input a[j] + i a[j + N/2]. The stages with half size >= W
+// run on contiguous vectors. The last log2(W) stages work inside W-element
+// chunks: W chunks are transposed so that each lane holds one chunk, and
+// the chunks are picked so that the bit-reversed DIF output lands in W
+// consecutive natural-order slots, which are stored directly to res.
+//
+// Inverse: the exact reverse data flow with conjugated twiddles. The last
+// stage is fused with the untwist (which carries the 1/M scaling) and the
+// torus conversion done by the sink.
+// ---------------------------------------------------------------------------
+
+template <uint32_t N, class In>
+inline void forward(double *res, const In *a)
+{
+    constexpr auto &t = tables<N>;
+    constexpr int Ns2 = N / 2, M = Ns2, H = M / 2, R = M / W;
+    alignas(64) double re[M], im[M];
+
+    for (int j = 0; j < H; j += W) {
+        Vec xr = vload_cvt(a + j), xi = vload_cvt(a + Ns2 + j);
+        Vec yr = vload_cvt(a + H + j), yi = vload_cvt(a + Ns2 + H + j);
+        cmul(xr, xi, vload(&t.twre[j]), vload(&t.twim[j]));
+        cmul(yr, yi, vload(&t.twre[H + j]), vload(&t.twim[H + j]));
+        vstore(re + j, xr + yr);
+        vstore(im + j, xi + yi);
+        Vec dr = xr - yr, di = xi - yi;
+        cmul(dr, di, vload(&t.wre[H + j]), vload(&t.wim[H + j]));
+        vstore(re + H + j, dr);
+        vstore(im + H + j, di);
+    }
+
+    for (int h = H / 2; h >= W; h >>= 1)
+        for (int blk = 0; blk < M; blk += 2 * h)
+            for (int j = 0; j < h; j += W) {
+                double *const ur = re + blk + j, *const ui = im + blk + j;
+                const Vec xr = vload(ur), xi = vload(ui);
+                const Vec yr = vload(ur + h), yi = vload(ui + h);
+                vstore(ur, xr + yr);
+                vstore(ui, xi + yi);
+                Vec dr = xr - yr, di = xi - yi;
+                cmul(dr, di, vload(&t.wre[h + j]), vload(&t.wim[h + j]));
+                vstore(ur + h, dr);
+                vstore(ui + h, di);
+            }
+
+    for (int q0 = 0; q0 < R; q0 += W) {
+        Vec vr[W], vi[W];
+        for (int l = 0; l < W; l++) {
+            const int r = t.brR[q0 + l];
+            vr[l] = vload(re + r * W);
+            vi[l] = vload(im + r * W);
+        }
+        transpose(vr);
+        transpose(vi);
+        for (int h = W / 2; h >= 1; h >>= 1)
+            for (int blk = 0; blk < W; blk += 2 * h)
+                for (int j = 0; j < h; j++) {
+                    const Vec xr = vr[blk + j], xi = vi[blk + j];
+                    const Vec yr = vr[blk + j + h], yi = vi[blk + j + h];
+                    vr[blk + j] = xr + yr;
+                    vi[blk + j] = xi + yi;
+                    vr[blk + j + h] = xr - yr;
+                    vi[blk + j + h] = xi - yi;
+                    if (j != 0)
+                        cmul(vr[blk + j + h], vi[blk + j + h],
+                             vset1(t.wre[h + j]), vset1(t.wim[h + j]));
+                }
+        for (int w = 0; w < W; w++) {
+            const int k = t.brW[w] * R + q0;
+            vstore(res + k, vr[w]);
+            vstore(res + Ns2 + k, vi[w]);
+        }
+    }
+}
+
+// sink(j, re, im) receives lanes j..j+W-1 of the untwisted, scaled result.
+template <uint32_t N, class Sink>
+inline void inverse(const double *a, Sink &&sink)
+{
+    constexpr auto &t = tables<N>;
+    constexpr int Ns2 = N / 2, M = Ns2, H = M / 2, R = M / W;
+    alignas(64) double re[M], im[M];
+
+    for (int q0 = 0; q0 < R; q0 += W) {
+        Vec vr[W], vi[W];
+        for (int w = 0; w < W; w++) {
+            const int k = t.brW[w] * R + q0;
+            vr[w] = vload(a + k);
+            vi[w] = vload(a + Ns2 + k);
+        }
+        for (int h = 1; h < W; h <<= 1)
+            for (int blk = 0; blk < W; blk += 2 * h)
+                for (int j = 0; j < h; j++) {
+                    Vec yr = vr[blk + j + h], yi = vi[blk + j + h];
+                    if (j != 0)
+                        cmul(yr, yi, vset1(t.wre[h + j]),
+                             vset1(-t.wim[h + j]));
+                    const Vec xr = vr[blk + j], xi = vi[blk + j];
+                    vr[blk + j] = xr + yr;
+                    vi[blk + j] = xi + yi;
+                    vr[blk + j + h] = xr - yr;
+                    vi[blk + j + h] = xi - yi;
+                }
+        transpose(vr);
+        transpose(vi);
+        for (int l = 0; l < W; l++) {
+            const int r = t.brR[q0 + l];
+            vstore(re + r * W, vr[l]);
+            vstore(im + r * W, vi[l]);
+        }
+    }
+
+    for (int h = W; h < H; h <<= 1)
+        for (int blk = 0; blk < M; blk += 2 * h)
+            for (int j = 0; j < h; j += W) {
+                double *const ur = re + blk + j, *const ui = im + blk + j;
+                Vec yr = vload(ur + h), yi = vload(ui + h);
+                cmul(yr, yi, vload(&t.wre[h + j]),
+                     vset1(0.) - vload(&t.wim[h + j]));
+                const Vec xr = vload(ur), xi = vload(ui);
+                vstore(ur, xr + yr);
+                vstore(ui, xi + yi);
+                vstore(ur + h, xr - yr);
+                vstore(ui + h, xi - yi);
+            }
+
+    for (int j = 0; j < H; j += W) {
+        Vec yr = vload(re + H + j), yi = vload(im + H + j);
+        cmul(yr, yi, vload(&t.wre[H + j]), vset1(0.) - vload(&t.wim[H + j]));
+        const Vec xr = vload(re + j), xi = vload(im + j);
+        Vec pr = xr + yr, pi = xi + yi;
+        Vec qr = xr - yr, qi = xi - yi;
+        cmul(pr, pi, vload(&t.utre[j]), vload(&t.utim[j]));
+        cmul(qr, qi, vload(&t.utre[H + j]), vload(&t.utim[H + j]));
+        sink(j, pr, pi);
+        sink(H + j, qr, qi);
+    }
+}
+
+}  // namespace
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_reverse_int(double *res,
+                                                   const int32_t *a) const
+{
+    forward<Nval>(res, a);
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_reverse_torus32(double *res,
+                                                       const uint32_t *a) const
+{
+    forward<Nval>(res, reinterpret_cast<const int32_t *>(a));
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_reverse_torus64(double *res,
+                                                       const uint64_t *a) const
+{
+    forward<Nval>(res, reinterpret_cast<const int64_t *>(a));
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus32(uint32_t *res,
+                                                      const double *a) const
+{
+    inverse<Nval>(a, [res](int j, Vec re, Vec im) {
+        vstore_torus32(res + j, re);
+        vstore_torus32(res + Ns2 + j, im);
+    });
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus32_rescale(
+    uint32_t *res, const double *a, const double delta) const
+{
+    const Vec scale = vset1(delta / 4);
+    inverse<Nval>(a, [res, scale](int j, Vec re, Vec im) {
+        vstore_torus32(res + j, re / scale);
+        vstore_torus32(res + Ns2 + j, im / scale);
+    });
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus64(uint64_t *res,
+                                                      const double *a) const
+{
+    inverse<Nval>(a, [res](int j, Vec re, Vec im) {
+        vstore_torus64(res + j, re);
+        vstore_torus64(res + Ns2 + j, im);
+    });
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus64_rescale(
+    uint64_t *res, const double *a, const double delta) const
+{
+    alignas(64) double tmp[N];
+    inverse<Nval>(a, [&tmp](int j, Vec re, Vec im) {
+        vstore(tmp + j, re);
+        vstore(tmp + Ns2 + j, im);
+    });
+    for (int i = 0; i < N; i++)
+        res[i] = uint64_t(int64_t(std::round(tmp[i] / (delta / 4))));
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_reverse_torus32(double *res,
+                                                       const uint32_t *a,
+                                                       unsigned batch) const
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_reverse_torus32(res + i * N, a + i * N);
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus32(uint32_t *res,
+                                                      const double *a,
+                                                      unsigned batch) const
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_direct_torus32(res + i * N, a + i * N);
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_reverse_torus64(double *res,
+                                                       const uint64_t *a,
+                                                       unsigned batch) const
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_reverse_torus64(res + i * N, a + i * N);
+}
+
+template <uint32_t Nval>
+void FFT_Processor_SIMD<Nval>::execute_direct_torus64(uint64_t *res,
+                                                      const double *a,
+                                                      unsigned batch) const
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_direct_torus64(res + i * N, a + i * N);
+}
+
+const char *fftsimd_isa()
+{
+#if defined(FFTSIMD_AVX512)
+    return "AVX-512";
+#elif defined(FFTSIMD_AVX2)
+    return "AVX2+FMA";
+#else
+    return "scalar";
+#endif
+}
+
+template class FFT_Processor_SIMD<TFHEpp::lvl1param::n>;
+template class FFT_Processor_SIMD<TFHEpp::lvl2param::n>;
+
+FFT_Processor_SIMD<TFHEpp::lvl1param::n> fftsimdlvl1;
+FFT_Processor_SIMD<TFHEpp::lvl2param::n> fftsimdlvl2;
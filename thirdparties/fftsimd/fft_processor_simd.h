@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <params.hpp>
+
+// Negacyclic FFT dedicated to R[X]/(X^N+1) for a fixed power-of-two N.
+// The twist, the butterflies and the torus conversion are fused into one
+// pass over the data and vectorised with AVX-512 or AVX2 when the compiler
+// targets them (scalar code otherwise). Twiddle tables are computed at
+// compile time.
+//
+// The frequency domain layout is the one FFT_Processor_FFTW produces
+// (res[i] = Re, res[i + N/2] = Im, natural order), so polynomials and keys
+// in the FFT domain are interchangeable between the two processors.
+// All scratch memory lives on the stack: the processor is thread-safe.
+template <uint32_t Nval>
+class FFT_Processor_SIMD {
+public:
+    static constexpr int32_t _2N = 2 * Nval;
+    static constexpr int32_t N = Nval;
+    static constexpr int32_t Ns2 = Nval / 2;
+
+    void execute_reverse_int(double *res, const int32_t *a) const;
+
+    void execute_reverse_torus32(double *res, const uint32_t *a) const;
+
+    void execute_direct_torus32(uint32_t *res, const double *a) const;
+
+    void execute_direct_torus32_rescale(uint32_t *res, const double *a,
+                                        const double delta) const;
+
+    void execute_reverse_torus64(double *res, const uint64_t *a) const;
+
+    void execute_direct_torus64(uint64_t *res, const double *a) const;
+
+    void execute_direct_torus64_rescale(uint64_t *res, const double *a,
+                                        const double delta) const;
+
+    // Batched transforms over batch consecutive polynomials of N
+    // coefficients, spread over the OpenMP threads.
+    void execute_reverse_torus32(double *res, const uint32_t *a,
+                                 unsigned batch) const;
+
+    void execute_direct_torus32(uint32_t *res, const double *a,
+                                unsigned batch) const;
+
+    void execute_reverse_torus64(double *res, const uint64_t *a,
+                                 unsigned batch) const;
+
+    void execute_direct_torus64(uint64_t *res, const double *a,
+                                unsigned batch) const;
+};
+
+// Kernels this build runs: "AVX-512", "AVX2+FMA" or "scalar".
+const char *fftsimd_isa();
+
+extern FFT_Processor_SIMD<TFHEpp::lvl1param::n> fftsimdlvl1;
+extern FFT_Processor_SIMD<TFHEpp::lvl2param::n> fftsimdlvl2;
@@ -15,12 +15,18 @@
 FFT_Processor_FFTW::FFT_Processor_FFTW(const int32_t N)
     : _2N(2 * N), N(N), Ns2(N / 2)
 {
-    inbuf = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
-    outbuf = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
+    // fftw_malloc guarantees the SIMD alignment the plans are created with,
+    // which every per-thread workspace must match for fftw_execute_dft.
+    fftw_complex *inbuf =
+        (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
+    fftw_complex *outbuf =
+        (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
     plan_forward =
         fftw_plan_dft_1d(Ns2, inbuf, outbuf, FFTW_FORWARD, FFTW_MEASURE);
     plan_backward =
         fftw_plan_dft_1d(Ns2, inbuf, outbuf, FFTW_BACKWARD, FFTW_MEASURE);
+    fftw_free(inbuf);
+    fftw_free(outbuf);
 
     for (int i = 0; i < Ns2; i++) {
         double value = (double)i * M_PI / (double)N;
@@ -28,8 +34,32 @@ FFT_Processor_FFTW::FFT_Processor_FFTW(const int32_t N)
     }
 }
 
+FFT_Processor_FFTW::Workspace::~Workspace()
+{
+    fftw_free(inbuf);
+    fftw_free(outbuf);
+}
+
+FFT_Processor_FFTW::Workspace &FFT_Processor_FFTW::workspace() const
+{
+    // One workspace per thread, shared by all instances and grown to the
+    // largest transform used on that thread.
+    thread_local Workspace ws;
+    if (ws.size < Ns2) {
+        fftw_free(ws.inbuf);
+        fftw_free(ws.outbuf);
+        ws.inbuf = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
+        ws.outbuf = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * Ns2);
+        ws.size = Ns2;
+    }
+    return ws;
+}
+
 void FFT_Processor_FFTW::execute_reverse_int(double *res, const int32_t *a)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         auto tmp = twist[i] * std::complex((double)a[i], (double)a[Ns2 + i]);
         inbuf[i][0] = tmp.real();
@@ -49,6 +79,9 @@ void FFT_Processor_FFTW::execute_reverse_torus32(double *res, const uint32_t *a)
 
 void FFT_Processor_FFTW::execute_reverse_torus64(double *res, const uint64_t *a)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         auto tmp = twist[i] * std::complex((double)((int64_t)a[i]),
                                            (double)((int64_t)a[Ns2 + i]));
@@ -64,6 +97,9 @@ void FFT_Processor_FFTW::execute_reverse_torus64(double *res, const uint64_t *a)
 
 void FFT_Processor_FFTW::execute_direct_torus32(uint32_t *res, const double *a)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         inbuf[i][0] = a[i] / Ns2;
         inbuf[i][1] = a[Ns2 + i] / Ns2;
@@ -81,6 +117,9 @@ void FFT_Processor_FFTW::execute_direct_torus32_rescale(uint32_t *res,
                                                         const double *a,
                                                         const double delta)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         inbuf[i][0] = a[i] / Ns2;
         inbuf[i][1] = a[Ns2 + i] / Ns2;
@@ -96,6 +135,9 @@ void FFT_Processor_FFTW::execute_direct_torus32_rescale(uint32_t *res,
 
 void FFT_Processor_FFTW::execute_direct_torus64(uint64_t *res, const double *a)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         inbuf[i][0] = a[i] / Ns2;
         inbuf[i][1] = a[Ns2 + i] / Ns2;
@@ -127,6 +169,9 @@ void FFT_Processor_FFTW::execute_direct_torus64_rescale(uint64_t *res,
                                                         const double *a,
                                                         const double delta)
 {
+    Workspace &ws = workspace();
+    fftw_complex *const inbuf = ws.inbuf;
+    fftw_complex *const outbuf = ws.outbuf;
     for (int i = 0; i < Ns2; i++) {
         inbuf[i][0] = a[i] / Ns2;
         inbuf[i][1] = a[Ns2 + i] / Ns2;
@@ -139,7 +184,44 @@ void FFT_Processor_FFTW::execute_direct_torus64_rescale(uint64_t *res,
         tmp[i] = res_tmp.real();
         tmp[i + Ns2] = res_tmp.imag();
     }
-    for (int i = 0; i < N; i++) res[i] = uint64_t(std::round(tmp[i] / (delta / 4)));
+    for (int i = 0; i < N; i++)
+        res[i] = uint64_t(int64_t(std::round(tmp[i] / (delta / 4))));
+}
+
+void FFT_Processor_FFTW::execute_reverse_torus32(double *res,
+                                                 const uint32_t *a,
+                                                 unsigned batch)
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_reverse_torus32(res + i * N, a + i * N);
+}
+
+void FFT_Processor_FFTW::execute_direct_torus32(uint32_t *res,
+                                                const double *a,
+                                                unsigned batch)
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_direct_torus32(res + i * N, a + i * N);
+}
+
+void FFT_Processor_FFTW::execute_reverse_torus64(double *res,
+                                                 const uint64_t *a,
+                                                 unsigned batch)
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_reverse_torus64(res + i * N, a + i * N);
+}
+
+void FFT_Processor_FFTW::execute_direct_torus64(uint64_t *res,
+                                                const double *a,
+                                                unsigned batch)
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < (int)batch; i++)
+        execute_direct_torus64(res + i * N, a + i * N);
 }
 
 FFT_Processor_FFTW::~FFT_Processor_FFTW()
@@ -149,6 +231,5 @@ FFT_Processor_FFTW::~FFT_Processor_FFTW()
     fftw_cleanup();
 }
 
-// FFT_Processor_FFTW is thread-safe
 FFT_Processor_FFTW fftplvl1(TFHEpp::lvl1param::n);
 FFT_Processor_FFTW fftplvl2(TFHEpp::lvl2param::n);
\ No newline at end of file
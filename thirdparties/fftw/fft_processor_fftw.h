@@ -19,8 +19,17 @@ private:
     std::vector<std::complex<double>> twist;
     fftw_plan plan_forward;
     fftw_plan plan_backward;
-    fftw_complex *inbuf;
-    fftw_complex *outbuf;
+
+    // The plans and the twist table are shared and never written after
+    // construction. Scratch buffers are owned by the calling thread, so the
+    // plans are only ever run through fftw_execute_dft on per-thread arrays.
+    struct Workspace {
+        fftw_complex *inbuf = nullptr;
+        fftw_complex *outbuf = nullptr;
+        int32_t size = 0;
+        ~Workspace();
+    };
+    Workspace &workspace() const;
 
 public:
     FFT_Processor_FFTW(const int32_t N);
@@ -41,9 +50,24 @@ public:
     void execute_direct_torus64_rescale(uint64_t *res, const double *a,
                                         const double delta);
 
+    // Batched transforms over batch consecutive polynomials of N
+    // coefficients, spread over the OpenMP threads.
+    void execute_reverse_torus32(double *res, const uint32_t *a,
+                                 unsigned batch);
+
+    void execute_direct_torus32(uint32_t *res, const double *a,
+                                unsigned batch);
+
+    void execute_reverse_torus64(double *res, const uint64_t *a,
+                                 unsigned batch);
+
+    void execute_direct_torus64(uint64_t *res, const double *a,
+                                unsigned batch);
+
     ~FFT_Processor_FFTW();
 };
 
-// FFT_Processor_FFTW is thread-safe
+// FFT_Processor_FFTW is thread-safe: every thread gets its own scratch
+// buffers, so concurrent calls on the same instance do not share state.
 extern FFT_Processor_FFTW fftplvl1;
 extern FFT_Processor_FFTW fftplvl2;
\ No newline at end of file
@@ -12,82 +12,130 @@
 
 
 FFT_Processor_FPGA::FFT_Processor_FPGA(const int32_t N)
-    : _2N(2 * N), N(N), Ns2(N / 2)
+    : _2N(2 * N), N(N), Ns2(N / 2), twist(N / 2)
 {
-    inbuf = new float2[Ns2*max_batch]();
-    outbuf = new float2[Ns2*max_batch]();
+    initialized = fpga_initialize();
+    // Device buffers, kernels and queues are set up once for the largest
+    // batch instead of on every transform.
+    if (initialized) fftfpgaf_c2c_1d_reserve(Ns2, max_batch);
+    pipeline = std::make_unique<TFHEpp::FFTOffloadPipeline>(
+        Ns2, max_batch,
+        [](unsigned num, const float2 *inp, float2 *out, bool inv,
+           unsigned batch) { return fpga_fft(num, inp, out, inv, batch); });
+}
 
-    for (int i = 0; i < Ns2; i++) {
-        double value = (double)i * M_PI / (double)N;
-        twist.push_back(std::complex<double>(std::cos(value), std::sin(value)));
+TFHEpp::FFTTicket FFT_Processor_FPGA::submit(
+    bool inv, unsigned batch,
+    const std::function<void(float2 *, unsigned, unsigned)> &fill,
+    const std::function<void(const float2 *, unsigned, unsigned)> &drain)
+{
+    TFHEpp::FFTTicket ticket = 0;
+    for (unsigned first = 0; first < batch; first += max_batch) {
+        const unsigned count = std::min<unsigned>(max_batch, batch - first);
+        ticket = pipeline->submit(
+            inv, count, [&](float2 *inbuf) { fill(inbuf, first, count); },
+            [drain, first, count](const float2 *outbuf) {
+                drain(outbuf, first, count);
+            });
     }
-    fpga_initialize();
+    return ticket;
 }
 
-void FFT_Processor_FPGA::execute_reverse_int(double *res, const int32_t *a, unsigned batch)
+void FFT_Processor_FPGA::wait(TFHEpp::FFTTicket ticket)
+{
+    pipeline->wait(ticket);
+}
+
+TFHEpp::FFTTicket FFT_Processor_FPGA::submit_reverse_int(double *res, const int32_t *a, unsigned batch)
 {
-    for(unsigned j = 0; j < batch; j++) {
-        for (unsigned i = 0; i < Ns2; i++) {
-            unsigned aIndex = (j*N) + i;
-            unsigned index = (j*Ns2) + i;
-            auto tmp =
-                twist[i] * std::complex((double)a[aIndex], (double)a[Ns2 + aIndex]);
-            inbuf[index].x = tmp.real();
-            inbuf[index].y = tmp.imag();
+    auto fill = [this, a](float2 *inbuf, unsigned first, unsigned count) {
+        for (unsigned j = 0; j < count; j++) {
+            const int32_t *aj = a + (size_t)(first + j) * N;
+            twist.twist_in(inbuf + (size_t)j * Ns2, [aj, this](int32_t i, double &re, double &im) {
+                re = aj[i];
+                im = aj[Ns2 + i];
+            });
         }
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, false, batch);
-    for(unsigned j = 0; j < batch; j++) {
-        for (unsigned i = 0; i < Ns2; i++) {
-            unsigned resIndex = (j*N) + i;
-            unsigned index = (j*Ns2) + i;
-            res[resIndex] = outbuf[index].x;
-            res[resIndex + Ns2] = outbuf[index].y;
+    };
+    auto drain = [this, res](const float2 *outbuf, unsigned first, unsigned count) {
+        for (unsigned j = 0; j < count; j++) {
+            double *resj = res + (size_t)(first + j) * N;
+            twist.reorder_out(outbuf + (size_t)j * Ns2, [resj, this](int32_t i, double re, double im) {
+                resj[i] = re;
+                resj[i + Ns2] = im;
+            });
         }
-    }
+    };
+    return submit(false, batch, fill, drain);
+}
+
+TFHEpp::FFTTicket FFT_Processor_FPGA::submit_reverse_torus32(double *res, const uint32_t *a, unsigned batch)
+{
+    return submit_reverse_int(res, (const int32_t *)a, batch);
+}
+
+TFHEpp::FFTTicket FFT_Processor_FPGA::submit_direct_torus32(uint32_t *res, const double *a, unsigned batch)
+{
+    auto fill = [this, a](float2 *inbuf, unsigned first, unsigned count) {
+        for (unsigned j = 0; j < count; j++) {
+            for (unsigned i = 0; i < Ns2; i++) {
+                unsigned aIndex = ((first + j) * N) + i;
+                unsigned index = (j * Ns2) + i;
+                inbuf[index].x = a[aIndex] / Ns2;
+                inbuf[index].y = a[Ns2 + aIndex] / Ns2;
+            }
+        }
+    };
+    auto drain = [this, res](const float2 *outbuf, unsigned first, unsigned count) {
+        for (unsigned j = 0; j < count; j++) {
+            uint32_t *resj = res + (size_t)(first + j) * N;
+            twist.untwist_out(outbuf + (size_t)j * Ns2, [resj, this](int32_t i, double re, double im) {
+                resj[i] = CAST_DOUBLE_TO_UINT32(re);
+                resj[i + Ns2] = CAST_DOUBLE_TO_UINT32(im);
+            });
+        }
+    };
+    return submit(true, batch, fill, drain);
+}
+
+void FFT_Processor_FPGA::execute_reverse_int(double *res, const int32_t *a, unsigned batch)
+{
+    wait(submit_reverse_int(res, a, batch));
 }
 
 void FFT_Processor_FPGA::execute_reverse_torus32(double *res, const uint32_t *a, unsigned batch)
 {
-    execute_reverse_int(res, (int32_t *)a, batch);
+    wait(submit_reverse_torus32(res, a, batch));
 }
 
+void FFT_Processor_FPGA::execute_direct_torus32(uint32_t *res, const double *a, unsigned batch)
+{
+    wait(submit_direct_torus32(res, a, batch));
+}
 
 void FFT_Processor_FPGA::execute_reverse_torus64(double *res, const uint64_t *a)
 {
-    for (int i = 0; i < Ns2; i++) {
-        auto tmp = twist[i] * std::complex((double)((int64_t)a[i]),
-                                           (double)((int64_t)a[Ns2 + i]));
-        inbuf[i].x = tmp.real();
-        inbuf[i].y = tmp.imag();
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, false);
-    for (int i = 0; i < Ns2; i++) {
-        res[i] = outbuf[i].x;
-        res[i + Ns2] = outbuf[i].y;
-    }
+    auto fill = [this, a](float2 *inbuf, unsigned, unsigned) {
+        twist.twist_in(inbuf, [a, this](int32_t i, double &re, double &im) {
+            re = (double)((int64_t)a[i]);
+            im = (double)((int64_t)a[Ns2 + i]);
+        });
+    };
+    auto drain = [this, res](const float2 *outbuf, unsigned, unsigned) {
+        twist.reorder_out(outbuf, [res, this](int32_t i, double re, double im) {
+            res[i] = re;
+            res[i + Ns2] = im;
+        });
+    };
+    wait(submit(false, 1, fill, drain));
 }
 
-void FFT_Processor_FPGA::execute_direct_torus32(uint32_t *res, const double *a, unsigned batch)
+// The inverse transforms below share the device input: a / (N/2).
+static void scale_in(float2 *inbuf, const double *a, const int32_t Ns2)
 {
-    for(unsigned j = 0; j < batch; j++) {
-        for (unsigned i = 0; i < Ns2; i++) {
-            unsigned aIndex = (j * N) + i;
-            unsigned index = (j * Ns2) + i;
-            inbuf[index].x = a[aIndex] / Ns2;
-            inbuf[index].y = a[Ns2 + aIndex] / Ns2;
-        }
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, true, batch);
-    for(unsigned j = 0; j < batch; j++) {
-        for (unsigned i = 0; i < Ns2; i++) {
-            unsigned resIndex = (j*N) + i;
-            unsigned index = (j*Ns2) + i;
-            auto res_tmp = std::complex<double>(outbuf[index].x, outbuf[index].y) *
-                           std::conj(twist[i]);
-            res[resIndex] = CAST_DOUBLE_TO_UINT32(res_tmp.real());
-            res[resIndex + Ns2] = CAST_DOUBLE_TO_UINT32(res_tmp.imag());
-        }
+    for (int i = 0; i < Ns2; i++) {
+        inbuf[i].x = a[i] / Ns2;
+        inbuf[i].y  = a[Ns2 + i] / Ns2;
     }
 }
 
@@ -95,34 +143,28 @@ void FFT_Processor_FPGA::execute_direct_torus32_rescale(uint32_t *res,
                                                         const double *a,
                                                         const double delta)
 {
-    for (int i = 0; i < Ns2; i++) {
-        inbuf[i].x = a[i] / Ns2;
-        inbuf[i].y  = a[Ns2 + i] / Ns2;
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, true);
-    for (int i = 0; i < Ns2; i++) {
-        auto res_tmp = std::complex<double>(outbuf[i].x , outbuf[i].y) *
-                       std::conj(twist[i]);
-        res[i] = CAST_DOUBLE_TO_UINT32(res_tmp.real() / (delta / 4));
-        res[i + Ns2] = CAST_DOUBLE_TO_UINT32(res_tmp.imag() / (delta / 4));
-    }
+    auto fill = [this, a](float2 *inbuf, unsigned, unsigned) { scale_in(inbuf, a, Ns2); };
+    auto drain = [this, res, delta](const float2 *outbuf, unsigned, unsigned) {
+        twist.untwist_out(outbuf, [res, delta, this](int32_t i, double re, double im) {
+            res[i] = CAST_DOUBLE_TO_UINT32(re / (delta / 4));
+            res[i + Ns2] = CAST_DOUBLE_TO_UINT32(im / (delta / 4));
+        });
+    };
+    wait(submit(true, 1, fill, drain));
 }
 
 void FFT_Processor_FPGA::execute_direct_torus64(uint64_t *res, const double *a)
 {
-    for (int i = 0; i < Ns2; i++) {
-        inbuf[i].x = a[i] / Ns2;
-        inbuf[i].y  = a[Ns2 + i] / Ns2;
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, true);
-    double tmp[N];
-    for (int i = 0; i < Ns2; i++) {
-        auto res_tmp = std::complex<double>(outbuf[i].x, outbuf[i].y) *
-                       std::conj(twist[i]);
-        tmp[i] = res_tmp.real();
-        tmp[i + Ns2] = res_tmp.imag();
-    }
-    const uint64_t *const vals = (const uint64_t *)tmp;
+    std::vector<double> tmp(N);
+    auto fill = [this, a](float2 *inbuf, unsigned, unsigned) { scale_in(inbuf, a, Ns2); };
+    auto drain = [this, &tmp](const float2 *outbuf, unsigned, unsigned) {
+        twist.untwist_out(outbuf, [&tmp, this](int32_t i, double re, double im) {
+            tmp[i] = re;
+            tmp[i + Ns2] = im;
+        });
+    };
+    wait(submit(true, 1, fill, drain));
+    const uint64_t *const vals = (const uint64_t *)tmp.data();
     constexpr uint64_t valmask0 = 0x000FFFFFFFFFFFFFul;
     constexpr uint64_t valmask1 = 0x0010000000000000ul;
     constexpr uint16_t expmask0 = 0x07FFu;
@@ -141,26 +183,23 @@ void FFT_Processor_FPGA::execute_direct_torus64_rescale(uint64_t *res,
                                                         const double *a,
                                                         const double delta)
 {
-    for (int i = 0; i < Ns2; i++) {
-        inbuf[i].x = a[i] / Ns2;
-        inbuf[i].y  = a[Ns2 + i] / Ns2;
-    }
-    runTimeRc = fpga_fft(Ns2, inbuf, outbuf, true);
-    double tmp[N];
-    for (int i = 0; i < Ns2; i++) {
-        auto res_tmp = std::complex<double>(outbuf[i].x, outbuf[i].y) *
-                       std::conj(twist[i]);
-        tmp[i] = res_tmp.real();
-        tmp[i + Ns2] = res_tmp.imag();
-    }
-    for (int i = 0; i < N; i++) res[i] = uint64_t(std::round(tmp[i] / (delta / 4)));
+    std::vector<double> tmp(N);
+    auto fill = [this, a](float2 *inbuf, unsigned, unsigned) { scale_in(inbuf, a, Ns2); };
+    auto drain = [this, &tmp](const float2 *outbuf, unsigned, unsigned) {
+        twist.untwist_out(outbuf, [&tmp, this](int32_t i, double re, double im) {
+            tmp[i] = re;
+            tmp[i + Ns2] = im;
+        });
+    };
+    wait(submit(true, 1, fill, drain));
+    for (int i = 0; i < N; i++)
+        res[i] = uint64_t(int64_t(std::round(tmp[i] / (delta / 4))));
 }
 
 FFT_Processor_FPGA::~FFT_Processor_FPGA()
 {
-
-    delete[] inbuf;
-    delete[] outbuf;
+    // Finish whatever is still in flight before the device goes away.
+    pipeline.reset();
 
     fpga_close();
 }
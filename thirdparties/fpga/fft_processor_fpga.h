@@ -4,8 +4,12 @@
 #include <cmath>
 #include <complex>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 #include "fftfpga.h"
+#include "fftpipeline.hpp"
+#include "fpga_twist.h"
 
 class FFT_Processor_FPGA {
 public:
@@ -14,14 +18,38 @@ public:
     const int32_t Ns2;
 
 private:
-    std::vector<std::complex<double>> twist;
-    float2 *inbuf;
-    float2 *outbuf;
-    fpga_t runTimeRc;
+    // Also undoes the bit-reversed order of the device output.
+    FPGATwist twist;
+    // Two host buffer sets in flight: twisting the next batch overlaps
+    // with the transfer and execution of the current one.
+    std::unique_ptr<TFHEpp::FFTOffloadPipeline> pipeline;
+    bool initialized;
+
+    // Splits batches larger than the buffer sets into several transforms
+    // and returns the ticket of the last one.
+    TFHEpp::FFTTicket submit(bool inv, unsigned batch,
+                             const std::function<void(float2 *, unsigned, unsigned)> &fill,
+                             const std::function<void(const float2 *, unsigned, unsigned)> &drain);
 
 public:
     FFT_Processor_FPGA(const int32_t N);
 
+    // False when the device could not be initialised.
+    bool available() const { return initialized; }
+
+    // Asynchronous batched transforms: a may be reused on return, res is
+    // written by the time wait() returns for this ticket or a later one.
+    TFHEpp::FFTTicket submit_reverse_int(double *res, const int32_t *a, unsigned batch);
+
+    TFHEpp::FFTTicket submit_reverse_torus32(double *res, const uint32_t *a, unsigned batch);
+
+    TFHEpp::FFTTicket submit_direct_torus32(uint32_t *res, const double *a, unsigned batch);
+
+    void wait(TFHEpp::FFTTicket ticket);
+
+    // Device timing of the last completed transform.
+    fpga_t runtime() const { return pipeline->runtime(); }
+
     void execute_reverse_int(double *res, const int32_t *a, unsigned batch);
 
     void execute_reverse_torus32(double *res, const uint32_t *a, unsigned batch = 1);
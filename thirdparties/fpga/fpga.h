@@ -1,7 +1,9 @@
 #pragma once
 #include "fftfpga.h"
 
-void fpga_initialize();
+// Returns false if no FPGA could be set up.
+bool fpga_initialize();
 void fpga_close();
+// Output of each transform is in bit-reversed order.
 fpga_t fpga_fft(const unsigned num, const float2 *inp, float2 *out, const bool inv, const unsigned batch=1);
 
@@ -0,0 +1,69 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "fftfpga.h"
+
+// Twist factors of the negacyclic FFT together with the bit-reversal
+// permutation the FPGA kernel leaves its output in. The untwist reads the
+// device output through the permutation table, so no separate reordering
+// pass or temporary buffer is needed. The real and imaginary parts are kept
+// in separate arrays so the loops vectorise.
+class FPGATwist {
+public:
+    explicit FPGATwist(const int32_t Ns2) : Ns2(Ns2), re(Ns2), im(Ns2), bitrev(Ns2)
+    {
+        const int32_t N = 2 * Ns2;
+        unsigned bits = 0;
+        while ((1 << bits) < Ns2) bits++;
+        for (int32_t i = 0; i < Ns2; i++) {
+            const double value = (double)i * M_PI / (double)N;
+            re[i] = std::cos(value);
+            im[i] = std::sin(value);
+            uint32_t x = i, y = 0;
+            for (unsigned b = 0; b < bits; b++, x >>= 1) y = (y << 1) | (x & 1);
+            bitrev[i] = y;
+        }
+    }
+
+    // inbuf[i] = twist[i] * (a_re + i a_im), where load(i, a_re, a_im)
+    // provides the coefficient pair i.
+    template <class Load>
+    void twist_in(float2 *inbuf, Load &&load) const
+    {
+        for (int32_t i = 0; i < Ns2; i++) {
+            double a_re, a_im;
+            load(i, a_re, a_im);
+            inbuf[i].x = re[i] * a_re - im[i] * a_im;
+            inbuf[i].y = re[i] * a_im + im[i] * a_re;
+        }
+    }
+
+    // Forward transform output in natural order: store(i, re, im).
+    template <class Store>
+    void reorder_out(const float2 *outbuf, Store &&store) const
+    {
+        for (int32_t i = 0; i < Ns2; i++) {
+            const float2 v = outbuf[bitrev[i]];
+            store(i, (double)v.x, (double)v.y);
+        }
+    }
+
+    // Inverse transform output untwisted in natural order:
+    // store(i, re, im) of conj(twist[i]) * out[i].
+    template <class Store>
+    void untwist_out(const float2 *outbuf, Store &&store) const
+    {
+        for (int32_t i = 0; i < Ns2; i++) {
+            const float2 v = outbuf[bitrev[i]];
+            const double x = v.x, y = v.y;
+            store(i, x * re[i] + y * im[i], y * re[i] - x * im[i]);
+        }
+    }
+
+    const int32_t Ns2;
+
+private:
+    std::vector<double> re, im;
+    std::vector<uint32_t> bitrev;
+};
@@ -0,0 +1,446 @@
+#include "ntt_processor_simd.h"
+
+#include <array>
+#include <cstdint>
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+#define NTTSIMD_AVX512
+#include <immintrin.h>
+#endif
+
+namespace {
+
+__extension__ typedef unsigned __int128 u128;
+
+constexpr uint64_t P = 0x3fffffffffff0001ULL;
+// 7 generates the multiplicative group of Z_P.
+constexpr uint64_t generator = 7;
+
+// ---------------------------------------------------------------------------
+// Scalar modular arithmetic. Residues are kept in [0, P); P < 2^62 leaves
+// room for the unreduced sums below.
+// ---------------------------------------------------------------------------
+
+constexpr uint64_t add_mod(uint64_t a, uint64_t b)
+{
+    const uint64_t s = a + b;
+    return s >= P ? s - P : s;
+}
+
+constexpr uint64_t sub_mod(uint64_t a, uint64_t b)
+{
+    return a >= b ? a - b : a + P - b;
+}
+
+constexpr uint64_t mul_mod(uint64_t a, uint64_t b)
+{
+    return (u128)a * b % P;
+}
+
+constexpr uint64_t pow_mod(uint64_t a, uint64_t e)
+{
+    uint64_t r = 1;
+    for (; e; e >>= 1, a = mul_mod(a, a))
+        if (e & 1) r = mul_mod(r, a);
+    return r;
+}
+
+// floor(w * 2^64 / P), for w * x mod P without a division.
+constexpr uint64_t shoup(uint64_t w) { return ((u128)w << 64) / P; }
+
+inline uint64_t mul_shoup(uint64_t x, uint64_t w, uint64_t wshoup)
+{
+    const uint64_t q = ((u128)x * wshoup) >> 64;
+    const uint64_t r = x * w - q * P;  // in [0, 2P)
+    return r >= P ? r - P : r;
+}
+
+// P^-1 mod 2^64 by Newton iteration.
+constexpr uint64_t inverse_mod_2_64()
+{
+    uint64_t x = P;
+    for (int i = 0; i < 6; i++) x *= 2 - P * x;
+    return x;
+}
+constexpr uint64_t Pinv = inverse_mod_2_64();
+// R^2 mod P with R = 2^64: converts into Montgomery form.
+constexpr uint64_t R2 = (u128)((((u128)1 << 64) % P)) * ((((u128)1 << 64) % P)) % P;
+
+// a * b / 2^64 mod P.
+inline uint64_t mul_montgomery(uint64_t a, uint64_t b)
+{
+    const u128 t = (u128)a * b;
+    const uint64_t m = (uint64_t)t * Pinv;
+    const uint64_t hi = t >> 64, mp = ((u128)m * P) >> 64;
+    return hi >= mp ? hi - mp : hi + P - mp;
+}
+
+constexpr uint32_t bit_reverse(uint32_t x, uint32_t bits)
+{
+    uint32_t y = 0;
+    for (uint32_t i = 0; i < bits; i++, x >>= 1) y = (y << 1) | (x & 1);
+    return y;
+}
+
+// Powers of a primitive 2N-th root psi in bit-reversed order, as the
+// merged negacyclic butterflies consume them, with their Shoup quotients.
+//
+// The three shortest stages (t = 4, 2, 1) pair elements inside a vector;
+// for them each butterfly gets its own twiddle, in butterfly order.
+template <uint32_t N>
+struct Tables {
+    alignas(64) std::array<uint64_t, N> psi{}, psi_shoup{};
+    alignas(64) std::array<uint64_t, N> psiinv{}, psiinv_shoup{};
+    alignas(64) std::array<std::array<uint64_t, N / 2>, 3> psi_short{},
+        psi_short_shoup{};
+    alignas(64) std::array<std::array<uint64_t, N / 2>, 3> psiinv_short{},
+        psiinv_short_shoup{};
+    uint64_t ninv = 0, ninv_shoup = 0;
+
+    constexpr Tables()
+    {
+        uint32_t bits = 0;
+        while ((1u << bits) < N) bits++;
+        const uint64_t root = pow_mod(generator, (P - 1) / (2 * N));
+        const uint64_t rootinv = pow_mod(root, P - 2);
+        for (uint32_t i = 0; i < N; i++) {
+            const uint32_t e = bit_reverse(i, bits);
+            psi[i] = pow_mod(root, e);
+            psi_shoup[i] = shoup(psi[i]);
+            psiinv[i] = pow_mod(rootinv, e);
+            psiinv_shoup[i] = shoup(psiinv[i]);
+        }
+        for (uint32_t s = 0, t = 4; s < 3; s++, t >>= 1)
+            for (uint32_t j = 0; j < N / 2; j++) {
+                const uint32_t m = N / (2 * t);
+                psi_short[s][j] = psi[m + j / t];
+                psi_short_shoup[s][j] = psi_shoup[m + j / t];
+                psiinv_short[s][j] = psiinv[m + j / t];
+                psiinv_short_shoup[s][j] = psiinv_shoup[m + j / t];
+            }
+        ninv = pow_mod(N, P - 2);
+        ninv_shoup = shoup(ninv);
+    }
+};
+
+template <uint32_t N>
+const Tables<N> tables{};
+
+// ---------------------------------------------------------------------------
+// AVX-512 layer: eight residues per vector. There is no 64x64->128 bit
+// multiply, so the high half is assembled from four 32x32 products.
+// ---------------------------------------------------------------------------
+
+#if defined(NTTSIMD_AVX512)
+
+constexpr int W = 8;
+
+inline __m512i mulhi(__m512i a, __m512i b)
+{
+    const __m512i lo32 = _mm512_set1_epi64(0xffffffff);
+    const __m512i ah = _mm512_srli_epi64(a, 32), bh = _mm512_srli_epi64(b, 32);
+    const __m512i ll = _mm512_mul_epu32(a, b);
+    const __m512i lh = _mm512_mul_epu32(a, bh);
+    const __m512i hl = _mm512_mul_epu32(ah, b);
+    const __m512i hh = _mm512_mul_epu32(ah, bh);
+    __m512i mid = _mm512_add_epi64(_mm512_srli_epi64(ll, 32),
+                                   _mm512_and_si512(lh, lo32));
+    mid = _mm512_add_epi64(mid, _mm512_and_si512(hl, lo32));
+    __m512i hi = _mm512_add_epi64(hh, _mm512_srli_epi64(lh, 32));
+    hi = _mm512_add_epi64(hi, _mm512_srli_epi64(hl, 32));
+    return _mm512_add_epi64(hi, _mm512_srli_epi64(mid, 32));
+}
+
+// x - P if x >= P: below P the subtraction wraps to a larger value.
+inline __m512i reduce_once(__m512i x, __m512i p)
+{
+    return _mm512_min_epu64(x, _mm512_sub_epi64(x, p));
+}
+
+inline __m512i vadd(__m512i a, __m512i b, __m512i p)
+{
+    return reduce_once(_mm512_add_epi64(a, b), p);
+}
+
+inline __m512i vsub(__m512i a, __m512i b, __m512i p)
+{
+    return reduce_once(_mm512_add_epi64(_mm512_sub_epi64(a, b), p), p);
+}
+
+// q * P mod 2^64 with shifts, P = 2^62 - 2^16 + 1.
+inline __m512i mullo_p(__m512i q)
+{
+    return _mm512_add_epi64(
+        _mm512_sub_epi64(_mm512_slli_epi64(q, 62), _mm512_slli_epi64(q, 16)),
+        q);
+}
+
+inline __m512i vmul_shoup(__m512i x, __m512i w, __m512i wshoup, __m512i p)
+{
+    const __m512i q = mulhi(x, wshoup);
+    return reduce_once(
+        _mm512_sub_epi64(_mm512_mullo_epi64(x, w), mullo_p(q)), p);
+}
+
+inline __m512i vmul_montgomery(__m512i a, __m512i b, __m512i p)
+{
+    const __m512i m =
+        _mm512_mullo_epi64(_mm512_mullo_epi64(a, b), _mm512_set1_epi64(Pinv));
+    const __m512i r = _mm512_add_epi64(_mm512_sub_epi64(mulhi(a, b), mulhi(m, p)), p);
+    return reduce_once(r, p);
+}
+
+// Butterflies of distance t < W inside a pair of vectors a, b (16
+// consecutive residues): x gathers the first element of each of the eight
+// butterflies and y the second, in butterfly order.
+template <uint32_t t>
+struct ShortStage {
+    static constexpr std::array<int64_t, W> index(bool second)
+    {
+        std::array<int64_t, W> idx{};
+        for (uint32_t k = 0; k < W; k++)
+            idx[k] = (k / t) * 2 * t + k % t + (second ? t : 0);
+        return idx;
+    }
+    static constexpr std::array<int64_t, W> back(uint32_t half)
+    {
+        std::array<int64_t, W> idx{};
+        for (uint32_t e = half * W; e < (half + 1) * W; e++) {
+            const uint32_t g = e / (2 * t), r = e % (2 * t);
+            idx[e - half * W] = r < t ? g * t + r : W + g * t + r - t;
+        }
+        return idx;
+    }
+    static constexpr std::array<int64_t, W> xi = index(false), yi = index(true),
+                                            ai = back(0), bi = back(1);
+
+    static void split(__m512i &x, __m512i &y, __m512i a, __m512i b)
+    {
+        x = _mm512_permutex2var_epi64(a, _mm512_loadu_si512(xi.data()), b);
+        y = _mm512_permutex2var_epi64(a, _mm512_loadu_si512(yi.data()), b);
+    }
+    static void merge(__m512i &a, __m512i &b, __m512i x, __m512i y)
+    {
+        a = _mm512_permutex2var_epi64(x, _mm512_loadu_si512(ai.data()), y);
+        b = _mm512_permutex2var_epi64(x, _mm512_loadu_si512(bi.data()), y);
+    }
+};
+
+#endif
+
+#if defined(NTTSIMD_AVX512)
+template <uint32_t t, uint32_t N>
+void forward_short(uint64_t *a, const Tables<N> &tb, uint32_t s)
+{
+    const __m512i p = _mm512_set1_epi64(P);
+    for (uint32_t v = 0; v < N / (2 * W); v++) {
+        __m512i x, y, u, w;
+        ShortStage<t>::split(x, y, _mm512_loadu_si512(a + 2 * W * v),
+                             _mm512_loadu_si512(a + 2 * W * v + W));
+        y = vmul_shoup(y, _mm512_load_si512(tb.psi_short[s].data() + W * v),
+                       _mm512_load_si512(tb.psi_short_shoup[s].data() + W * v),
+                       p);
+        ShortStage<t>::merge(u, w, vadd(x, y, p), vsub(x, y, p));
+        _mm512_storeu_si512(a + 2 * W * v, u);
+        _mm512_storeu_si512(a + 2 * W * v + W, w);
+    }
+}
+
+template <uint32_t t, uint32_t N>
+void inverse_short(uint64_t *a, const Tables<N> &tb, uint32_t s)
+{
+    const __m512i p = _mm512_set1_epi64(P);
+    for (uint32_t v = 0; v < N / (2 * W); v++) {
+        __m512i x, y, u, w;
+        ShortStage<t>::split(x, y, _mm512_loadu_si512(a + 2 * W * v),
+                             _mm512_loadu_si512(a + 2 * W * v + W));
+        ShortStage<t>::merge(
+            u, w, vadd(x, y, p),
+            vmul_shoup(vsub(x, y, p),
+                       _mm512_load_si512(tb.psiinv_short[s].data() + W * v),
+                       _mm512_load_si512(tb.psiinv_short_shoup[s].data() +
+                                         W * v),
+                       p));
+        _mm512_storeu_si512(a + 2 * W * v, u);
+        _mm512_storeu_si512(a + 2 * W * v + W, w);
+    }
+}
+#endif
+
+}  // namespace
+
+// Cooley-Tukey, natural order in, bit-reversed order out.
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::forward(uint64_t *a) const
+{
+    const Tables<Nval> &tb = tables<Nval>;
+    uint32_t t = Nval;
+    for (uint32_t m = 1; m < Nval; m <<= 1) {
+        t >>= 1;
+#if defined(NTTSIMD_AVX512)
+        if (t < W) {
+            forward_short<4>(a, tb, 0);
+            forward_short<2>(a, tb, 1);
+            forward_short<1>(a, tb, 2);
+            return;
+        }
+        const __m512i p = _mm512_set1_epi64(P);
+#endif
+        for (uint32_t i = 0; i < m; i++) {
+            uint64_t *x = a + 2 * i * t, *y = x + t;
+            const uint64_t s = tb.psi[m + i], sshoup = tb.psi_shoup[m + i];
+            uint32_t j = 0;
+#if defined(NTTSIMD_AVX512)
+            const __m512i vs = _mm512_set1_epi64(s), vsshoup = _mm512_set1_epi64(sshoup);
+            for (; j < t; j += W) {
+                const __m512i u = _mm512_loadu_si512(x + j);
+                const __m512i v = vmul_shoup(_mm512_loadu_si512(y + j), vs, vsshoup, p);
+                _mm512_storeu_si512(x + j, vadd(u, v, p));
+                _mm512_storeu_si512(y + j, vsub(u, v, p));
+            }
+#endif
+            for (; j < t; j++) {
+                const uint64_t u = x[j], v = mul_shoup(y[j], s, sshoup);
+                x[j] = add_mod(u, v);
+                y[j] = sub_mod(u, v);
+            }
+        }
+    }
+}
+
+// Gentleman-Sande, bit-reversed order in, natural order out, without the
+// final division by N.
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::inverse(uint64_t *a) const
+{
+    const Tables<Nval> &tb = tables<Nval>;
+    uint32_t t = 1;
+#if defined(NTTSIMD_AVX512)
+    inverse_short<1>(a, tb, 2);
+    inverse_short<2>(a, tb, 1);
+    inverse_short<4>(a, tb, 0);
+    t = W;
+    const __m512i p = _mm512_set1_epi64(P);
+#endif
+    for (uint32_t m = Nval / t; m > 1; m >>= 1) {
+        const uint32_t h = m >> 1;
+        for (uint32_t i = 0; i < h; i++) {
+            uint64_t *x = a + 2 * i * t, *y = x + t;
+            const uint64_t s = tb.psiinv[h + i], sshoup = tb.psiinv_shoup[h + i];
+            uint32_t j = 0;
+#if defined(NTTSIMD_AVX512)
+            const __m512i vs = _mm512_set1_epi64(s), vsshoup = _mm512_set1_epi64(sshoup);
+            for (; j < t; j += W) {
+                const __m512i u = _mm512_loadu_si512(x + j);
+                const __m512i v = _mm512_loadu_si512(y + j);
+                _mm512_storeu_si512(x + j, vadd(u, v, p));
+                _mm512_storeu_si512(y + j, vmul_shoup(vsub(u, v, p), vs, vsshoup, p));
+            }
+#endif
+            for (; j < t; j++) {
+                const uint64_t u = x[j], v = y[j];
+                x[j] = add_mod(u, v);
+                y[j] = mul_shoup(sub_mod(u, v), s, sshoup);
+            }
+        }
+        t <<= 1;
+    }
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::execute_reverse_int(uint64_t *res,
+                                                   const int32_t *a) const
+{
+    int i = 0;
+#if defined(NTTSIMD_AVX512)
+    const __m512i p = _mm512_set1_epi64(P);
+    for (; i < N; i += W) {
+        const __m512i v = _mm512_cvtepi32_epi64(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+        _mm512_storeu_si512(
+            res + i, _mm512_mask_add_epi64(v, _mm512_movepi64_mask(v), v, p));
+    }
+#endif
+    for (; i < N; i++) res[i] = a[i] < 0 ? P - uint64_t(-(int64_t)a[i]) : a[i];
+    forward(res);
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::execute_reverse_int_montgomery(
+    uint64_t *res, const int32_t *a) const
+{
+    execute_reverse_int(res, a);
+    for (int i = 0; i < N; i++) res[i] = mul_montgomery(res[i], R2);
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::execute_direct_int64(int64_t *res,
+                                                    const uint64_t *a) const
+{
+    uint64_t *tmp = reinterpret_cast<uint64_t *>(res);
+    for (int i = 0; i < N; i++) tmp[i] = a[i];
+    inverse(tmp);
+    const Tables<Nval> &tb = tables<Nval>;
+    int i = 0;
+#if defined(NTTSIMD_AVX512)
+    const __m512i p = _mm512_set1_epi64(P), half = _mm512_set1_epi64(P / 2);
+    const __m512i vninv = _mm512_set1_epi64(tb.ninv),
+                  vninvshoup = _mm512_set1_epi64(tb.ninv_shoup);
+    for (; i < N; i += W) {
+        const __m512i v =
+            vmul_shoup(_mm512_loadu_si512(tmp + i), vninv, vninvshoup, p);
+        _mm512_storeu_si512(
+            res + i,
+            _mm512_mask_sub_epi64(v, _mm512_cmpgt_epu64_mask(v, half), v, p));
+    }
+#endif
+    for (; i < N; i++) {
+        const uint64_t v = mul_shoup(tmp[i], tb.ninv, tb.ninv_shoup);
+        res[i] = v > P / 2 ? -(int64_t)(P - v) : (int64_t)v;
+    }
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::execute_direct_torus32(uint32_t *res,
+                                                      const uint64_t *a) const
+{
+    alignas(64) int64_t tmp[Nval];
+    execute_direct_int64(tmp, a);
+    for (int i = 0; i < N; i++) res[i] = (uint32_t)tmp[i];
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::mul(uint64_t *res, const uint64_t *a,
+                                   const uint64_t *b)
+{
+    int i = 0;
+#if defined(NTTSIMD_AVX512)
+    const __m512i p = _mm512_set1_epi64(P);
+    for (; i + W <= N; i += W)
+        _mm512_storeu_si512(res + i, vmul_montgomery(_mm512_loadu_si512(a + i),
+                                                     _mm512_loadu_si512(b + i), p));
+#endif
+    for (; i < N; i++) res[i] = mul_montgomery(a[i], b[i]);
+}
+
+template <uint32_t Nval>
+void NTT_Processor_SIMD<Nval>::fma(uint64_t *res, const uint64_t *a,
+                                   const uint64_t *b)
+{
+    int i = 0;
+#if defined(NTTSIMD_AVX512)
+    const __m512i p = _mm512_set1_epi64(P);
+    for (; i + W <= N; i += W) {
+        const __m512i prod = vmul_montgomery(_mm512_loadu_si512(a + i),
+                                             _mm512_loadu_si512(b + i), p);
+        _mm512_storeu_si512(res + i, vadd(_mm512_loadu_si512(res + i), prod, p));
+    }
+#endif
+    for (; i < N; i++) res[i] = add_mod(res[i], mul_montgomery(a[i], b[i]));
+}
+
+template class NTT_Processor_SIMD<TFHEpp::lvl1param::n>;
+template class NTT_Processor_SIMD<TFHEpp::lvl2param::n>;
+
+NTT_Processor_SIMD<TFHEpp::lvl1param::n> nttsimdlvl1;
+NTT_Processor_SIMD<TFHEpp::lvl2param::n> nttsimdlvl2;
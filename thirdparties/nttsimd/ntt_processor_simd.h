@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <params.hpp>
+
+// Exact negacyclic number theoretic transform over Z_P[X]/(X^N+1) with the
+// 62-bit prime P = 2^62 - 2^16 + 1, dedicated to a fixed power-of-two N.
+//
+// Products of a decomposed polynomial (digits of a few bits) with a key
+// polynomial (32-bit signed coefficients) never exceed P/2 in absolute
+// value, so the integer result is recovered exactly: no floating point
+// error enters the external product. 64-bit torus keys are split into two
+// 32-bit limbs by the caller (see mulntt.hpp).
+//
+// The negacyclic twist is merged into the butterflies (Cooley-Tukey
+// forward with bit-reversed output, Gentleman-Sande inverse with
+// bit-reversed input), so the NTT domain is in bit-reversed order and no
+// permutation pass is needed. Twiddles use Shoup's precomputed quotients;
+// pointwise products take their right operand in Montgomery form, which is
+// how keys are stored. Butterflies run on AVX-512 when the compiler
+// targets it, with scalar code otherwise and for the last three stages.
+// All scratch memory lives on the stack: the processor is thread-safe.
+template <uint32_t Nval>
+class NTT_Processor_SIMD {
+public:
+    static constexpr uint64_t P = 0x3fffffffffff0001ULL;
+    static constexpr int32_t N = Nval;
+
+    // Signed coefficients (digits, key limbs) to the NTT domain.
+    void execute_reverse_int(uint64_t *res, const int32_t *a) const;
+
+    // Same, in the Montgomery form expected by mul/fma. Used for keys.
+    void execute_reverse_int_montgomery(uint64_t *res, const int32_t *a) const;
+
+    // Back to coefficients, lifted to (-P/2, P/2).
+    void execute_direct_int64(int64_t *res, const uint64_t *a) const;
+
+    // Back to coefficients reduced mod 2^32.
+    void execute_direct_torus32(uint32_t *res, const uint64_t *a) const;
+
+    // res = a * b and res += a * b pointwise, b in Montgomery form.
+    static void mul(uint64_t *res, const uint64_t *a, const uint64_t *b);
+    static void fma(uint64_t *res, const uint64_t *a, const uint64_t *b);
+
+private:
+    void forward(uint64_t *a) const;
+    void inverse(uint64_t *a) const;
+};
+
+extern NTT_Processor_SIMD<TFHEpp::lvl1param::n> nttsimdlvl1;
+extern NTT_Processor_SIMD<TFHEpp::lvl2param::n> nttsimdlvl2;
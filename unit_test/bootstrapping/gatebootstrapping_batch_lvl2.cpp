@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <tfhe++.hpp>
+
+#include "c_assert.hpp"
+
+// Gate bootstrapping from lvl2 through lvl0 back to lvl2, one ciphertext at
+// a time and through the batch pipeline (BlindRotatebatch<lvl02param>).
+// Both must decrypt correctly; gates per second are printed.
+constexpr int batch = 8;
+
+int main()
+{
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint32_t> binary(0, 1);
+
+    using bkP = TFHEpp::lvl02param;
+    using iksP = TFHEpp::lvl20param;
+
+    TFHEpp::SecretKey sk;
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<bkP>(sk);
+    ek.emplaceiksk<iksP>(sk);
+
+    auto tlwe = std::make_unique<TFHEpp::TLWEn<typename iksP::domainP, batch>>();
+    auto single = std::make_unique<TFHEpp::TLWEn<typename bkP::targetP, batch>>();
+    auto batched = std::make_unique<TFHEpp::TLWEn<typename bkP::targetP, batch>>();
+    std::array<bool, batch> p;
+    for (int i = 0; i < batch; i++) {
+        p[i] = binary(engine) > 0;
+        (*tlwe)[i] = TFHEpp::tlweSymEncrypt<typename iksP::domainP>(
+            p[i] ? iksP::domainP::mu : -iksP::domainP::mu,
+            sk.key.get<typename iksP::domainP>());
+    }
+
+    auto start = std::chrono::system_clock::now();
+    for (int i = 0; i < batch; i++)
+        TFHEpp::GateBootstrapping<iksP, bkP, bkP::targetP::mu>((*single)[i],
+                                                              (*tlwe)[i], ek);
+    auto end = std::chrono::system_clock::now();
+    const double elapsedsingle =
+        std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::system_clock::now();
+    TFHEpp::GateBootstrappingbatch<iksP, bkP, bkP::targetP::mu, batch>(
+        *batched, *tlwe, ek);
+    end = std::chrono::system_clock::now();
+    const double elapsedbatch =
+        std::chrono::duration<double, std::milli>(end - start).count();
+
+    for (int i = 0; i < batch; i++) {
+        c_assert(p[i] == TFHEpp::tlweSymDecrypt<typename bkP::targetP>(
+                             (*single)[i], sk.key.get<typename bkP::targetP>()));
+        c_assert(p[i] == TFHEpp::tlweSymDecrypt<typename bkP::targetP>(
+                             (*batched)[i], sk.key.get<typename bkP::targetP>()));
+    }
+    std::cout << "Passed" << std::endl;
+
+    std::cout << "single: " << elapsedsingle / batch << "ms/gate, "
+              << 1000 * batch / elapsedsingle << " gates/s" << std::endl;
+    std::cout << "batch of " << batch << ": " << elapsedbatch / batch
+              << "ms/gate, " << 1000 * batch / elapsedbatch << " gates/s"
+              << std::endl;
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+
+#include "c_assert.hpp"
+
+// Gate bootstrapping with the exact NTT bootstrapping key against the FFT
+// one: both must decrypt correctly; latency and throughput are printed.
+template <class iksP, class bkP, bool ntt>
+double run(std::vector<TFHEpp::TLWE<typename iksP::domainP>> &res,
+           const std::vector<TFHEpp::TLWE<typename iksP::domainP>> &tlwe,
+           const TFHEpp::EvalKey &ek)
+{
+    const auto start = std::chrono::system_clock::now();
+    for (size_t test = 0; test < tlwe.size(); test++)
+        if constexpr (ntt)
+            TFHEpp::GateBootstrappingNTT<iksP, bkP, bkP::targetP::mu>(
+                res[test], tlwe[test], ek);
+        else
+            TFHEpp::GateBootstrapping<iksP, bkP, bkP::targetP::mu>(
+                res[test], tlwe[test], ek);
+    const auto end = std::chrono::system_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main()
+{
+    constexpr uint32_t num_test = 100;
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint32_t> binary(0, 1);
+
+    using bkP = TFHEpp::lvl01param;
+    using iksP = TFHEpp::lvl10param;
+
+    TFHEpp::SecretKey sk;
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<bkP>(sk);
+    ek.emplacebkntt<bkP>(sk);
+    ek.emplaceiksk<iksP>(sk);
+    std::vector<TFHEpp::TLWE<typename iksP::domainP>> tlwe(num_test),
+        bootedfft(num_test), bootedntt(num_test);
+    std::array<bool, num_test> p;
+    for (int i = 0; i < num_test; i++) p[i] = binary(engine) > 0;
+    for (int i = 0; i < num_test; i++)
+        tlwe[i] = TFHEpp::tlweSymEncrypt<typename iksP::domainP>(
+            p[i] ? iksP::domainP::mu : -iksP::domainP::mu,
+            sk.key.get<typename iksP::domainP>());
+
+    const double fft = run<iksP, bkP, false>(bootedfft, tlwe, ek);
+    const double ntt = run<iksP, bkP, true>(bootedntt, tlwe, ek);
+
+    for (int i = 0; i < num_test; i++) {
+        c_assert(p[i] == TFHEpp::tlweSymDecrypt<typename bkP::targetP>(
+                             bootedfft[i], sk.key.get<typename bkP::targetP>()));
+        c_assert(p[i] == TFHEpp::tlweSymDecrypt<typename bkP::targetP>(
+                             bootedntt[i], sk.key.get<typename bkP::targetP>()));
+    }
+    std::cout << "Passed" << std::endl;
+
+    std::cout << "FFT: " << fft / num_test << "ms/gate, "
+              << 1000 * num_test / fft << " gates/s" << std::endl;
+    std::cout << "NTT: " << ntt / num_test << "ms/gate, "
+              << 1000 * num_test / ntt << " gates/s" << std::endl;
+}
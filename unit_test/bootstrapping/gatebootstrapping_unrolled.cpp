@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <tfhe++.hpp>
+
+#include "c_assert.hpp"
+
+// Gate bootstrapping from lvl0 to lvl1 with the key of lvl01param and with
+// the key unrolled over pairs of coefficients (lvl01unrolledparam), one
+// ciphertext at a time and in a batch. The step of the unrolled blind
+// rotation is first checked against the sum of one rotated external
+// product per TRGSW: the ciphertexts differ, the monomials being applied
+// after the decomposition rather than before, but their phases must agree
+// up to the noise of the products. Its time is printed against the two
+// steps it replaces. Every bootstrapping must decrypt correctly; the error
+// of the phase, the latency and the key size of both keys are printed.
+
+using namespace std;
+using namespace TFHEpp;
+
+constexpr int num_test = 64;
+constexpr size_t batch = 32;
+
+// Largest distance on the torus between the phases of two TRLWE, in bits.
+template <class P>
+double DistanceBits(const TRLWE<P> &a, const TRLWE<P> &b, const Key<P> &key)
+{
+    const Polynomial<P> pa = trlwePhase<P>(a, key), pb = trlwePhase<P>(b, key);
+    double worst = 0;
+    for (int i = 0; i < P::n; i++) {
+        const auto diff = static_cast<make_signed_t<typename P::T>>(pa[i] - pb[i]);
+        worst = max(worst, abs(static_cast<double>(diff)));
+    }
+    return worst ? log2(worst) : 0;
+}
+
+template <class P>
+void TestStep(const Key<P> &key, default_random_engine &engine, double bound)
+{
+    uniform_int_distribution<typename P::T> coef(
+        0, numeric_limits<typename P::T>::max());
+    uniform_int_distribution<int> rot(0, 2 * P::n - 1);
+    uniform_int_distribution<int> binary(0, 1);
+    constexpr int terms = 3;
+    auto trgswfft = make_unique<array<TRGSWFFT<P>, terms>>();
+    const TRGSWFFT<P> *keys[terms];
+    for (int t = 0; t < terms; t++) {
+        Polynomial<P> plain = {};
+        plain[0] = binary(engine);
+        (*trgswfft)[t] = trgswfftSymEncrypt<P>(plain, key);
+        keys[t] = &(*trgswfft)[t];
+    }
+    double worst = 0;
+    for (int test = 0; test < 16; test++) {
+        // A zero rotation in some tests, which drops its term.
+        int a[terms];
+        for (int t = 0; t < terms; t++)
+            a[t] = test % 4 == t ? 0 : rot(engine);
+        TRLWE<P> acc, res, expected = {}, temp;
+        for (auto &poly : acc)
+            for (auto &c : poly) c = coef(engine);
+        trgswfftExternalProductMulByXaiMinusOneSum<P>(res, acc, a, keys,
+                                                      terms);
+        for (int t = 0; t < terms; t++) {
+            if (a[t] == 0) continue;
+            trgswfftExternalProductMulByXaiMinusOne<P>(temp, acc, a[t],
+                                                       *keys[t]);
+            for (int k = 0; k < P::k + 1; k++)
+                for (int i = 0; i < P::n; i++) expected[k][i] += temp[k][i];
+        }
+        worst = max(worst, DistanceBits<P>(res, expected, key));
+    }
+
+    // One unrolled step against the two steps of a key of one addend,
+    // with keys in cache.
+    constexpr int reps = 2000;
+    TRLWE<P> acc;
+    for (auto &poly : acc)
+        for (auto &c : poly) c = coef(engine);
+    const int a[terms] = {rot(engine), rot(engine), rot(engine)};
+    double best[2] = {numeric_limits<double>::max(),
+                      numeric_limits<double>::max()};
+    for (int run = 0; run < 5; run++) {
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++)
+            for (int t = 0; t < 2; t++)
+                trgswfftExternalProductMulByXaiMinusOne<P>(acc, acc, a[t],
+                                                           *keys[t]);
+        end = chrono::system_clock::now();
+        best[0] = min<double>(
+            best[0],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++)
+            trgswfftExternalProductMulByXaiMinusOneSum<P>(acc, acc, a, keys,
+                                                          terms);
+        end = chrono::system_clock::now();
+        best[1] = min<double>(
+            best[1],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    cout << "n = " << P::n << ": phase of the unrolled step against one "
+         << "product per TRGSW 2^" << worst << " (of 2^"
+         << numeric_limits<typename P::T>::digits << "); two coefficients in "
+         << best[0] / reps / 1000 << " us by two steps, "
+         << best[1] / reps / 1000 << " us by one unrolled step" << endl;
+    c_assert(worst < bound);
+}
+
+template <class bkP>
+void Test(const SecretKey &sk, default_random_engine &engine, const char *name)
+{
+    using P = typename bkP::targetP;
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    const auto start = chrono::system_clock::now();
+    auto bkfft = unique_ptr<BootstrappingKeyFFT<bkP>>(
+        new (align_val_t(64)) BootstrappingKeyFFT<bkP>());
+    bkfftgen<bkP>(*bkfft, sk);
+    const auto end = chrono::system_clock::now();
+    const Polynomial<P> testvector = mupolygen<P, P::mu>();
+
+    vector<TLWE<typename bkP::domainP>> tlwe(num_test);
+    vector<TLWE<P>> res(num_test), resbatch(batch);
+    vector<bool> p(num_test);
+    for (int i = 0; i < num_test; i++) {
+        p[i] = binary(engine) > 0;
+        tlwe[i] = tlweSymEncrypt<typename bkP::domainP>(
+            p[i] ? bkP::domainP::mu : -bkP::domainP::mu,
+            sk.key.get<typename bkP::domainP>());
+    }
+
+    double best = numeric_limits<double>::max();
+    for (int run = 0; run < 3; run++) {
+        const auto start = chrono::system_clock::now();
+        for (int i = 0; i < num_test; i++)
+            GateBootstrappingTLWE2TLWEFFT<bkP>(res[i], tlwe[i], *bkfft,
+                                               testvector);
+        const auto end = chrono::system_clock::now();
+        best = min<double>(
+            best, chrono::duration<double, milli>(end - start).count());
+    }
+    double bestbatch = numeric_limits<double>::max();
+    for (int run = 0; run < 3; run++) {
+        const auto start = chrono::system_clock::now();
+        GateBootstrappingTLWE2TLWEFFTbatch<bkP>(resbatch.data(), tlwe.data(),
+                                                *bkfft, testvector, batch);
+        const auto end = chrono::system_clock::now();
+        bestbatch = min<double>(
+            bestbatch, chrono::duration<double, milli>(end - start).count());
+    }
+
+    double noise = 0;
+    for (int i = 0; i < num_test; i++) {
+        c_assert(p[i] == tlweSymDecrypt<P>(res[i], sk.key.get<P>()));
+        const typename P::T phase = tlweSymPhase<P>(res[i], sk.key.get<P>());
+        const auto diff = static_cast<make_signed_t<typename P::T>>(
+            phase - (p[i] ? P::mu : -P::mu));
+        noise = max(noise, abs(static_cast<double>(diff)));
+    }
+    for (size_t j = 0; j < batch; j++)
+        c_assert(p[j] == tlweSymDecrypt<P>(resbatch[j], sk.key.get<P>()));
+
+    cout << name << ": " << bkP::domainP::n / bkP::Addends << " steps, key "
+         << sizeof(BootstrappingKeyFFT<bkP>) / (1024 * 1024) << " MiB ("
+         << chrono::duration<double>(end - start).count() << " s to generate), "
+         << best / num_test << " ms/bootstrap, " << bestbatch / batch
+         << " ms/bootstrap in a batch of " << batch << ", phase error 2^" << log2(noise)
+         << " (of 2^" << numeric_limits<typename P::T>::digits << ")" << endl;
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    SecretKey sk;
+#ifdef USE_FPGA
+    // The FPGA transform of lvl1 is single precision.
+    TestStep<lvl1param>(sk.key.lvl1, engine, 28);
+#else
+    TestStep<lvl1param>(sk.key.lvl1, engine, 24);
+#endif
+    TestStep<lvl2param>(sk.key.lvl2, engine, 40);
+    Test<lvl01param>(sk, engine, "lvl01param");
+    Test<lvl01unrolledparam>(sk, engine, "lvl01unrolledparam");
+    cout << "Passed" << endl;
+}
@@ -0,0 +1,60 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+#include <string>
+#include <sstream>
+
+// The key switching stage of the batch gates on its own: IdentityKeySwitch
+// once per lane against IdentityKeySwitchbatch, which streams the lvl10 key
+// once per tile. The results must be identical.
+
+using namespace std;
+using namespace TFHEpp;
+
+int main(int argc, char* argv[])
+{
+    size_t batch = otherparam::batch;
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> batch;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+    const KeySwitchingKey<lvl10param> &ksk = ek.getiksk<lvl10param>();
+
+    vector<uint8_t> p(batch);
+    for (size_t j = 0; j < batch; j++) p[j] = binary(engine);
+    vector<TLWE<lvl1param>> c = bootsSymEncrypt(p, *sk);
+    vector<TLWE<lvl0param>> single(batch), batched(batch);
+
+    chrono::system_clock::time_point start, end;
+    start = chrono::system_clock::now();
+    for (size_t j = 0; j < batch; j++)
+        IdentityKeySwitch<lvl10param>(single[j], c[j], ksk);
+    end = chrono::system_clock::now();
+    double singletime =
+        chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+    start = chrono::system_clock::now();
+    IdentityKeySwitchbatch<lvl10param>(batched.data(), c.data(), batch, ksk);
+    end = chrono::system_clock::now();
+    double batchtime =
+        chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+    for (size_t j = 0; j < batch; j++) c_assert(batched[j] == single[j]);
+    vector<uint8_t> pres = bootsSymDecrypt<lvl0param>(batched, *sk);
+    for (size_t j = 0; j < batch; j++) c_assert(pres[j] == p[j]);
+
+    cout << "batch " << batch << ": " << singletime / batch
+         << " us/lane one at a time, " << batchtime / batch
+         << " us/lane batched, speedup " << singletime / batchtime << endl;
+    cout << "Passed" << endl;
+}
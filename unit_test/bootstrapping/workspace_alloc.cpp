@@ -0,0 +1,92 @@
+#include "c_assert.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <tfhe++.hpp>
+#include <string>
+#include <sstream>
+
+// Allocator calls of HomNANDbatch: the first call at a batch size sizes
+// the workspaces, later ones must not allocate at all, neither workspace
+// blocks nor operator new. The argument is the batch size.
+
+using namespace std;
+using namespace TFHEpp;
+
+static atomic<size_t> news{0};
+
+void *operator new(size_t size)
+{
+    news.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct Count {
+    size_t blocks, news;
+};
+
+Count Now() { return {WorkspaceAllocations(), news.load()}; }
+
+int main(int argc, char* argv[])
+{
+    size_t batch = 64;
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> batch;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    vector<uint8_t> pa(batch), pb(batch);
+    for (size_t j = 0; j < batch; j++) pa[j] = binary(engine);
+    for (size_t j = 0; j < batch; j++) pb[j] = binary(engine);
+    vector<TLWE<lvl1param>> ca = bootsSymEncrypt(pa, *sk);
+    vector<TLWE<lvl1param>> cb = bootsSymEncrypt(pb, *sk);
+    vector<TLWE<lvl1param>> cres(batch);
+
+    const Count before = Now();
+    HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+    const Count first = Now();
+    cout << "batch " << batch << ", first call: "
+         << first.blocks - before.blocks << " workspace blocks, "
+         << WorkspaceBytes() / double(1 << 20) << " MiB, "
+         << first.news - before.news << " operator new" << endl;
+
+    constexpr int calls = 4;
+    chrono::system_clock::time_point start, end;
+    start = chrono::system_clock::now();
+    for (int i = 0; i < calls; i++)
+        HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+    end = chrono::system_clock::now();
+    const Count steady = Now();
+    const double elapsed =
+        chrono::duration_cast<chrono::microseconds>(end - start).count();
+    cout << "next " << calls << " calls: " << steady.blocks - first.blocks
+         << " workspace blocks, " << steady.news - first.news
+         << " operator new, " << calls * batch / elapsed * 1e6 << " gates/s"
+         << endl;
+    c_assert(steady.blocks == first.blocks);
+    c_assert(steady.news == first.news);
+
+    vector<uint8_t> pres = bootsSymDecrypt(cres, *sk);
+    for (size_t j = 0; j < batch; j++) c_assert(pres[j] == !(pa[j] & pb[j]));
+
+    // A smaller batch fits in what is there already.
+    const Count larger = Now();
+    HomNANDbatch(cres.data(), ca.data(), cb.data(), (batch + 1) / 2, ek);
+    c_assert(Now().blocks == larger.blocks && Now().news == larger.news);
+    cout << "Passed" << endl;
+}
@@ -0,0 +1,202 @@
+#include <tfhe++.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+using namespace TFHEpp;
+using namespace std;
+
+// EvalCircuit on a ripple carry adder, a Kogge-Stone adder and a tree
+// comparator of bits-bit operands, each repeated copies times side by side
+// (the two arguments, 16 and 1 by default), and on a full adder read from
+// BLIF. Prints the schedule and the throughput of every level.
+
+using Wire = Circuit::Wire;
+using Word = vector<Wire>;
+
+Word Inputs(Circuit &c, size_t bits)
+{
+    Word w(bits);
+    for (Wire &x : w) x = c.input();
+    return w;
+}
+
+void RippleAdder(Circuit &c, size_t bits)
+{
+    const Word a = Inputs(c, bits), b = Inputs(c, bits);
+    Wire carry = c.constant(false);
+    for (size_t i = 0; i < bits; i++) {
+        const Wire p = c.gate(GateOp::XOR, a[i], b[i]);
+        c.output(c.gate(GateOp::XOR, p, carry));
+        carry = c.gate(GateOp::OR, c.gate(GateOp::AND, a[i], b[i]),
+                       c.gate(GateOp::AND, p, carry));
+    }
+    c.output(carry);
+}
+
+void KoggeStoneAdder(Circuit &c, size_t bits)
+{
+    const Word a = Inputs(c, bits), b = Inputs(c, bits);
+    Word g(bits), p(bits), x(bits);
+    for (size_t i = 0; i < bits; i++) {
+        g[i] = c.gate(GateOp::AND, a[i], b[i]);
+        p[i] = x[i] = c.gate(GateOp::XOR, a[i], b[i]);
+    }
+    for (size_t d = 1; d < bits; d *= 2) {
+        Word ng = g, np = p;
+        for (size_t i = d; i < bits; i++) {
+            ng[i] = c.gate(GateOp::OR, g[i], c.gate(GateOp::AND, p[i], g[i - d]));
+            if (i >= 2 * d) np[i] = c.gate(GateOp::AND, p[i], p[i - d]);
+        }
+        g = ng;
+        p = np;
+    }
+    c.output(x[0]);
+    for (size_t i = 1; i < bits; i++)
+        c.output(c.gate(GateOp::XOR, x[i], g[i - 1]));
+    c.output(g[bits - 1]);
+}
+
+// a < b, unsigned, from the most significant half down.
+void Comparator(Circuit &c, size_t bits)
+{
+    const Word a = Inputs(c, bits), b = Inputs(c, bits);
+    Word lt(bits), eq(bits);
+    for (size_t i = 0; i < bits; i++) {
+        lt[i] = c.gate(GateOp::ANDNY, a[i], b[i]);
+        eq[i] = c.gate(GateOp::XNOR, a[i], b[i]);
+    }
+    while (lt.size() > 1) {
+        Word nlt, neq;
+        for (size_t i = 0; i + 1 < lt.size(); i += 2) {
+            nlt.push_back(c.gate(GateOp::OR, lt[i + 1],
+                                 c.gate(GateOp::AND, eq[i + 1], lt[i])));
+            neq.push_back(c.gate(GateOp::AND, eq[i + 1], eq[i]));
+        }
+        if (lt.size() % 2) {
+            nlt.push_back(lt.back());
+            neq.push_back(eq.back());
+        }
+        lt = nlt;
+        eq = neq;
+    }
+    c.output(lt[0]);
+}
+
+const char *fulladder = R"(# a + b + cin
+.model fulladder
+.inputs a b cin
+.outputs s cout
+.names a b p
+10 1
+01 1
+.subckt $_XOR_ A=p B=cin Y=s
+.names a b g
+11 1
+.gate $_AND_ A=p B=cin Y=t
+.subckt $_MUX_ A=g B=cin S=p Y=cout
+.end
+)";
+
+void Run(const string &name, const Circuit &circuit, const SecretKey &sk,
+         const EvalKey &ek, default_random_engine &engine)
+{
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    vector<uint8_t> p(circuit.inputs().size());
+    for (uint8_t &x : p) x = binary(engine);
+    vector<TLWE<lvl1param>> in = bootsSymEncrypt(p, sk), out;
+
+    const CircuitSchedule schedule(circuit);
+    vector<CircuitLevelStats> stats;
+    chrono::system_clock::time_point start, end;
+    start = chrono::system_clock::now();
+    EvalCircuit(out, circuit, schedule, in, ek, &stats);
+    end = chrono::system_clock::now();
+    const double elapsed =
+        chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+    const vector<uint8_t> expected = circuit.evaluate(p);
+    const vector<uint8_t> pres = bootsSymDecrypt(out, sk);
+    for (size_t i = 0; i < expected.size(); i++)
+        c_assert(pres[i] == expected[i]);
+
+    cout << name << ": " << circuit.bootstraps() << " gates, depth "
+         << schedule.depth() << ", widest level " << schedule.width << ", "
+         << schedule.slots << " buffers for " << circuit.nodes().size()
+         << " nodes" << endl;
+    cout << setw(8) << "level" << setw(8) << "gates" << setw(12) << "ms"
+         << setw(12) << "gates/s" << endl;
+    for (size_t l = 1; l < stats.size(); l++)
+        cout << setw(8) << l << setw(8) << stats[l].gates << setw(12)
+             << stats[l].microseconds / 1000 << setw(12)
+             << stats[l].gates / stats[l].microseconds * 1e6 << endl;
+    cout << "total " << elapsed / 1000 << " ms, "
+         << circuit.bootstraps() / elapsed * 1e6 << " gates/s" << endl
+         << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t bits = 16, copies = 1;
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> bits;
+    }
+    if (argc > 2) {
+        std::stringstream str_stream(argv[2]);
+        str_stream >> copies;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+
+    SecretKey *sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    Circuit blif;
+    istringstream blifstream(fulladder);
+    c_assert(ReadBLIF(blif, blifstream));
+    // The unused t is dropped and the MUX is three gates.
+    c_assert(blif.bootstraps() == 6);
+    for (uint8_t m = 0; m < 8; m++) {
+        const vector<uint8_t> r =
+            blif.evaluate({uint8_t(m & 1), uint8_t(m >> 1 & 1), uint8_t(m >> 2)});
+        const int sum = (m & 1) + (m >> 1 & 1) + (m >> 2);
+        c_assert(r[0] == (sum & 1) && r[1] == (sum >> 1));
+    }
+    Run("BLIF full adder", blif, *sk, ek, engine);
+
+    // One gate at a time, for reference.
+    {
+        vector<uint8_t> p = {0, 1};
+        vector<TLWE<lvl1param>> c = bootsSymEncrypt(p, *sk);
+        constexpr int trials = 8;
+        HomAND(c[0], c[0], c[1], ek);
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int i = 0; i < trials; i++) HomAND(c[0], c[0], c[1], ek);
+        end = chrono::system_clock::now();
+        const double elapsed =
+            chrono::duration_cast<chrono::microseconds>(end - start).count();
+        cout << "one gate at a time: " << trials / elapsed * 1e6 << " gates/s"
+             << endl
+             << endl;
+    }
+
+    const vector<pair<string, void (*)(Circuit &, size_t)>> circuits = {
+        {"ripple carry adder", RippleAdder},
+        {"Kogge-Stone adder", KoggeStoneAdder},
+        {"comparator", Comparator}};
+    for (const auto &[name, build] : circuits) {
+        Circuit circuit;
+        for (size_t i = 0; i < copies; i++) build(circuit, bits);
+        Run(to_string(copies) + " x " + to_string(bits) + "-bit " + name,
+            circuit, *sk, ek, engine);
+    }
+    cout << "Passed" << endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <tfhe++.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+using namespace TFHEpp;
+using namespace std;
+
+// OptimizeCircuit on circuits where each rewrite applies, on random
+// circuits checked over every input, and on a ripple carry adder with a
+// constant carry in, which is also evaluated encrypted.
+
+using Wire = Circuit::Wire;
+
+void Print(const string &name, const CircuitOptimizeReport &r)
+{
+    cout << name << ": " << r.before << " -> " << r.after
+         << " bootstraps (folded " << r.folded << ", absorbed " << r.absorbed
+         << ", merged " << r.merged << ", shared " << r.shared << ", removed "
+         << r.removed << ")" << endl;
+}
+
+void CheckEquivalent(const Circuit &a, const Circuit &b)
+{
+    const size_t n = a.inputs().size();
+    c_assert(b.inputs().size() == n &&
+             b.outputs().size() == a.outputs().size());
+    for (size_t m = 0; m < (size_t{1} << n); m++) {
+        vector<uint8_t> in(n);
+        for (size_t i = 0; i < n; i++) in[i] = (m >> i) & 1;
+        c_assert(a.evaluate(in) == b.evaluate(in));
+    }
+}
+
+Circuit RandomCircuit(default_random_engine &engine, size_t inputs,
+                      size_t nodes, size_t outputs)
+{
+    Circuit c;
+    for (size_t i = 0; i < inputs; i++) c.input();
+    uniform_int_distribution<int> kind(0, 19), binary(0, 1);
+    uniform_int_distribution<int> op(0, static_cast<int>(GateOp::ORYN));
+    for (size_t i = 0; i < nodes; i++) {
+        // Mostly recent wires, so that the circuit gets deep.
+        const size_t size = c.nodes().size();
+        uniform_int_distribution<size_t> recent(size > 8 ? size - 8 : 0,
+                                                size - 1);
+        const int k = kind(engine);
+        if (k == 0)
+            c.constant(binary(engine));
+        else if (k < 5)
+            c.NOT(recent(engine));
+        else
+            c.gate(static_cast<GateOp>(op(engine)), recent(engine),
+                   recent(engine));
+    }
+    uniform_int_distribution<size_t> any(0, c.nodes().size() - 1);
+    for (size_t i = 0; i < outputs; i++) c.output(any(engine));
+    return c;
+}
+
+Circuit RippleAdder(size_t bits)
+{
+    Circuit c;
+    vector<Wire> a(bits), b(bits);
+    for (Wire &x : a) x = c.input();
+    for (Wire &x : b) x = c.input();
+    Wire carry = c.constant(false);
+    for (size_t i = 0; i < bits; i++) {
+        const Wire p = c.gate(GateOp::XOR, a[i], b[i]);
+        c.output(c.gate(GateOp::XOR, p, carry));
+        carry = c.gate(GateOp::OR, c.gate(GateOp::AND, a[i], b[i]),
+                       c.gate(GateOp::AND, p, carry));
+    }
+    c.output(carry);
+    return c;
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    CircuitOptimizeReport r;
+
+    {
+        Circuit c;
+        const Wire a = c.input(), b = c.input();
+        // a & 1 is a.
+        c.output(c.gate(GateOp::AND, a, c.constant(true)));
+        // !a ^ b is XNOR(a, b), and the XNOR below is the same gate.
+        c.output(c.gate(GateOp::XOR, c.NOT(a), b));
+        c.output(c.gate(GateOp::XNOR, a, b));
+        // (a & b) | a is a, and a & (a ^ b) is ANDYN(a, b); the inner AND
+        // and XOR are left unused.
+        c.output(c.gate(GateOp::OR, c.gate(GateOp::AND, a, b), a));
+        c.output(c.gate(GateOp::AND, c.gate(GateOp::XOR, a, b), a));
+        // Nothing reads this one.
+        c.gate(GateOp::NAND, a, b);
+        const Circuit o = OptimizeCircuit(c, &r);
+        Print("rewrites", r);
+        CheckEquivalent(c, o);
+        c_assert(r.before == 8 && r.after == 2);
+        c_assert(r.folded == 2 && r.absorbed == 1 && r.merged == 1 &&
+                 r.shared == 1 && r.removed == 3);
+    }
+
+    size_t before = 0, after = 0;
+    for (int trial = 0; trial < 200; trial++) {
+        const Circuit c = RandomCircuit(engine, 6, 200, 8);
+        const Circuit o = OptimizeCircuit(c, &r);
+        c_assert(r.after == o.bootstraps() && r.after <= r.before);
+        CheckEquivalent(c, o);
+        // Optimising again finds nothing left to remove.
+        c_assert(OptimizeCircuit(o).bootstraps() == o.bootstraps());
+        before += r.before;
+        after += r.after;
+    }
+    cout << "200 random circuits: " << before << " -> " << after
+         << " bootstraps" << endl;
+
+    const Circuit adder = RippleAdder(16);
+    const Circuit o = OptimizeCircuit(adder, &r);
+    Print("16-bit ripple carry adder", r);
+    // The sum, the carry AND and the carry OR of bit 0 go.
+    c_assert(r.after == r.before - 3);
+
+    SecretKey *sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    vector<uint8_t> p(o.inputs().size());
+    for (uint8_t &x : p) x = binary(engine);
+    vector<TLWE<lvl1param>> in = bootsSymEncrypt(p, *sk), out;
+    EvalCircuit(out, o, in, ek);
+    const vector<uint8_t> pres = bootsSymDecrypt(out, *sk);
+    c_assert(pres == adder.evaluate(p));
+    cout << "Passed" << endl;
+    return 0;
+}
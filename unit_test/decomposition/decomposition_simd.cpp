@@ -0,0 +1,104 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <tfhe++.hpp>
+
+// DecompositionDigits against DecompositionDigitsScalar for every digit
+// type, Decomposition and Decompositionbatch against the digits of each
+// lane, on lvl1 and lvl2. Then the time of one polynomial both ways.
+
+using namespace std;
+using namespace TFHEpp;
+
+constexpr size_t batch = 5;
+
+template <class P, class Digit>
+double Time(void (*decompose)(Digit *, size_t, const typename P::T *),
+            vector<Digit> &digits, Polynomial<P> &poly)
+{
+    constexpr int reps = 20000;
+    double best = numeric_limits<double>::max();
+    for (int run = 0; run < 5; run++) {
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++) {
+            decompose(digits.data(), P::n, poly.data());
+            poly[r % P::n] += static_cast<typename P::T>(digits[r % P::n]);
+        }
+        end = chrono::system_clock::now();
+        best = min<double>(
+            best, chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    return best / reps;
+}
+
+template <class P, class Digit>
+void Test(default_random_engine &engine, const char *name)
+{
+    uniform_int_distribution<typename P::T> coef(
+        0, numeric_limits<typename P::T>::max());
+    vector<Digit> digits(P::l * P::n), expected(P::l * P::n);
+    for (int t = 0; t < 100; t++) {
+        Polynomial<P> poly;
+        for (auto &c : poly) c = coef(engine);
+        // Both ends of the range and the rounding boundaries.
+        poly[0] = 0;
+        poly[1] = numeric_limits<typename P::T>::max();
+        poly[2] = typename P::T(1) << (numeric_limits<typename P::T>::digits -
+                                       P::l * P::Bgbit - 1);
+        DecompositionDigits<P, Digit>(digits.data(), P::n, poly.data());
+        DecompositionDigitsScalar<P, Digit>(expected.data(), P::n,
+                                            poly.data());
+        c_assert(digits == expected);
+        for (const Digit d : digits)
+            c_assert(static_cast<make_signed_t<typename P::T>>(d) >=
+                         -static_cast<int>(P::Bg / 2) &&
+                     static_cast<make_signed_t<typename P::T>>(d) <
+                         static_cast<int>(P::Bg / 2));
+    }
+
+    Polynomial<P> poly;
+    for (auto &c : poly) c = coef(engine);
+    const double scalar =
+        Time<P, Digit>(DecompositionDigitsScalar<P, Digit>, expected, poly);
+    const double simd = Time<P, Digit>(DecompositionDigits<P, Digit>, digits, poly);
+    cout << "n = " << P::n << ", " << name << " digits: " << scalar
+         << " ns scalar, " << simd << " ns vector, " << scalar / simd << "x"
+         << endl;
+}
+
+template <class P>
+void TestBatch(default_random_engine &engine)
+{
+    uniform_int_distribution<typename P::T> coef(
+        0, numeric_limits<typename P::T>::max());
+    vector<Polynomial<P>> poly(batch), decpoly(P::l * batch);
+    for (auto &p : poly)
+        for (auto &c : p) c = coef(engine);
+    Decompositionbatch<P>(decpoly.data(), poly.data(), batch);
+    for (size_t j = 0; j < batch; j++) {
+        DecomposedPolynomial<P> single, expected;
+        Decomposition<P>(single, poly[j]);
+        DecompositionDigitsScalar<P>(expected[0].data(), P::n, poly[j].data());
+        c_assert(single == expected);
+        for (int ii = 0; ii < P::l; ii++)
+            c_assert(decpoly[ii * batch + j] == expected[ii]);
+    }
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    Test<lvl1param, lvl1param::T>(engine, "torus");
+    Test<lvl1param, int32_t>(engine, "int32");
+    Test<lvl1param, double>(engine, "double");
+    Test<lvl2param, lvl2param::T>(engine, "torus");
+    Test<lvl2param, int32_t>(engine, "int32");
+    Test<lvl2param, double>(engine, "double");
+    TestBatch<lvl1param>(engine);
+    TestBatch<lvl2param>(engine);
+    cout << "Passed" << endl;
+}
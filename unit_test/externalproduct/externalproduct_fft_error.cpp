@@ -0,0 +1,131 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+
+// The FFT external product, whose digits go to an offload FFT engine in one
+// batch call, against the same product with one transform per digit: the
+// results must be identical. Both are then measured against the exact NTT product,
+// single and batch, and the time of the single product is printed.
+
+using namespace std;
+using namespace TFHEpp;
+
+constexpr size_t batch = 4;
+
+// One TwistIFFT per digit, as the product used to transform them.
+template <class P>
+void PerDigit(TRLWE<P> &res, const TRLWE<P> &trlwe, const TRGSWFFT<P> &trgswfft)
+{
+    constexpr int digits = (P::k + 1) * P::l;
+    vector<PolynomialInFD<P>> decpolyfft(digits);
+    for (int k = 0; k < P::k + 1; k++) {
+        DecomposedPolynomial<P> decpoly;
+        Decomposition<P>(decpoly, trlwe[k]);
+        for (int i = 0; i < P::l; i++)
+            TwistIFFT<P>(decpolyfft[i + k * P::l], decpoly[i]);
+    }
+    TRLWEInFD<P> restrlwefft;
+    MACInFD<P::n, P::k + 1>(
+        [&](int m) { return restrlwefft[m].data(); },
+        [&](int d) { return decpolyfft[d].data(); },
+        [&](int d, int m) { return trgswfft[d][m].data(); }, digits);
+    for (int k = 0; k < P::k + 1; k++) TwistFFT<P>(res[k], restrlwefft[k]);
+}
+
+// Largest distance on the torus from the exact product, in bits.
+template <class P>
+double ErrorBits(const TRLWE<P> &res, const TRLWE<P> &exact)
+{
+    double worst = 0;
+    for (int k = 0; k < P::k + 1; k++)
+        for (int i = 0; i < P::n; i++) {
+            const auto diff = static_cast<make_signed_t<typename P::T>>(
+                res[k][i] - exact[k][i]);
+            worst = max(worst, abs(static_cast<double>(diff)));
+        }
+    return worst ? log2(worst) : 0;
+}
+
+template <class P>
+void Test(const Key<P> &key, default_random_engine &engine, double bound)
+{
+    uniform_int_distribution<typename P::T> torus(
+        0, numeric_limits<typename P::T>::max());
+    uniform_int_distribution<int> binary(0, 1);
+    Polynomial<P> plain = {};
+    plain[0] = binary(engine);
+    const TRGSW<P> trgsw = trgswSymEncrypt<P>(plain, key);
+    auto trgswfft = make_unique<TRGSWFFT<P>>(ApplyFFT2trgsw<P>(trgsw));
+    auto trgswntt = make_unique<TRGSWNTT<P>>();
+    ApplyNTT2trgsw<P>(*trgswntt, trgsw);
+
+    TRLWEBatch<P> inbuf(batch), outbuf(batch);
+    const TRLWEPlanes<P> in = inbuf.planes(), out = outbuf.planes();
+    double single = 0, batched = 0;
+    for (size_t j = 0; j < batch; j++) {
+        TRLWE<P> c, res, reference, exact;
+        for (auto &poly : c)
+            for (auto &v : poly) v = torus(engine);
+        for (int k = 0; k < P::k + 1; k++) in[k][j] = c[k];
+        trgswfftExternalProduct<P>(res, c, *trgswfft);
+        PerDigit<P>(reference, c, *trgswfft);
+        c_assert(res == reference);
+        trgswnttExternalProduct<P>(exact, c, *trgswntt);
+        single = max(single, ErrorBits<P>(res, exact));
+    }
+    trgswfftExternalProductbatch<P>(out, in, *trgswfft, batch);
+    for (size_t j = 0; j < batch; j++) {
+        TRLWE<P> c, res, exact;
+        for (int k = 0; k < P::k + 1; k++) {
+            c[k] = in[k][j];
+            res[k] = out[k][j];
+        }
+        trgswnttExternalProduct<P>(exact, c, *trgswntt);
+        batched = max(batched, ErrorBits<P>(res, exact));
+    }
+
+    constexpr int reps = 200;
+    TRLWE<P> c;
+    for (int k = 0; k < P::k + 1; k++) c[k] = in[k][0];
+    double best[2] = {numeric_limits<double>::max(),
+                      numeric_limits<double>::max()};
+    for (int run = 0; run < 3; run++) {
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++) PerDigit<P>(c, c, *trgswfft);
+        end = chrono::system_clock::now();
+        best[0] = min<double>(
+            best[0],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++) trgswfftExternalProduct<P>(c, c, *trgswfft);
+        end = chrono::system_clock::now();
+        best[1] = min<double>(
+            best[1],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    cout << "n = " << P::n << ": error against the exact product 2^" << single
+         << " single, 2^" << batched << " batch (of 2^"
+         << numeric_limits<typename P::T>::digits << "); "
+         << best[0] / reps / 1000 << " us with a transform per digit, "
+         << best[1] / reps / 1000 << " us with trgswfftExternalProduct" << endl;
+    c_assert(single < bound && batched < bound);
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    lweKey key;
+#ifdef USE_FPGA
+    // The FPGA transform of lvl1 is single precision.
+    Test<lvl1param>(key.lvl1, engine, 24);
+#else
+    Test<lvl1param>(key.lvl1, engine, 8);
+#endif
+    Test<lvl2param>(key.lvl2, engine, 40);
+    cout << endl << "Passed" << endl;
+}
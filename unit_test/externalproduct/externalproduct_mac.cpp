@@ -0,0 +1,138 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <tfhe++.hpp>
+
+// MACInFD against MulInFD followed by FMAInFD on the shapes of the lvl1
+// and lvl2 external products: the results must be identical. Then the
+// FLOP/s of both against the FMA peak of one core, measured with a loop
+// of independent register FMAs.
+
+using namespace std;
+using namespace TFHEpp;
+
+#if defined(__AVX512F__)
+typedef double Vec __attribute__((vector_size(64)));
+#elif defined(__AVX__)
+typedef double Vec __attribute__((vector_size(32)));
+#else
+typedef double Vec __attribute__((vector_size(16)));
+#endif
+
+double PeakFlops()
+{
+    constexpr int chains = 12;
+    constexpr int lanes = sizeof(Vec) / sizeof(double);
+    constexpr long reps = 1 << 22;
+    Vec acc[chains], x, y;
+    for (int l = 0; l < lanes; l++) {
+        x[l] = 0.999999;
+        y[l] = 1e-9;
+    }
+    for (int c = 0; c < chains; c++) acc[c] = x + c;
+    chrono::system_clock::time_point start, end;
+    start = chrono::system_clock::now();
+    for (long r = 0; r < reps; r++)
+        for (int c = 0; c < chains; c++) acc[c] = acc[c] * x + y;
+    end = chrono::system_clock::now();
+    double sum = 0;
+    for (int c = 0; c < chains; c++)
+        for (int l = 0; l < lanes; l++) sum += acc[c][l];
+    c_assert(sum > 0);
+    const double elapsed =
+        chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    return 2.0 * chains * lanes * reps / elapsed * 1e9;
+}
+
+template <class P>
+void Test(default_random_engine &engine, double peak)
+{
+    constexpr int K = P::k + 1;
+    constexpr int digits = K * P::l;
+    // Digit spectra are bounded by N Bg / 2, key spectra by N.
+    uniform_real_distribution<double> digit(-double(P::n) * P::Bg / 2,
+                                            double(P::n) * P::Bg / 2);
+    uniform_real_distribution<double> key(-double(P::n), double(P::n));
+    vector<PolynomialInFD<P>> a(digits);
+    TRGSWFFT<P> b;
+    for (auto &poly : a)
+        for (double &c : poly) c = digit(engine);
+    for (auto &row : b)
+        for (auto &poly : row)
+            for (double &c : poly) c = key(engine);
+
+    TRLWEInFD<P> expected, res;
+    const auto reference = [&]() {
+        for (int m = 0; m < K; m++)
+            MulInFD<P::n>(expected[m], a[0], b[0][m]);
+        for (int d = 1; d < digits; d++)
+            for (int m = 0; m < K; m++)
+                FMAInFD<P::n>(expected[m], a[d], b[d][m]);
+    };
+    const auto fused = [&]() {
+        MACInFD<P::n, K>([&](int m) { return res[m].data(); },
+                         [&](int d) { return a[d].data(); },
+                         [&](int d, int m) { return b[d][m].data(); }, digits);
+    };
+    reference();
+    fused();
+    c_assert(res == expected);
+
+    // The same points split into blocks, as the batch product calls it.
+    TRLWEInFD<P> blocked;
+    for (int begin = 0; begin < P::n / 2; begin += 64)
+        MACInFD<P::n, K>([&](int m) { return blocked[m].data(); },
+                         [&](int d) { return a[d].data(); },
+                         [&](int d, int m) { return b[d][m].data(); }, digits,
+                         begin, begin + 64);
+    c_assert(blocked == expected);
+
+    constexpr int reps = 2000;
+    const double flops = 8.0 * (P::n / 2) * digits * K;
+    double best[2] = {numeric_limits<double>::max(),
+                      numeric_limits<double>::max()};
+    for (int run = 0; run < 5; run++) {
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++) {
+            reference();
+            a[r % digits][r % P::n] += expected[r % K][r % P::n] * 1e-300;
+        }
+        end = chrono::system_clock::now();
+        best[0] = min<double>(
+            best[0],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++) {
+            fused();
+            a[r % digits][r % P::n] += res[r % K][r % P::n] * 1e-300;
+        }
+        end = chrono::system_clock::now();
+        best[1] = min<double>(
+            best[1],
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    const char *names[2] = {"MulInFD + FMAInFD", "MACInFD"};
+    cout << "n = " << P::n << ", " << digits << " digits x " << K
+         << " outputs, key " << sizeof(b) / 1024 << " KiB:" << endl;
+    for (int v = 0; v < 2; v++) {
+        const double gflops = flops * reps / best[v];
+        cout << "  " << names[v] << ": " << best[v] / reps / 1000 << " us, "
+             << gflops << " GFLOP/s, " << gflops / peak * 100 << "% of peak"
+             << endl;
+    }
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    const double peak = PeakFlops() / 1e9;
+    cout << "peak " << peak << " GFLOP/s (" << sizeof(Vec) / sizeof(double)
+         << "-wide FMA)" << endl;
+    Test<lvl1param>(engine, peak);
+    Test<lvl2param>(engine, peak);
+    cout << "Passed" << endl;
+}
@@ -0,0 +1,93 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+
+using namespace std;
+using namespace TFHEpp;
+
+// The NTT external product is exact: it must match, bit for bit, the naive
+// negacyclic products of the decomposed digits with the TRGSW rows.
+template <class P>
+void test_exact(default_random_engine &engine)
+{
+    uniform_int_distribution<typename P::T> torus(
+        0, numeric_limits<typename P::T>::max());
+    TRLWE<P> c;
+    for (auto &poly : c)
+        for (auto &v : poly) v = torus(engine);
+    auto trgsw = make_unique<TRGSW<P>>();
+    for (auto &row : *trgsw)
+        for (auto &poly : row)
+            for (auto &v : poly) v = torus(engine);
+
+    TRLWE<P> ref = {};
+    for (int k = 0; k < P::k + 1; k++) {
+        DecomposedPolynomial<P> decpoly;
+        Decomposition<P>(decpoly, c[k]);
+        for (int i = 0; i < P::l; i++)
+            for (int m = 0; m < P::k + 1; m++) {
+                Polynomial<P> temp;
+                PolyMulNaive<P>(temp, decpoly[i], (*trgsw)[i + k * P::l][m]);
+                for (int n = 0; n < P::n; n++) ref[m][n] += temp[n];
+            }
+    }
+
+    auto trgswntt = make_unique<TRGSWNTT<P>>();
+    ApplyNTT2trgsw<P>(*trgswntt, *trgsw);
+    TRLWE<P> res;
+    trgswnttExternalProduct<P>(res, c, *trgswntt);
+    c_assert(res == ref);
+}
+
+template <class P>
+void test_decrypt(default_random_engine &engine, const Key<P> &key,
+                  const int num_test)
+{
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    auto trgswntt = make_unique<TRGSWNTT<P>>();
+    const Polynomial<P> plainpoly = {static_cast<typename P::T>(1)};
+    ApplyNTT2trgsw<P>(*trgswntt, trgswSymEncrypt<P>(plainpoly, key));
+
+    chrono::system_clock::time_point start, end;
+    double elapsed = 0;
+    for (int test = 0; test < num_test; test++) {
+        array<bool, P::n> p;
+        for (bool &i : p) i = binary(engine) > 0;
+        Polynomial<P> pmu;
+        for (int i = 0; i < P::n; i++) pmu[i] = p[i] ? P::mu : -P::mu;
+        TRLWE<P> c = trlweSymEncrypt<P>(pmu, key);
+
+        start = chrono::system_clock::now();
+        trgswnttExternalProduct<P>(c, c, *trgswntt);
+        end = chrono::system_clock::now();
+        elapsed += chrono::duration_cast<chrono::microseconds>(end - start)
+                       .count();
+        array<bool, P::n> p2 = trlweSymDecrypt<P>(c, key);
+        for (int i = 0; i < P::n; i++) c_assert(p[i] == p2[i]);
+    }
+    cout << elapsed / num_test << "us" << endl;
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    lweKey key;
+
+    cout << "lvl1 exactness" << endl;
+    for (int test = 0; test < 3; test++) test_exact<lvl1param>(engine);
+    cout << "Passed" << endl;
+    cout << "lvl2 exactness" << endl;
+    for (int test = 0; test < 3; test++) test_exact<lvl2param>(engine);
+    cout << "Passed" << endl;
+
+    cout << "lvl1 test p=1" << endl;
+    test_decrypt<lvl1param>(engine, key.lvl1, 100);
+    cout << "Passed" << endl;
+    cout << "lvl2 test p=1" << endl;
+    test_decrypt<lvl2param>(engine, key.lvl2, 100);
+    cout << "Passed" << endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <tfhe++.hpp>
+
+// The blind rotation step with the rotation fused into the decomposition
+// against PolynomialMulByXaiMinusOne followed by the plain decomposition
+// and external product, single and batch, on lvl1 and lvl2: the results
+// must be identical. Then the time of rotating and decomposing both ways.
+
+using namespace std;
+using namespace TFHEpp;
+
+constexpr size_t batch = 8;
+
+template <class P>
+void Test(const Key<P> &key, default_random_engine &engine)
+{
+    uniform_int_distribution<typename P::T> coef(
+        0, numeric_limits<typename P::T>::max());
+    uniform_int_distribution<int> rot(0, 2 * P::n - 1);
+    uniform_int_distribution<int> binary(0, 1);
+
+    Polynomial<P> plain = {};
+    plain[0] = binary(engine);
+    const TRGSWFFT<P> trgswfft = trgswfftSymEncrypt<P>(plain, key);
+
+    const vector<int> edges = {0, 1, P::n - 1, P::n, P::n + 1, 2 * P::n - 1};
+    vector<int> as = edges;
+    for (int t = 0; t < 16; t++) as.push_back(rot(engine));
+    for (const int a : as) {
+        TRLWE<P> acc, temp, fused;
+        for (auto &poly : acc)
+            for (auto &c : poly) c = coef(engine);
+
+        DecomposedPolynomial<P> dec, decfused;
+        PolynomialMulByXaiMinusOne<P>(temp[0], acc[0], a);
+        Decomposition<P>(dec, temp[0]);
+        DecompositionMulByXaiMinusOne<P>(decfused, acc[0], a);
+        c_assert(dec == decfused);
+
+        for (int k = 0; k < P::k + 1; k++)
+            PolynomialMulByXaiMinusOne<P>(temp[k], acc[k], a);
+        trgswfftExternalProduct<P>(temp, temp, trgswfft);
+        trgswfftExternalProductMulByXaiMinusOne<P>(fused, acc, a, trgswfft);
+        c_assert(temp == fused);
+    }
+
+    TRLWEBatch<P> accbuf(batch), tempbuf(batch), fusedbuf(batch);
+    const TRLWEPlanes<P> acc = accbuf.planes(), temp = tempbuf.planes(),
+                         fused = fusedbuf.planes();
+    vector<int> a(batch);
+    for (size_t j = 0; j < batch; j++) {
+        a[j] = j < edges.size() ? edges[j] : rot(engine);
+        for (int k = 0; k < P::k + 1; k++) {
+            for (auto &c : acc[k][j]) c = coef(engine);
+            PolynomialMulByXaiMinusOne<P>(temp[k][j], acc[k][j], a[j]);
+        }
+    }
+    trgswfftExternalProductbatch<P>(temp, temp, trgswfft, batch);
+    trgswfftExternalProductMulByXaiMinusOnebatch<P>(fused, acc, a.data(),
+                                                    trgswfft, batch);
+    for (size_t j = 0; j < batch; j++)
+        for (int k = 0; k < P::k + 1; k++)
+            c_assert(temp[k][j] == fused[k][j]);
+
+    // Rotating and decomposing all components of one TRLWE, best of a few
+    // runs each.
+    constexpr int reps = 20000;
+    TRLWE<P> t;
+    DecomposedPolynomial<P> dec;
+    double twopass = numeric_limits<double>::max(), fusedtime = twopass;
+    for (int run = 0; run < 5; run++) {
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++)
+            for (int k = 0; k < P::k + 1; k++) {
+                PolynomialMulByXaiMinusOne<P>(t[k], acc[k][0], a[r % batch]);
+                Decomposition<P>(dec, t[k]);
+                acc[k][0][r % P::n] += dec[P::l - 1][r % P::n];
+            }
+        end = chrono::system_clock::now();
+        twopass = min<double>(
+            twopass,
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        start = chrono::system_clock::now();
+        for (int r = 0; r < reps; r++)
+            for (int k = 0; k < P::k + 1; k++) {
+                DecompositionMulByXaiMinusOne<P>(dec, acc[k][0], a[r % batch]);
+                acc[k][0][r % P::n] += dec[P::l - 1][r % P::n];
+            }
+        end = chrono::system_clock::now();
+        fusedtime = min<double>(
+            fusedtime,
+            chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+    }
+    cout << "n = " << P::n << ": rotate and decompose " << twopass / reps / 1000
+         << " us per TRLWE in two passes, " << fusedtime / reps / 1000
+         << " us fused" << endl;
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    lweKey key;
+    Test<lvl1param>(key.lvl1, engine);
+    Test<lvl2param>(key.lvl2, engine);
+    cout << "Passed" << endl;
+}
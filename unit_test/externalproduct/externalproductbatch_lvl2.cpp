@@ -0,0 +1,75 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <tfhe++.hpp>
+
+using namespace std;
+using namespace TFHEpp;
+
+// The lvl2 batch must give the same ciphertexts as the external product on
+// each polynomial; throughput of both is printed.
+constexpr int batch = 16;
+constexpr int num_test = 10;
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    lweKey key;
+
+    auto p = make_unique<BooleanArrayn<lvl2param::n, batch>>();
+    auto pmu = make_unique<Polynomialn<lvl2param, batch>>();
+    for (int j = 0; j < batch; j++)
+        for (int i = 0; i < lvl2param::n; i++) {
+            (*p)[j][i] = binary(engine) > 0;
+            (*pmu)[j][i] = (*p)[j][i] ? lvl2param::mu : -lvl2param::mu;
+        }
+    auto c = make_unique<TRLWEn<lvl2param, batch>>(
+        trlweSymEncryptbatch<lvl2param, batch>(*pmu, key.lvl2));
+
+    const Polynomial<lvl2param> plainpoly = {
+        static_cast<typename lvl2param::T>(1)};
+    auto trgswfft = make_unique<TRGSWFFT<lvl2param>>(
+        trgswfftSymEncrypt<lvl2param>(plainpoly, key.lvl2));
+
+    cout << "test p=1: lvl2 batch" << endl;
+    auto single = make_unique<TRLWEn<lvl2param, batch>>();
+    auto start = chrono::system_clock::now();
+    for (int test = 0; test < num_test; test++)
+        for (int j = 0; j < batch; j++) {
+            TRLWE<lvl2param> in, out;
+            for (int k = 0; k < lvl2param::k + 1; k++) in[k] = (*c)[k][j];
+            trgswfftExternalProduct<lvl2param>(out, in, *trgswfft);
+            for (int k = 0; k < lvl2param::k + 1; k++)
+                (*single)[k][j] = out[k];
+        }
+    auto end = chrono::system_clock::now();
+    const double elapsedsingle =
+        chrono::duration<double, milli>(end - start).count();
+
+    // The first call sets up the per-thread buffers of the batch pipeline.
+    auto res = make_unique<TRLWEn<lvl2param, batch>>();
+    trgswfftExternalProductbatch<lvl2param, batch>(*res, *c, *trgswfft);
+    start = chrono::system_clock::now();
+    for (int test = 0; test < num_test; test++)
+        trgswfftExternalProductbatch<lvl2param, batch>(*res, *c, *trgswfft);
+    end = chrono::system_clock::now();
+    const double elapsedbatch =
+        chrono::duration<double, milli>(end - start).count();
+
+    c_assert(*res == *single);
+    const BooleanArrayn<lvl2param::n, batch> p2 =
+        trlweSymDecryptbatch<lvl2param, batch>(*res, key.lvl2);
+    for (int j = 0; j < batch; j++)
+        for (int i = 0; i < lvl2param::n; i++) c_assert((*p)[j][i] == p2[j][i]);
+    cout << "Passed" << endl;
+
+    constexpr int products = num_test * batch;
+    cout << "single: " << elapsedsingle / products << "ms, "
+         << 1000 * products / elapsedsingle << " products/s" << endl;
+    cout << "batch of " << batch << ": " << elapsedbatch / products << "ms, "
+         << 1000 * products / elapsedbatch << " products/s" << endl;
+}
@@ -0,0 +1,106 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <fft_processor_simd.h>
+#include <tfhe++.hpp>
+
+// Exercises the FFT backend registry: every engine must give the same
+// spectrum, threads can pick different engines, and the cost of going
+// through the registry is measured against calling the engine directly.
+// Usage: fft_backend_test [num_test]
+
+using namespace TFHEpp;
+
+template <class F>
+double time_per_call(uint32_t num_test, F &&f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < num_test; i++) f();
+    auto finish = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::nano> elapsed = finish - start;
+    return elapsed.count() / num_test;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_test = 100000;
+    if (argc > 1) num_test = std::stoi(argv[1]);
+
+    std::cout << "default engine: " << CurrentFFTEngine().name << std::endl;
+    std::cout << "engines:";
+    for (const std::string &name : FFTEngineNames()) std::cout << " " << name;
+    std::cout << std::endl;
+    c_assert(!SelectFFTEngine("no such engine"));
+
+    std::mt19937 engine(0);
+    Polynomial<lvl1param> a, res;
+    for (auto &v : a) v = engine();
+    PolynomialInFD<lvl1param> ref, fd;
+    SelectThreadFFTEngine("simd");
+    TwistIFFT<lvl1param>(ref, a);
+
+    for (const std::string &name : FFTEngineNames()) {
+        c_assert(SelectThreadFFTEngine(name));
+        c_assert(CurrentFFTEngine().name == name);
+        TwistIFFT<lvl1param>(fd, a);
+        TwistFFT<lvl1param>(res, fd);
+        double max_diff = 0;
+        for (int i = 0; i < lvl1param::n; i++)
+            max_diff = std::max(max_diff, std::abs(fd[i] - ref[i]));
+        int32_t max_err = 0;
+        for (int i = 0; i < lvl1param::n; i++)
+            max_err = std::max(max_err, std::abs(int32_t(res[i] - a[i])));
+        std::cout << name << " FD difference to simd: " << max_diff
+                  << " round trip error: " << max_err << std::endl;
+        // The FPGA computes in single precision.
+        c_assert(max_err < (name == "fpga" ? 1 << 12 : 2));
+    }
+
+    // Each thread follows its own selection.
+    std::vector<std::string> names = FFTEngineNames();
+    std::vector<std::string> seen(names.size());
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < names.size(); t++)
+        workers.emplace_back([&, t] {
+            SelectThreadFFTEngine(names[t]);
+            PolynomialInFD<lvl1param> tfd;
+            TwistIFFT<lvl1param>(tfd, a);
+            seen[t] = CurrentFFTEngine().name;
+        });
+    for (std::thread &w : workers) w.join();
+    for (size_t t = 0; t < names.size(); t++) c_assert(seen[t] == names[t]);
+
+    // Registering a taken name once the engine is in use must leave the
+    // selected engine intact.
+    c_assert(SelectFFTEngine("simd"));
+    SelectThreadFFTEngine("simd");
+    const FFTEngine *selected = &CurrentFFTEngine();
+    c_assert(!RegisterFFTEngine("simd", selected->lvl1, selected->lvl2));
+    c_assert(&CurrentFFTEngine() == selected);
+    SelectThreadFFTEngine("");
+    c_assert(&CurrentFFTEngine() == selected);
+    TwistIFFT<lvl1param>(fd, a);
+    c_assert(fd == ref);
+
+    // Dispatch cost: registry lookup alone, and a full transform through
+    // the registry versus the engine called directly.
+    SelectThreadFFTEngine("simd");
+    volatile uintptr_t sink = 0;
+    const double lookup = time_per_call(num_test, [&] {
+        sink = sink + reinterpret_cast<uintptr_t>(&fftbackend<lvl1param>());
+    });
+    const double direct = time_per_call(
+        num_test, [&] { fftsimdlvl1.execute_reverse_torus32(fd.data(), a.data()); });
+    const double registry =
+        time_per_call(num_test, [&] { TwistIFFT<lvl1param>(fd, a); });
+    std::cout << "registry lookup: " << lookup << " ns" << std::endl;
+    std::cout << "simd TwistIFFT direct: " << direct
+              << " ns, through registry: " << registry << " ns, overhead: "
+              << 100 * (registry - direct) / direct << " %" << std::endl;
+
+    SelectThreadFFTEngine("");
+    std::cout << "Passed" << std::endl;
+    return 0;
+}
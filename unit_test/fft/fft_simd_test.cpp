@@ -0,0 +1,100 @@
+#include "fft_processor_fftw.h"
+#include "fft_processor_simd.h"
+#include "c_assert.hpp"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Checks the SIMD negacyclic FFT against FFT_Processor_FFTW and compares
+// their speed. Only the kernels of the compiled instruction set are
+// checked; fft_simd_test_avx2 and fft_simd_test_scalar are the same test
+// with the AVX2+FMA and scalar kernels. Usage: fft_simd_test [num_test]
+
+template <class T, class SIMD>
+void test_fft(const std::string &name, FFT_Processor_FFTW &fftp,
+              const SIMD &simd, uint32_t num_test)
+{
+    constexpr int N = SIMD::N;
+    std::mt19937_64 engine(N);
+    std::vector<T> a(N), res_fftw(N), res_simd(N);
+    std::vector<double> fd_fftw(N), fd_simd(N);
+    for (T &v : a) v = static_cast<T>(engine());
+
+    // Forward transform: same layout, same values up to rounding.
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        fftp.execute_reverse_torus32(fd_fftw.data(), a.data());
+        simd.execute_reverse_torus32(fd_simd.data(), a.data());
+    }
+    else {
+        fftp.execute_reverse_torus64(fd_fftw.data(), a.data());
+        simd.execute_reverse_torus64(fd_simd.data(), a.data());
+    }
+    double max_fd = 0, max_diff = 0;
+    for (int i = 0; i < N; i++) {
+        max_fd = std::max(max_fd, std::abs(fd_fftw[i]));
+        max_diff = std::max(max_diff, std::abs(fd_fftw[i] - fd_simd[i]));
+    }
+    std::cout << name << " max relative difference in FD: "
+              << max_diff / max_fd << std::endl;
+    c_assert(max_diff / max_fd < 1e-13);
+
+    // Inverse transform of the same spectrum.
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        fftp.execute_direct_torus32(res_fftw.data(), fd_fftw.data());
+        simd.execute_direct_torus32(res_simd.data(), fd_fftw.data());
+    }
+    else {
+        fftp.execute_direct_torus64(res_fftw.data(), fd_fftw.data());
+        simd.execute_direct_torus64(res_simd.data(), fd_fftw.data());
+    }
+    using S = std::make_signed_t<T>;
+    S max_err = 0;
+    for (int i = 0; i < N; i++)
+        max_err = std::max<S>(max_err, std::abs(static_cast<S>(res_simd[i] -
+                                                               res_fftw[i])));
+    std::cout << name << " max difference after inverse: " << max_err
+              << std::endl;
+    // lvl1 round trips up to truncation; lvl2 inputs use all 64 bits and
+    // the two engines round differently, about 2^-50 of the torus.
+    c_assert(max_err <= (std::is_same_v<T, uint32_t> ? 1 : S(1) << 20));
+
+    auto timeit = [num_test](auto &&f) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < num_test; i++) f();
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::micro> elapsed = finish - start;
+        return elapsed.count() / num_test;
+    };
+    double fftw_ifft, simd_ifft, fftw_fft, simd_fft;
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        fftw_ifft = timeit([&] { fftp.execute_reverse_torus32(fd_fftw.data(), a.data()); });
+        simd_ifft = timeit([&] { simd.execute_reverse_torus32(fd_simd.data(), a.data()); });
+        fftw_fft = timeit([&] { fftp.execute_direct_torus32(res_fftw.data(), fd_fftw.data()); });
+        simd_fft = timeit([&] { simd.execute_direct_torus32(res_simd.data(), fd_fftw.data()); });
+    }
+    else {
+        fftw_ifft = timeit([&] { fftp.execute_reverse_torus64(fd_fftw.data(), a.data()); });
+        simd_ifft = timeit([&] { simd.execute_reverse_torus64(fd_simd.data(), a.data()); });
+        fftw_fft = timeit([&] { fftp.execute_direct_torus64(res_fftw.data(), fd_fftw.data()); });
+        simd_fft = timeit([&] { simd.execute_direct_torus64(res_simd.data(), fd_fftw.data()); });
+    }
+    std::cout << name << " TwistIFFT fftw: " << fftw_ifft << " us simd: "
+              << simd_ifft << " us speedup: " << fftw_ifft / simd_ifft
+              << std::endl;
+    std::cout << name << " TwistFFT  fftw: " << fftw_fft << " us simd: "
+              << simd_fft << " us speedup: " << fftw_fft / simd_fft
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_test = 10000;
+    if (argc > 1) num_test = std::stoi(argv[1]);
+
+    std::cout << "SIMD kernels: " << fftsimd_isa() << std::endl;
+    test_fft<uint32_t>("lvl1", fftplvl1, fftsimdlvl1, num_test);
+    test_fft<uint64_t>("lvl2", fftplvl2, fftsimdlvl2, num_test);
+    std::cout << "Passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "fft_processor_fftw.h"
+#include "params.hpp"
+#include "c_assert.hpp"
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Runs the shared fftplvl1/fftplvl2 processors from several threads at once
+// and checks every result bit-for-bit against a single-threaded reference.
+
+constexpr int num_poly = 64;
+constexpr int num_round = 20;
+
+template <class T>
+struct FFTCase {
+    FFT_Processor_FFTW &fftp;
+    int N;
+    std::vector<T> in;
+    std::vector<double> ref_fft;
+    std::vector<T> ref_ifft;
+};
+
+void reverse(FFT_Processor_FFTW &fftp, double *res, const uint32_t *a)
+{
+    fftp.execute_reverse_torus32(res, a);
+}
+void reverse(FFT_Processor_FFTW &fftp, double *res, const uint64_t *a)
+{
+    fftp.execute_reverse_torus64(res, a);
+}
+void direct(FFT_Processor_FFTW &fftp, uint32_t *res, const double *a)
+{
+    fftp.execute_direct_torus32(res, a);
+}
+void direct(FFT_Processor_FFTW &fftp, uint64_t *res, const double *a)
+{
+    fftp.execute_direct_torus64(res, a);
+}
+
+template <class T>
+FFTCase<T> make_case(FFT_Processor_FFTW &fftp, int N)
+{
+    std::mt19937_64 engine(N);
+    FFTCase<T> c{fftp, N, std::vector<T>(num_poly * N),
+                 std::vector<double>(num_poly * N),
+                 std::vector<T>(num_poly * N)};
+    for (T &v : c.in) v = static_cast<T>(engine());
+    for (int p = 0; p < num_poly; p++) {
+        reverse(fftp, &c.ref_fft[p * N], &c.in[p * N]);
+        direct(fftp, &c.ref_ifft[p * N], &c.ref_fft[p * N]);
+    }
+    return c;
+}
+
+// Returns the number of polynomials whose transform differed from the
+// reference.
+template <class T>
+int run_case(const FFTCase<T> &c, int num_thread)
+{
+    std::vector<int> mismatch(num_thread, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_thread; t++)
+        workers.emplace_back([&c, &mismatch, t]() {
+            const int N = c.N;
+            std::vector<double> fft(N);
+            std::vector<T> ifft(N);
+            for (int r = 0; r < num_round; r++)
+                for (int p = t % num_poly; p < num_poly; p++) {
+                    reverse(c.fftp, fft.data(), &c.in[p * N]);
+                    direct(c.fftp, ifft.data(), fft.data());
+                    if (std::memcmp(fft.data(), &c.ref_fft[p * N],
+                                    N * sizeof(double)) ||
+                        std::memcmp(ifft.data(), &c.ref_ifft[p * N],
+                                    N * sizeof(T)))
+                        mismatch[t]++;
+                }
+        });
+    for (std::thread &w : workers) w.join();
+    int sum = 0;
+    for (int m : mismatch) sum += m;
+    return sum;
+}
+
+template <class T>
+void test_case(const std::string &name, const FFTCase<T> &c, int max_thread)
+{
+    for (int num_thread = 1; num_thread <= max_thread; num_thread *= 2) {
+        auto start = std::chrono::high_resolution_clock::now();
+        int mismatch = run_case(c, num_thread);
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = finish - start;
+        std::cout << name << " threads: " << num_thread
+                  << " elapsed: " << elapsed.count() << " ms"
+                  << " mismatches: " << mismatch << std::endl;
+        c_assert(mismatch == 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_thread = std::max(2u, std::thread::hardware_concurrency());
+    if (argc > 1) max_thread = std::stoi(argv[1]);
+
+    auto lvl1 = make_case<uint32_t>(fftplvl1, TFHEpp::lvl1param::n);
+    auto lvl2 = make_case<uint64_t>(fftplvl2, TFHEpp::lvl2param::n);
+    test_case("lvl1", lvl1, max_thread);
+    test_case("lvl2", lvl2, max_thread);
+    std::cout << "Passed" << std::endl;
+    return 0;
+}
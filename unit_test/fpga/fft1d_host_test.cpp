@@ -0,0 +1,120 @@
+#include "c_assert.hpp"
+#include "fftfpga.h"
+#include "fft_check.h"
+#include "standin/opencl_standin.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Runs the fftfpga host library against the OpenCL stand-in: results must
+// match a reference DFT for any batch size, queues, kernels and device
+// buffers must be created once for the largest batch instead of on every
+// call, and the channel workers must share the batches between them.
+// Usage: fft1d_host_test [num_test]
+
+using namespace std;
+
+constexpr unsigned N = 512;
+constexpr unsigned max_batch = 64;
+
+int main(int argc, char **argv)
+{
+    unsigned num_test = 1000;
+    if (argc > 1) num_test = stoi(argv[1]);
+    opencl_standin::Counters &cnt = opencl_standin::counters();
+
+    // The stand-in accepts any file as bitstream.
+    c_assert(fpga_initialize("Intel(R) FPGA SDK for OpenCL(TM)", argv[0],
+                             false) == 0);
+    c_assert(fftfpgaf_c2c_1d_reserve(N, max_batch));
+    // Four pipelines, each with two queues, two kernels and two buffers.
+    c_assert(cnt.queues_created == 8);
+    c_assert(cnt.kernels_created == 8);
+    c_assert(cnt.buffers_created == 8);
+
+    mt19937 engine(0);
+    uniform_real_distribution<float> dist(-1, 1);
+    vector<float2> in(N * max_batch), out(N * max_batch);
+    for (float2 &v : in) v = {dist(engine), dist(engine)};
+
+    for (bool inv : {false, true}) {
+        fftfpgaf_c2c_1d_(N, in.data(), out.data(), inv);
+        c_assert(check_transform(in, out, N, 0, inv) < 1e-5);
+
+        fpga_t t = fftfpgaf_c2c_1d(N, in.data(), out.data(), inv, max_batch);
+        c_assert(t.valid);
+        // The batch is spread over the channels in chunks.
+        for (unsigned b = 0; b < max_batch; b += max_batch / 4 - 1)
+            c_assert(check_transform(in, out, N, b, inv) < 1e-5);
+
+        // Batches that do not split evenly, down to fewer transforms than
+        // channels.
+        for (unsigned batch : {2u, 3u, 7u, 13u}) {
+            fill(out.begin(), out.end(), float2{0, 0});
+            c_assert(fftfpgaf_c2c_1d(N, in.data(), out.data(), inv, batch).valid);
+            for (unsigned b = 0; b < batch; b++)
+                c_assert(check_transform(in, out, N, b, inv) < 1e-5);
+            c_assert(out[batch * N].x == 0 && out[batch * N].y == 0);
+        }
+    }
+
+    // Steady state: per launch only two kernel arguments change.
+    fpga_channel_stats stats[4];
+    c_assert(fftfpgaf_channel_stats(stats, 4) == 4);
+    unsigned long long launches_before = 0;
+    for (const auto &s : stats) launches_before += s.launches;
+    fftfpgaf_reset_channel_stats();
+    const int args_before = cnt.kernel_args_set;
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < num_test; i++) {
+        fftfpgaf_c2c_1d_(N, in.data(), out.data(), i & 1);
+        fftfpgaf_c2c_1d(N, in.data(), out.data(), i & 1, 1 + i % max_batch);
+    }
+    auto finish = chrono::high_resolution_clock::now();
+    chrono::duration<double, milli> elapsed = finish - start;
+    c_assert(cnt.queues_created == 8);
+    c_assert(cnt.kernels_created == 8);
+    c_assert(cnt.buffers_created == 8);
+    c_assert(fftfpgaf_channel_stats(stats, 4) == 4);
+    unsigned long long launches = 0, transforms = 0;
+    for (const auto &s : stats) {
+        launches += s.launches;
+        transforms += s.transforms;
+    }
+    c_assert(launches_before > 0);
+    c_assert(cnt.kernel_args_set - args_before == int(2 * launches));
+    unsigned long long expected = 0;
+    for (unsigned i = 0; i < num_test; i++) expected += 2 + i % max_batch;
+    c_assert(transforms == expected);
+    c_assert(cnt.errors == 0);
+    cout << "Host time per fftfpgaf_c2c_1d_ + fftfpgaf_c2c_1d pair: "
+         << elapsed.count() / num_test << " ms" << endl;
+    for (unsigned c = 0; c < 4; c++)
+        cout << "channel " << c << ": " << stats[c].transforms
+             << " transforms in " << stats[c].launches << " launches, busy "
+             << stats[c].busy_t << " ms" << endl;
+
+    // A batch beyond the reservation grows the buffers and nothing else.
+    vector<float2> big_in(N * 2 * max_batch), big_out(N * 2 * max_batch);
+    for (float2 &v : big_in) v = {dist(engine), dist(engine)};
+    fftfpgaf_c2c_1d(N, big_in.data(), big_out.data(), false, 2 * max_batch);
+    c_assert(check_transform(big_in, big_out, N, 2 * max_batch - 1, false) < 1e-5);
+    c_assert(cnt.buffers_created > 8);
+    c_assert(cnt.buffers_created - cnt.buffers_released == 8);
+    c_assert(cnt.kernels_created == 8);
+
+    fpga_final();
+    c_assert(cnt.queues_released == cnt.queues_created);
+    c_assert(cnt.kernels_released == cnt.kernels_created);
+    c_assert(cnt.buffers_released == cnt.buffers_created);
+    c_assert(cnt.events_released == cnt.events_created);
+    c_assert(cnt.errors == 0);
+    cout << cnt.transforms << " transforms with " << cnt.buffers_created
+         << " buffers, " << cnt.kernels_created << " kernels and "
+         << cnt.queues_created << " queues" << endl;
+    cout << "Passed" << endl;
+    return 0;
+}
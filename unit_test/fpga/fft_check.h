@@ -0,0 +1,40 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+// Helpers shared by the FPGA tests and the OpenCL stand-in. The fft1d
+// bitstream writes its output in bit-reversed order.
+
+// x with its low bits bits in reverse order.
+inline unsigned bit_reverse(unsigned x, unsigned bits)
+{
+    unsigned y = 0;
+    for (unsigned i = 0; i < bits; i++, x >>= 1) y = (y << 1) | (x & 1);
+    return y;
+}
+
+// Largest error of transform b of out, N points in bit-reversed order,
+// against a reference DFT of the same transform of in, relative to the
+// largest coefficient. Complex is float2 of the library under test.
+template <class Complex>
+double check_transform(const std::vector<Complex> &in,
+                       const std::vector<Complex> &out, unsigned N,
+                       unsigned b, bool inv)
+{
+    const unsigned bits = std::log2(N);
+    const double sign = inv ? 1 : -1;
+    double max_err = 0, max_abs = 0;
+    for (unsigned k = 0; k < N; k++) {
+        std::complex<double> ref = 0;
+        for (unsigned j = 0; j < N; j++)
+            ref += std::complex<double>(in[b * N + j].x, in[b * N + j].y) *
+                   std::polar(1.0, sign * 2 * M_PI * ((j * k) % N) / N);
+        const Complex res = out[b * N + bit_reverse(k, bits)];
+        max_err = std::max(max_err,
+                           std::abs(ref - std::complex<double>(res.x, res.y)));
+        max_abs = std::max(max_abs, std::abs(ref));
+    }
+    return max_err / max_abs;
+}
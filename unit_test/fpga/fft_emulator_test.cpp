@@ -0,0 +1,90 @@
+#include "c_assert.hpp"
+#include "fftfpga_emu.h"
+#include "fft_check.h"
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Checks the CPU emulator of the FPGA: unnormalised single precision DFTs
+// in bit-reversed order like the fft1d bitstream, fpga_t filled in from the
+// timing model, and channel counters as with the four-channel device.
+// Built with -DUSE_FPGA=ON -DUSE_FPGA_EMULATOR=ON, where every other FPGA
+// test and the batched gates run on the emulator as well.
+
+using namespace std;
+
+constexpr unsigned N = 512;
+
+double total(const fpga_t &t) { return t.pcie_write_t + t.exec_t + t.pcie_read_t; }
+
+int main(int argc, char **argv)
+{
+    c_assert(fpga_initialize("Intel(R) FPGA SDK for OpenCL(TM)", argv[0], false) == 0);
+    c_assert(fftfpgaf_c2c_1d_reserve(N, 64));
+    c_assert(!fftfpgaf_c2c_1d_reserve(N + 1, 64));
+
+    mt19937 engine(0);
+    uniform_real_distribution<float> dist(-1, 1);
+    vector<float2> in(N * 64), out(N * 64);
+    for (float2 &v : in) v = {dist(engine), dist(engine)};
+
+    for (bool inv : {false, true}) {
+        c_assert(fftfpgaf_c2c_1d_(N, in.data(), out.data(), inv).valid);
+        c_assert(check_transform(in, out, N, 0, inv) < 1e-5);
+        for (unsigned batch : {3u, 64u}) {
+            c_assert(fftfpgaf_c2c_1d(N, in.data(), out.data(), inv, batch).valid);
+            for (unsigned b = 0; b < batch; b += 2)
+                c_assert(check_transform(in, out, N, b, inv) < 1e-5);
+        }
+    }
+
+    // Timing model: one transform is a launch on one channel.
+    fpga_emu_config config = fpga_emu_get_config();
+    config.pcie_bandwidth = 4;      // 4 GB/s
+    config.pcie_latency = 10;       // 10 us
+    config.kernel_clock = 256;      // 256 MHz
+    config.points_per_cycle = 8;
+    config.launch_overhead = 30;    // 30 us
+    config.channels = 4;
+    config.realtime = false;
+    c_assert(fpga_emu_set_config(&config));
+    fpga_emu_config invalid = config;
+    invalid.channels = 5;
+    c_assert(!fpga_emu_set_config(&invalid));
+
+    fpga_t t = fftfpgaf_c2c_1d_(N, in.data(), out.data(), false);
+    const double transfer = 10e-3 + 8.0 * N / 4e6;
+    c_assert(abs(t.pcie_write_t - transfer) < 1e-9);
+    c_assert(abs(t.pcie_read_t - transfer) < 1e-9);
+    c_assert(abs(t.exec_t - (30e-3 + N / 8 / 256e3)) < 1e-9);
+
+    // A batch of 64 is cut into 8 chunks of 8, two per channel.
+    fftfpgaf_reset_channel_stats();
+    t = fftfpgaf_c2c_1d(N, in.data(), out.data(), false, 64);
+    c_assert(abs(t.exec_t - 2 * (30e-3 + 8.0 * N / 8 / 256e3)) < 1e-9);
+    fpga_channel_stats stats[4];
+    c_assert(fftfpgaf_channel_stats(stats, 4) == 4);
+    for (const auto &s : stats) {
+        c_assert(s.transforms == 16 && s.launches == 2);
+        c_assert(abs(s.busy_t - total(t)) < 1e-9);
+    }
+    cout << "Modelled batch of 64: write " << t.pcie_write_t << " ms, exec "
+         << t.exec_t << " ms, read " << t.pcie_read_t << " ms" << endl;
+
+    // In real time the call does not return before the modelled time.
+    config.realtime = true;
+    c_assert(fpga_emu_set_config(&config));
+    auto start = chrono::steady_clock::now();
+    t = fftfpgaf_c2c_1d(N, in.data(), out.data(), true, 64);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    c_assert(elapsed.count() >= total(t));
+    c_assert(check_transform(in, out, N, 63, true) < 1e-5);
+
+    fpga_final();
+    c_assert(!fftfpgaf_c2c_1d_(N, in.data(), out.data(), false).valid);
+    cout << "Passed" << endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <complex>
+#include <cstring>
+#include <fftpipeline.hpp>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Drives FFTOffloadPipeline with a stand-in device that only waits for a
+// configurable latency (the PCIe transfers plus the kernel) and copies its
+// input. Checks that results come back in order through every buffer set
+// and measures how much host twisting overlaps with the device.
+// Usage: fft_pipeline_test [latency_us] [num_batches]
+
+using namespace TFHEpp;
+
+constexpr unsigned Ns2 = 512;
+constexpr unsigned batch = 64;
+
+struct LatencyDevice {
+    std::chrono::microseconds latency;
+
+    fpga_t operator()(unsigned num, const float2 *inp, float2 *out, bool,
+                      unsigned batch) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::memcpy(out, inp, sizeof(float2) * num * batch);
+        std::this_thread::sleep_until(start + latency);
+        fpga_t t{};
+        t.exec_t = latency.count() * 1e-3;
+        t.valid = true;
+        return t;
+    }
+};
+
+// Host work of the size FFT_Processor_FPGA does around each transform.
+void twist(float2 *inbuf, const std::vector<uint32_t> &a,
+           const std::vector<std::complex<double>> &tw)
+{
+    for (unsigned j = 0; j < batch; j++)
+        for (unsigned i = 0; i < Ns2; i++) {
+            auto t = tw[i] * std::complex<double>(int32_t(a[j * 2 * Ns2 + i]),
+                                                  int32_t(a[j * 2 * Ns2 + Ns2 + i]));
+            inbuf[j * Ns2 + i] = {float(t.real()), float(t.imag())};
+        }
+}
+
+void untwist(std::vector<double> &res, const float2 *outbuf,
+             const std::vector<std::complex<double>> &tw)
+{
+    for (unsigned j = 0; j < batch; j++)
+        for (unsigned i = 0; i < Ns2; i++) {
+            auto t = std::complex<double>(outbuf[j * Ns2 + i].x,
+                                          outbuf[j * Ns2 + i].y) *
+                     std::conj(tw[i]);
+            res[j * 2 * Ns2 + i] = t.real();
+            res[j * 2 * Ns2 + Ns2 + i] = t.imag();
+        }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned latency_us = 500;
+    unsigned num_batches = 200;
+    if (argc > 1) latency_us = std::stoi(argv[1]);
+    if (argc > 2) num_batches = std::stoi(argv[2]);
+
+    std::vector<std::complex<double>> tw(Ns2);
+    for (unsigned i = 0; i < Ns2; i++) tw[i] = std::polar(1.0, M_PI * i / (2 * Ns2));
+    std::mt19937 engine(0);
+    std::vector<std::vector<uint32_t>> in(num_batches,
+                                          std::vector<uint32_t>(2 * Ns2 * batch));
+    for (auto &a : in)
+        for (uint32_t &v : a) v = engine() >> 8;
+    std::vector<std::vector<double>> out(num_batches,
+                                         std::vector<double>(2 * Ns2 * batch));
+
+    const LatencyDevice device{std::chrono::microseconds(latency_us)};
+
+    // Every batch goes through the device unchanged, so it has to come back
+    // as the input up to float rounding, whichever buffer set it used.
+    auto check = [&] {
+        for (unsigned b = 0; b < num_batches; b++)
+            for (unsigned i = 0; i < 2 * Ns2 * batch; i++)
+                c_assert(std::abs(out[b][i] - int32_t(in[b][i])) <=
+                         std::abs(int32_t(in[b][i])) * 1e-6 + 1);
+    };
+
+    auto run = [&](unsigned depth, bool overlap) {
+        for (auto &o : out) std::fill(o.begin(), o.end(), 0);
+        FFTOffloadPipeline pipeline(Ns2, batch, device, depth);
+        auto start = std::chrono::high_resolution_clock::now();
+        FFTTicket last = 0;
+        for (unsigned b = 0; b < num_batches; b++) {
+            last = pipeline.submit(
+                false, batch, [&](float2 *inbuf) { twist(inbuf, in[b], tw); },
+                [&, b](const float2 *outbuf) { untwist(out[b], outbuf, tw); });
+            c_assert(last == b + 1);
+            if (!overlap) pipeline.wait(last);
+        }
+        pipeline.wait(last);
+        auto finish = std::chrono::high_resolution_clock::now();
+        check();
+        std::chrono::duration<double, std::milli> elapsed = finish - start;
+        return elapsed.count() / num_batches;
+    };
+
+    // Tickets complete in order and only up to the one waited for.
+    {
+        for (auto &o : out) std::fill(o.begin(), o.end(), 0);
+        FFTOffloadPipeline pipeline(Ns2, batch, device, 2);
+        std::vector<bool> done(4, false);
+        std::vector<FFTTicket> tickets;
+        for (unsigned b = 0; b < 4; b++)
+            tickets.push_back(pipeline.submit(
+                false, batch, [&](float2 *inbuf) { twist(inbuf, in[b], tw); },
+                [&, b](const float2 *) { done[b] = true; }));
+        // Submitting the third and fourth batch needed the first two sets.
+        c_assert(done[0] && done[1] && !done[2] && !done[3]);
+        pipeline.wait(tickets[2]);
+        c_assert(done[2] && !done[3]);
+        pipeline.wait(0);
+        pipeline.wait_all();
+        c_assert(done[3]);
+    }
+
+    const double sync = run(2, false);
+    std::cout << "device latency " << latency_us << " us, " << batch
+              << " transforms of " << 2 * Ns2 << " per batch" << std::endl;
+    std::cout << "submit + wait per batch: " << sync << " ms" << std::endl;
+    for (unsigned depth : {2, 3, 4}) {
+        const double async = run(depth, true);
+        std::cout << depth << " buffer sets in flight:  " << async
+                  << " ms, speedup " << sync / async << std::endl;
+        c_assert(async < sync);
+    }
+    std::cout << "Passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "c_assert.hpp"
+#include "fft_check.h"
+#include "fpga_twist.h"
+#include <chrono>
+#include <complex>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// FPGATwist reads the bit-reversed device output through a permutation
+// table. Its results must be bit-identical to reordering the output first
+// and untwisting it afterwards, as fpga_fft used to do.
+// Usage: fpga_twist_test [num_test]
+
+using namespace std;
+
+constexpr int32_t N = 1024;
+constexpr int32_t Ns2 = N / 2;
+constexpr unsigned batch = 8;
+
+void correct_data_order(float2 *fpgaOut, const unsigned num, const unsigned batch)
+{
+    vector<float2> tmp(num * batch);
+    const unsigned log_dim = log2(num);
+    for (unsigned j = 0; j < batch; j++)
+        for (unsigned i = 0; i < num; i++)
+            tmp[j * num + i] = fpgaOut[j * num + bit_reverse(i, log_dim)];
+    memcpy(fpgaOut, tmp.data(), sizeof(float2) * num * batch);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned num_test = 1000;
+    if (argc > 1) num_test = stoi(argv[1]);
+
+    vector<complex<double>> twist;
+    for (int i = 0; i < Ns2; i++) {
+        double value = (double)i * M_PI / (double)N;
+        twist.push_back(complex<double>(cos(value), sin(value)));
+    }
+    const FPGATwist tables(Ns2);
+
+    mt19937 engine(0);
+    uniform_real_distribution<float> dist(-1e9, 1e9);
+    vector<int32_t> a(N * batch);
+    vector<float2> out(Ns2 * batch), ordered(Ns2 * batch);
+    vector<float2> inbuf(Ns2), inbuf_ref(Ns2);
+    vector<double> res(N * batch), res_ref(N * batch);
+
+    for (unsigned t = 0; t < 10; t++) {
+        for (int32_t &v : a) v = engine();
+        for (float2 &v : out) v = {dist(engine), dist(engine)};
+
+        for (unsigned j = 0; j < batch; j++) {
+            const int32_t *aj = &a[j * N];
+            for (int i = 0; i < Ns2; i++) {
+                auto tmp = twist[i] * complex((double)aj[i], (double)aj[Ns2 + i]);
+                inbuf_ref[i].x = tmp.real();
+                inbuf_ref[i].y = tmp.imag();
+            }
+            tables.twist_in(inbuf.data(), [aj](int32_t i, double &re, double &im) {
+                re = aj[i];
+                im = aj[Ns2 + i];
+            });
+            c_assert(memcmp(inbuf.data(), inbuf_ref.data(), sizeof(float2) * Ns2) == 0);
+        }
+
+        ordered = out;
+        correct_data_order(ordered.data(), Ns2, batch);
+
+        // Forward transform: plain reordering.
+        for (unsigned j = 0; j < batch; j++) {
+            for (int i = 0; i < Ns2; i++) {
+                res_ref[j * N + i] = ordered[j * Ns2 + i].x;
+                res_ref[j * N + i + Ns2] = ordered[j * Ns2 + i].y;
+            }
+            double *resj = &res[j * N];
+            tables.reorder_out(&out[j * Ns2], [resj](int32_t i, double re, double im) {
+                resj[i] = re;
+                resj[i + Ns2] = im;
+            });
+        }
+        c_assert(memcmp(res.data(), res_ref.data(), sizeof(double) * N * batch) == 0);
+
+        // Inverse transform: reordering and untwisting.
+        for (unsigned j = 0; j < batch; j++) {
+            for (int i = 0; i < Ns2; i++) {
+                auto res_tmp = complex<double>(ordered[j * Ns2 + i].x,
+                                               ordered[j * Ns2 + i].y) *
+                               conj(twist[i]);
+                res_ref[j * N + i] = res_tmp.real();
+                res_ref[j * N + i + Ns2] = res_tmp.imag();
+            }
+            double *resj = &res[j * N];
+            tables.untwist_out(&out[j * Ns2], [resj](int32_t i, double re, double im) {
+                resj[i] = re;
+                resj[i + Ns2] = im;
+            });
+        }
+        c_assert(memcmp(res.data(), res_ref.data(), sizeof(double) * N * batch) == 0);
+    }
+
+    // Host time of the untwist with and without the separate reordering.
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned t = 0; t < num_test; t++) {
+        ordered = out;
+        correct_data_order(ordered.data(), Ns2, batch);
+        for (unsigned j = 0; j < batch; j++)
+            for (int i = 0; i < Ns2; i++) {
+                auto res_tmp = complex<double>(ordered[j * Ns2 + i].x,
+                                               ordered[j * Ns2 + i].y) *
+                               conj(twist[i]);
+                res_ref[j * N + i] = res_tmp.real();
+                res_ref[j * N + i + Ns2] = res_tmp.imag();
+            }
+    }
+    auto finish = chrono::high_resolution_clock::now();
+    chrono::duration<double, micro> separate = finish - start;
+
+    start = chrono::high_resolution_clock::now();
+    for (unsigned t = 0; t < num_test; t++)
+        for (unsigned j = 0; j < batch; j++) {
+            double *resj = &res[j * N];
+            tables.untwist_out(&out[j * Ns2], [resj](int32_t i, double re, double im) {
+                resj[i] = re;
+                resj[i + Ns2] = im;
+            });
+        }
+    finish = chrono::high_resolution_clock::now();
+    chrono::duration<double, micro> fused = finish - start;
+    c_assert(memcmp(res.data(), res_ref.data(), sizeof(double) * N * batch) == 0);
+
+    cout << "Untwist of " << batch << " transforms of " << N << ": "
+         << separate.count() / num_test << " us with correct_data_order, "
+         << fused.count() / num_test << " us with the permutation table" << endl;
+    cout << "Passed" << endl;
+    return 0;
+}
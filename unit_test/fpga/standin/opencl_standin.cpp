@@ -0,0 +1,379 @@
+#include "opencl_standin.h"
+#include "../fft_check.h"
+
+#include <CL/opencl.h>
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using opencl_standin::counters;
+
+struct _cl_platform_id {};
+struct _cl_device_id {};
+struct _cl_context {};
+struct _cl_command_queue {};
+
+struct _cl_mem {
+    std::vector<std::complex<float>> data;
+};
+
+struct _cl_kernel {
+    cl_program program;
+    std::string name;
+    std::string pipeline;  // "", "_2", "_3" or "_4"
+    bool fetch;
+    cl_mem buffer = nullptr;
+    cl_int batch = 0;
+    cl_int inverse = 0;
+};
+
+struct _cl_event {
+    cl_ulong start = 0, end = 0;
+};
+
+// An fft1d task waiting for the fetch kernel of the same pipeline to feed
+// it; the pair is matched up in their program.
+struct PendingFFT {
+    _cl_kernel args;
+    cl_event event;
+};
+
+struct _cl_program {
+    std::mutex mtx;
+    std::map<std::string, PendingFFT> pending;
+};
+
+namespace opencl_standin {
+Counters &counters()
+{
+    static Counters c;
+    return c;
+}
+}  // namespace opencl_standin
+
+namespace {
+
+_cl_platform_id the_platform;
+_cl_device_id the_device;
+const char platform_name[] = "Intel(R) FPGA SDK for OpenCL(TM) (software stand-in)";
+
+cl_ulong now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+cl_event new_event(cl_event *event)
+{
+    if (event == nullptr) return nullptr;
+    counters().events_created++;
+    *event = new _cl_event;
+    (*event)->start = (*event)->end = now_ns();
+    return *event;
+}
+
+// What the bitstream computes: unnormalised DFTs, exp(-2 pi i jk / N)
+// forward and exp(+2 pi i jk / N) backward, written in bit-reversed order.
+void batched_fft(const std::complex<float> *in, std::complex<float> *out,
+                 unsigned N, unsigned batch, bool inverse)
+{
+    unsigned bits = 0;
+    while ((1u << bits) < N) bits++;
+    const double sign = inverse ? 1 : -1;
+    std::vector<std::complex<double>> a(N);
+    for (unsigned b = 0; b < batch; b++) {
+        for (unsigned i = 0; i < N; i++)
+            a[bit_reverse(i, bits)] = std::complex<double>(in[b * N + i]);
+        for (unsigned len = 2; len <= N; len <<= 1) {
+            const double ang = sign * 2 * M_PI / len;
+            for (unsigned i = 0; i < N; i += len)
+                for (unsigned j = 0; j < len / 2; j++) {
+                    const std::complex<double> w(std::cos(ang * j),
+                                                 std::sin(ang * j));
+                    const std::complex<double> u = a[i + j];
+                    const std::complex<double> v = a[i + j + len / 2] * w;
+                    a[i + j] = u + v;
+                    a[i + j + len / 2] = u - v;
+                }
+        }
+        for (unsigned k = 0; k < N; k++)
+            out[b * N + bit_reverse(k, bits)] = std::complex<float>(a[k]);
+    }
+}
+
+bool copy_fits(cl_mem buffer, size_t offset, size_t size)
+{
+    return buffer != nullptr &&
+           offset + size <= buffer->data.size() * sizeof(std::complex<float>);
+}
+
+}  // namespace
+
+extern "C" {
+
+cl_int clGetPlatformIDs(cl_uint num_entries, cl_platform_id *platforms,
+                        cl_uint *num_platforms)
+{
+    if (num_platforms) *num_platforms = 1;
+    if (platforms && num_entries > 0) platforms[0] = &the_platform;
+    return CL_SUCCESS;
+}
+
+cl_int clGetPlatformInfo(cl_platform_id, cl_platform_info param_name,
+                         size_t param_value_size, void *param_value,
+                         size_t *param_value_size_ret)
+{
+    if (param_name != CL_PLATFORM_NAME) return CL_INVALID_VALUE;
+    if (param_value_size_ret) *param_value_size_ret = sizeof(platform_name);
+    if (param_value) {
+        if (param_value_size < sizeof(platform_name)) return CL_INVALID_VALUE;
+        std::memcpy(param_value, platform_name, sizeof(platform_name));
+    }
+    return CL_SUCCESS;
+}
+
+cl_int clGetDeviceIDs(cl_platform_id, cl_device_type, cl_uint num_entries,
+                      cl_device_id *devices, cl_uint *num_devices)
+{
+    if (num_devices) *num_devices = 1;
+    if (devices && num_entries > 0) devices[0] = &the_device;
+    return CL_SUCCESS;
+}
+
+cl_int clGetDeviceInfo(cl_device_id, cl_device_info, size_t param_value_size,
+                       void *param_value, size_t *param_value_size_ret)
+{
+    // No SVM support.
+    if (param_value) std::memset(param_value, 0, param_value_size);
+    if (param_value_size_ret) *param_value_size_ret = param_value_size;
+    return CL_SUCCESS;
+}
+
+cl_context clCreateContext(const cl_context_properties *, cl_uint,
+                           const cl_device_id *,
+                           void(CL_CALLBACK *)(const char *, const void *,
+                                               size_t, void *),
+                           void *, cl_int *errcode_ret)
+{
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return new _cl_context;
+}
+
+cl_int clReleaseContext(cl_context context)
+{
+    delete context;
+    return CL_SUCCESS;
+}
+
+cl_program clCreateProgramWithBinary(cl_context, cl_uint num_devices,
+                                     const cl_device_id *, const size_t *,
+                                     const unsigned char **,
+                                     cl_int *binary_status,
+                                     cl_int *errcode_ret)
+{
+    for (cl_uint i = 0; binary_status && i < num_devices; i++)
+        binary_status[i] = CL_SUCCESS;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return new _cl_program;
+}
+
+cl_int clBuildProgram(cl_program, cl_uint, const cl_device_id *, const char *,
+                      void(CL_CALLBACK *)(cl_program, void *), void *)
+{
+    return CL_SUCCESS;
+}
+
+cl_int clReleaseProgram(cl_program program)
+{
+    delete program;
+    return CL_SUCCESS;
+}
+
+cl_command_queue clCreateCommandQueue(cl_context, cl_device_id,
+                                      cl_command_queue_properties,
+                                      cl_int *errcode_ret)
+{
+    counters().queues_created++;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    return new _cl_command_queue;
+}
+
+cl_int clReleaseCommandQueue(cl_command_queue queue)
+{
+    counters().queues_released++;
+    delete queue;
+    return CL_SUCCESS;
+}
+
+cl_mem clCreateBuffer(cl_context, cl_mem_flags, size_t size, void *,
+                      cl_int *errcode_ret)
+{
+    counters().buffers_created++;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    cl_mem buffer = new _cl_mem;
+    buffer->data.resize(size / sizeof(std::complex<float>));
+    return buffer;
+}
+
+cl_int clReleaseMemObject(cl_mem buffer)
+{
+    counters().buffers_released++;
+    delete buffer;
+    return CL_SUCCESS;
+}
+
+cl_kernel clCreateKernel(cl_program program, const char *kernel_name,
+                         cl_int *errcode_ret)
+{
+    const std::string name = kernel_name;
+    const bool fetch = name.rfind("fetch", 0) == 0;
+    const bool fft = name.rfind("fft1d", 0) == 0;
+    const std::string pipeline = fetch || fft ? name.substr(5) : name;
+    if ((!fetch && !fft) ||
+        !(pipeline.empty() || pipeline == "_2" || pipeline == "_3" ||
+          pipeline == "_4")) {
+        if (errcode_ret) *errcode_ret = CL_INVALID_KERNEL_NAME;
+        return nullptr;
+    }
+    counters().kernels_created++;
+    if (errcode_ret) *errcode_ret = CL_SUCCESS;
+    cl_kernel kernel = new _cl_kernel;
+    kernel->program = program;
+    kernel->name = name;
+    kernel->pipeline = pipeline;
+    kernel->fetch = fetch;
+    return kernel;
+}
+
+cl_int clReleaseKernel(cl_kernel kernel)
+{
+    counters().kernels_released++;
+    delete kernel;
+    return CL_SUCCESS;
+}
+
+cl_int clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size,
+                      const void *arg_value)
+{
+    counters().kernel_args_set++;
+    if (arg_index == 0 && arg_size == sizeof(cl_mem))
+        kernel->buffer = *static_cast<const cl_mem *>(arg_value);
+    else if (!kernel->fetch && arg_index == 1 && arg_size == sizeof(cl_int))
+        kernel->batch = *static_cast<const cl_int *>(arg_value);
+    else if (!kernel->fetch && arg_index == 2 && arg_size == sizeof(cl_int))
+        kernel->inverse = *static_cast<const cl_int *>(arg_value);
+    else {
+        counters().errors++;
+        return CL_INVALID_VALUE;
+    }
+    return CL_SUCCESS;
+}
+
+cl_int clEnqueueWriteBuffer(cl_command_queue, cl_mem buffer, cl_bool,
+                            size_t offset, size_t size, const void *ptr,
+                            cl_uint, const cl_event *, cl_event *event)
+{
+    if (!copy_fits(buffer, offset, size)) {
+        counters().errors++;
+        return CL_INVALID_VALUE;
+    }
+    std::memcpy(reinterpret_cast<char *>(buffer->data.data()) + offset, ptr,
+                size);
+    new_event(event);
+    return CL_SUCCESS;
+}
+
+cl_int clEnqueueReadBuffer(cl_command_queue, cl_mem buffer, cl_bool,
+                           size_t offset, size_t size, void *ptr, cl_uint,
+                           const cl_event *, cl_event *event)
+{
+    if (!copy_fits(buffer, offset, size)) {
+        counters().errors++;
+        return CL_INVALID_VALUE;
+    }
+    std::memcpy(ptr, reinterpret_cast<const char *>(buffer->data.data()) + offset,
+                size);
+    new_event(event);
+    return CL_SUCCESS;
+}
+
+cl_int clEnqueueTask(cl_command_queue, cl_kernel kernel, cl_uint,
+                     const cl_event *, cl_event *event)
+{
+    if (kernel->fetch) {
+        counters().errors++;
+        return CL_INVALID_VALUE;
+    }
+    cl_program program = kernel->program;
+    std::lock_guard<std::mutex> lock(program->mtx);
+    program->pending[kernel->pipeline] = PendingFFT{*kernel, new_event(event)};
+    return CL_SUCCESS;
+}
+
+cl_int clEnqueueNDRangeKernel(cl_command_queue, cl_kernel kernel,
+                              cl_uint work_dim, const size_t *,
+                              const size_t *global_work_size,
+                              const size_t *local_work_size, cl_uint,
+                              const cl_event *, cl_event *event)
+{
+    cl_program program = kernel->program;
+    PendingFFT fft;
+    {
+        std::lock_guard<std::mutex> lock(program->mtx);
+        auto it = program->pending.find(kernel->pipeline);
+        if (!kernel->fetch || work_dim != 1 || it == program->pending.end()) {
+            counters().errors++;
+            return CL_INVALID_VALUE;
+        }
+        fft = it->second;
+        program->pending.erase(it);
+    }
+
+    // The fetch kernel streams N/8 points per work item and one work group
+    // per transform; its geometry has to agree with the fft1d batch.
+    const size_t N = 8 * local_work_size[0];
+    const size_t batch = global_work_size[0] / local_work_size[0];
+    if (batch != size_t(fft.args.batch) || kernel->buffer == nullptr ||
+        fft.args.buffer == nullptr || kernel->buffer->data.size() < N * batch ||
+        fft.args.buffer->data.size() < N * batch) {
+        counters().errors++;
+        return CL_INVALID_VALUE;
+    }
+
+    cl_event started = new_event(event);
+    batched_fft(kernel->buffer->data.data(), fft.args.buffer->data.data(), N,
+                batch, fft.args.inverse != 0);
+    counters().transforms += batch;
+    if (fft.event) fft.event->end = now_ns();
+    if (started) started->end = now_ns();
+    return CL_SUCCESS;
+}
+
+cl_int clFinish(cl_command_queue) { return CL_SUCCESS; }
+
+cl_int clGetEventProfilingInfo(cl_event event, cl_profiling_info param_name,
+                               size_t param_value_size, void *param_value,
+                               size_t *)
+{
+    if (param_value_size != sizeof(cl_ulong)) return CL_INVALID_VALUE;
+    cl_ulong t = param_name == CL_PROFILING_COMMAND_START ? event->start
+                                                          : event->end;
+    std::memcpy(param_value, &t, sizeof(t));
+    return CL_SUCCESS;
+}
+
+cl_int clReleaseEvent(cl_event event)
+{
+    counters().events_released++;
+    delete event;
+    return CL_SUCCESS;
+}
+
+}  // extern "C"
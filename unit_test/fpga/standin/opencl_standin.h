@@ -0,0 +1,25 @@
+#pragma once
+#include <atomic>
+
+// Software stand-in for the OpenCL runtime, used to test the fftfpga host
+// library without a board. It implements the entry points the library calls
+// and plays the role of the fft1d bitstream: a "fetch" kernel launched after
+// its "fft1d" task runs the batched FFT on the CPU, with the output in
+// bit-reversed order like the hardware. Every object created or released
+// is counted so that tests can check what the host code does per call.
+namespace opencl_standin {
+
+struct Counters {
+    std::atomic<int> buffers_created{0}, buffers_released{0};
+    std::atomic<int> kernels_created{0}, kernels_released{0};
+    std::atomic<int> queues_created{0}, queues_released{0};
+    std::atomic<int> events_created{0}, events_released{0};
+    std::atomic<int> kernel_args_set{0};
+    std::atomic<int> transforms{0};
+    // Launches the real device would reject or that would produce garbage.
+    std::atomic<int> errors{0};
+};
+
+Counters &counters();
+
+}  // namespace opencl_standin
@@ -0,0 +1,122 @@
+#include <tfhe++.hpp>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+using namespace TFHEpp;
+using namespace std;
+
+// Every two-input batch gate against its truth table, HomMUXbatch and
+// HomNMUXbatch on lvl1 and lvl0, and the throughput of AND and MUX one at a
+// time against batched.
+
+constexpr size_t batch = 16;
+
+using BatchGate = void (*)(TLWE<lvl1param> *, const TLWE<lvl1param> *,
+                           const TLWE<lvl1param> *, size_t, const EvalKey &);
+
+template <class P>
+void TestMUX(const SecretKey &sk, const EvalKey &ek,
+             default_random_engine &engine)
+{
+    uniform_int_distribution<uint32_t> binary(0, 1);
+    vector<uint8_t> ps(batch), p1(batch), p0(batch);
+    for (size_t j = 0; j < batch; j++) {
+        ps[j] = binary(engine);
+        p1[j] = binary(engine);
+        p0[j] = binary(engine);
+    }
+    vector<TLWE<P>> cs = bootsSymEncrypt<P>(ps, sk);
+    vector<TLWE<P>> c1 = bootsSymEncrypt<P>(p1, sk);
+    vector<TLWE<P>> c0 = bootsSymEncrypt<P>(p0, sk);
+    vector<TLWE<P>> cres(batch);
+
+    HomMUXbatch<P>(cres.data(), cs.data(), c1.data(), c0.data(), batch, ek);
+    vector<uint8_t> pres = bootsSymDecrypt<P>(cres, sk);
+    for (size_t j = 0; j < batch; j++)
+        c_assert(pres[j] == (ps[j] ? p1[j] : p0[j]));
+
+    HomNMUXbatch<P>(cs.data(), cs.data(), c1.data(), c0.data(), batch, ek);
+    pres = bootsSymDecrypt<P>(cs, sk);
+    for (size_t j = 0; j < batch; j++)
+        c_assert(pres[j] == !(ps[j] ? p1[j] : p0[j]));
+}
+
+int main()
+{
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    const vector<tuple<string, BatchGate, function<bool(bool, bool)>>> gates =
+        {{"NAND", static_cast<BatchGate>(HomNANDbatch<>),
+          [](bool a, bool b) { return !(a & b); }},
+         {"AND", static_cast<BatchGate>(HomANDbatch<>),
+          [](bool a, bool b) { return a & b; }},
+         {"OR", static_cast<BatchGate>(HomORbatch<>),
+          [](bool a, bool b) { return a | b; }},
+         {"NOR", static_cast<BatchGate>(HomNORbatch<>),
+          [](bool a, bool b) { return !(a | b); }},
+         {"XOR", static_cast<BatchGate>(HomXORbatch<>),
+          [](bool a, bool b) { return a ^ b; }},
+         {"XNOR", static_cast<BatchGate>(HomXNORbatch<>),
+          [](bool a, bool b) { return !(a ^ b); }},
+         {"ANDNY", static_cast<BatchGate>(HomANDNYbatch<>),
+          [](bool a, bool b) { return !a & b; }},
+         {"ANDYN", static_cast<BatchGate>(HomANDYNbatch<>),
+          [](bool a, bool b) { return a & !b; }},
+         {"ORNY", static_cast<BatchGate>(HomORNYbatch<>),
+          [](bool a, bool b) { return !a | b; }},
+         {"ORYN", static_cast<BatchGate>(HomORYNbatch<>),
+          [](bool a, bool b) { return a | !b; }}};
+
+    vector<uint8_t> pa(batch), pb(batch);
+    for (size_t j = 0; j < batch; j++) pa[j] = binary(engine);
+    for (size_t j = 0; j < batch; j++) pb[j] = binary(engine);
+    vector<TLWE<lvl1param>> ca = bootsSymEncrypt(pa, *sk);
+    vector<TLWE<lvl1param>> cb = bootsSymEncrypt(pb, *sk);
+    vector<TLWE<lvl1param>> cres(batch);
+    for (const auto &[name, gate, truth] : gates) {
+        gate(cres.data(), ca.data(), cb.data(), batch, ek);
+        vector<uint8_t> pres = bootsSymDecrypt(cres, *sk);
+        for (size_t j = 0; j < batch; j++)
+            c_assert(pres[j] == truth(pa[j], pb[j]));
+        cout << name << " passed" << endl;
+    }
+
+    TestMUX<lvl1param>(*sk, ek, engine);
+    TestMUX<lvl0param>(*sk, ek, engine);
+    cout << "MUX and NMUX passed" << endl;
+
+    chrono::system_clock::time_point start, end;
+    HomAND(cres[0], ca[0], cb[0], ek);
+    start = chrono::system_clock::now();
+    for (size_t j = 0; j < batch; j++) HomAND(cres[j], ca[j], cb[j], ek);
+    end = chrono::system_clock::now();
+    cout << "AND: " << batch / chrono::duration<double>(end - start).count()
+         << " gates/s one at a time, ";
+    start = chrono::system_clock::now();
+    HomANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+    end = chrono::system_clock::now();
+    cout << batch / chrono::duration<double>(end - start).count()
+         << " gates/s batched" << endl;
+
+    start = chrono::system_clock::now();
+    for (size_t j = 0; j < batch; j++)
+        HomMUX(cres[j], ca[j], cb[j], cb[j], ek);
+    end = chrono::system_clock::now();
+    cout << "MUX: " << batch / chrono::duration<double>(end - start).count()
+         << " gates/s one at a time, ";
+    start = chrono::system_clock::now();
+    HomMUXbatch(cres.data(), ca.data(), cb.data(), cb.data(), batch, ek);
+    end = chrono::system_clock::now();
+    cout << batch / chrono::duration<double>(end - start).count()
+         << " gates/s batched" << endl;
+    cout << "Passed" << endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+#include <string>
+#include <sstream>
+
+// HomNANDbatch with the batch size known only at run time, on ciphertexts
+// held in std::vector. The int batch template is a wrapper around the same
+// code, so both are timed at the same size: their gates/s should agree.
+
+using namespace std;
+using namespace TFHEpp;
+
+constexpr int batch = 16;
+
+double gates_per_second(chrono::system_clock::time_point start,
+                        chrono::system_clock::time_point end, size_t gates)
+{
+    double elapsed =
+        chrono::duration_cast<chrono::microseconds>(end - start).count();
+    return gates / elapsed * 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t num_test = 37;
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> num_test;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    for (size_t count : {size_t{1}, size_t{7}, num_test}) {
+        vector<uint8_t> pa(count), pb(count);
+        for (size_t j = 0; j < count; j++) pa[j] = binary(engine) > 0;
+        for (size_t j = 0; j < count; j++) pb[j] = binary(engine) > 0;
+        vector<TLWE<lvl1param>> ca = bootsSymEncrypt(pa, *sk);
+        vector<TLWE<lvl1param>> cb = bootsSymEncrypt(pb, *sk);
+        vector<TLWE<lvl1param>> cres(count);
+
+        HomNANDbatch(cres.data(), ca.data(), cb.data(), count, ek);
+        vector<uint8_t> pres = bootsSymDecrypt(cres, *sk);
+        for (size_t j = 0; j < count; j++)
+            c_assert(pres[j] == !(pa[j] & pb[j]));
+
+        // In place, as the gates of a circuit are chained.
+        HomNANDbatch(ca.data(), ca.data(), cb.data(), count, ek);
+        pres = bootsSymDecrypt(ca, *sk);
+        for (size_t j = 0; j < count; j++)
+            c_assert(pres[j] == !(pa[j] & pb[j]));
+        cout << "batch " << count << " passed" << endl;
+    }
+
+    vector<uint8_t> pa(batch), pb(batch);
+    for (int j = 0; j < batch; j++) pa[j] = binary(engine) > 0;
+    for (int j = 0; j < batch; j++) pb[j] = binary(engine) > 0;
+    vector<TLWE<lvl1param>> va = bootsSymEncrypt(pa, *sk);
+    vector<TLWE<lvl1param>> vb = bootsSymEncrypt(pb, *sk);
+    vector<TLWE<lvl1param>> vres(batch);
+    auto ca = make_unique<TLWEn<lvl1param, batch>>();
+    auto cb = make_unique<TLWEn<lvl1param, batch>>();
+    auto cres = make_unique<TLWEn<lvl1param, batch>>();
+    copy(va.begin(), va.end(), ca->begin());
+    copy(vb.begin(), vb.end(), cb->begin());
+
+    chrono::system_clock::time_point start, end;
+    start = chrono::system_clock::now();
+    HomNANDbatch<lvl10param, lvl01param, lvl1param::mu, batch>(*cres, *ca, *cb,
+                                                               ek);
+    end = chrono::system_clock::now();
+    const double fixed = gates_per_second(start, end, batch);
+
+    start = chrono::system_clock::now();
+    HomNANDbatch(vres.data(), va.data(), vb.data(), batch, ek);
+    end = chrono::system_clock::now();
+    const double dynamic = gates_per_second(start, end, batch);
+
+    for (int j = 0; j < batch; j++) c_assert(vres[j] == (*cres)[j]);
+    cout << "batch " << batch << ": template " << fixed
+         << " gates/s, runtime count " << dynamic << " gates/s" << endl;
+    cout << "Passed" << endl;
+}
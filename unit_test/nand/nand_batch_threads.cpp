@@ -0,0 +1,78 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+#include <string>
+#include <sstream>
+#include <thread>
+
+// HomNANDbatch throughput with the lanes split over 1 to N threads, N
+// being the number of hardware threads unless given as second argument.
+// The first argument is the batch size.
+
+using namespace std;
+using namespace TFHEpp;
+
+int main(int argc, char* argv[])
+{
+    size_t batch = 64;
+    size_t max_threads = max(1u, thread::hardware_concurrency());
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> batch;
+    }
+    if (argc > 2) {
+        std::stringstream str_stream(argv[2]);
+        str_stream >> max_threads;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    vector<uint8_t> pa(batch), pb(batch);
+    for (size_t j = 0; j < batch; j++) pa[j] = binary(engine) > 0;
+    for (size_t j = 0; j < batch; j++) pb[j] = binary(engine) > 0;
+    vector<TLWE<lvl1param>> ca = bootsSymEncrypt(pa, *sk);
+    vector<TLWE<lvl1param>> cb = bootsSymEncrypt(pb, *sk);
+    vector<TLWE<lvl1param>> cres(batch), cref(batch);
+
+    SetBatchThreads(1);
+    HomNANDbatch(cref.data(), ca.data(), cb.data(), batch, ek);
+
+    cout << "batch: " << batch << endl;
+    cout << setw(8) << "threads" << setw(12) << "gates/s" << setw(10)
+         << "speedup" << endl;
+    double base = 0;
+    for (size_t threads = 1; threads <= max_threads; threads++) {
+        SetBatchThreads(threads);
+        // The first call sizes the workspaces of new workers.
+        HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+        chrono::system_clock::time_point start, end;
+        start = chrono::system_clock::now();
+        HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+        end = chrono::system_clock::now();
+        double elapsed =
+            chrono::duration_cast<chrono::microseconds>(end - start).count();
+
+        // Lanes are independent: the split does not change the result.
+        for (size_t j = 0; j < batch; j++) c_assert(cres[j] == cref[j]);
+        vector<uint8_t> pres = bootsSymDecrypt(cres, *sk);
+        for (size_t j = 0; j < batch; j++)
+            c_assert(pres[j] == !(pa[j] & pb[j]));
+
+        const double rate = batch / elapsed * 1e6;
+        if (threads == 1) base = rate;
+        cout << setw(8) << threads << setw(12) << rate << setw(10)
+             << rate / base << endl;
+    }
+    SetBatchThreads(0);
+    cout << "Passed" << endl;
+}
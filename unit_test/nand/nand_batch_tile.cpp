@@ -0,0 +1,77 @@
+#include "c_assert.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <tfhe++.hpp>
+#include <string>
+#include <sstream>
+
+// HomNANDbatch throughput against the tile size of BlindRotatebatch, for a
+// sweep of batch sizes. "auto" is the tile picked from the L2 size. The
+// bootstrapping key is read once per tile, so the key traffic per gate is
+// its size divided by the tile.
+
+using namespace std;
+using namespace TFHEpp;
+
+int main(int argc, char* argv[])
+{
+    size_t max_batch = 256;
+    if (argc > 1) {
+        std::stringstream str_stream(argv[1]);
+        str_stream >> max_batch;
+    }
+
+    random_device seed_gen;
+    default_random_engine engine(seed_gen());
+    uniform_int_distribution<uint32_t> binary(0, 1);
+
+    SecretKey* sk = new SecretKey();
+    TFHEpp::EvalKey ek;
+    ek.emplacebkfft<TFHEpp::lvl01param>(*sk);
+    ek.emplaceiksk<TFHEpp::lvl10param>(*sk);
+
+    constexpr double bkbytes = sizeof(BootstrappingKeyFFT<lvl01param>);
+    cout << "L2: " << L2CacheSize() / 1024 << " KiB, bootstrapping key: "
+         << bkbytes / (1 << 20) << " MiB" << endl;
+    cout << setw(6) << "batch" << setw(8) << "tile" << setw(12) << "gates/s"
+         << setw(16) << "BK MiB/gate" << endl;
+
+    for (size_t batch = 16; batch <= max_batch; batch *= 4) {
+        vector<uint8_t> pa(batch), pb(batch);
+        for (size_t j = 0; j < batch; j++) pa[j] = binary(engine) > 0;
+        for (size_t j = 0; j < batch; j++) pb[j] = binary(engine) > 0;
+        vector<TLWE<lvl1param>> ca = bootsSymEncrypt(pa, *sk);
+        vector<TLWE<lvl1param>> cb = bootsSymEncrypt(pb, *sk);
+        vector<TLWE<lvl1param>> cres(batch);
+
+        // Grows the workspaces to the largest tile before timing.
+        SetBlindRotateTile(batch);
+        HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+
+        vector<size_t> tiles = {0};
+        for (size_t tile = 1; tile <= batch; tile *= 2) tiles.push_back(tile);
+        for (size_t tile : tiles) {
+            SetBlindRotateTile(tile);
+            const size_t used = BlindRotateTile<lvl01param>(batch);
+            chrono::system_clock::time_point start, end;
+            start = chrono::system_clock::now();
+            HomNANDbatch(cres.data(), ca.data(), cb.data(), batch, ek);
+            end = chrono::system_clock::now();
+            double elapsed =
+                chrono::duration_cast<chrono::microseconds>(end - start)
+                    .count();
+
+            vector<uint8_t> pres = bootsSymDecrypt(cres, *sk);
+            for (size_t j = 0; j < batch; j++)
+                c_assert(pres[j] == !(pa[j] & pb[j]));
+            cout << setw(6) << batch << setw(8)
+                 << (tile ? to_string(used) : "auto " + to_string(used))
+                 << setw(12) << batch / elapsed * 1e6 << setw(16)
+                 << bkbytes / used / (1 << 20) << endl;
+        }
+    }
+    SetBlindRotateTile(0);
+    cout << "Passed" << endl;
+}